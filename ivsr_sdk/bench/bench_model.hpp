@@ -0,0 +1,146 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file bench_model.hpp
+ * models generated in code for the benchmarks, so no licensed IR or custom extension is needed.
+ */
+
+#ifndef IVSR_BENCH_MODEL_HPP
+#define IVSR_BENCH_MODEL_HPP
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "openvino/openvino.hpp"
+#include "openvino/opsets/opset8.hpp"
+
+/**
+ * @brief model serialized to a temporary IR which is removed with the object,
+ * the SDK only loads models from files.
+ */
+class SyntheticModel {
+public:
+    explicit SyntheticModel(const std::shared_ptr<ov::Model>& model) {
+        char dir[] = "/tmp/ivsr_bench_XXXXXX";
+        if (!mkdtemp(dir))
+            throw std::runtime_error("failed to create a temporary directory");
+        dir_ = dir;
+        xml_ = dir_ + "/model.xml";
+        bin_ = dir_ + "/model.bin";
+        ov::serialize(model, xml_, bin_);
+    }
+
+    ~SyntheticModel() {
+        unlink(xml_.c_str());
+        unlink(bin_.c_str());
+        rmdir(dir_.c_str());
+    }
+
+    SyntheticModel(const SyntheticModel&) = delete;
+    SyntheticModel& operator=(const SyntheticModel&) = delete;
+
+    const std::string& path() const {
+        return xml_;
+    }
+
+private:
+    std::string dir_;
+    std::string xml_;
+    std::string bin_;
+};
+
+/**
+ * @brief Parameter -> Relu -> Result, the cheapest model to exercise the SDK plumbing.
+ */
+inline std::shared_ptr<ov::Model> make_relu_model(const ov::Shape& shape) {
+    auto input = std::make_shared<ov::opset8::Parameter>(ov::element::f32, ov::PartialShape(shape));
+    auto relu = std::make_shared<ov::opset8::Relu>(input->output(0));
+    auto result = std::make_shared<ov::opset8::Result>(relu->output(0));
+    return std::make_shared<ov::Model>(ov::ResultVector{result}, ov::ParameterVector{input});
+}
+
+namespace bench_detail {
+
+// deterministic weights in [-0.1, 0.1], the values do not matter for timing
+inline std::shared_ptr<ov::opset8::Constant> conv_weights(size_t out, size_t in, size_t kernel, uint32_t seed) {
+    std::vector<float> weights(out * in * kernel * kernel);
+    for (auto& w : weights) {
+        seed = seed * 1664525u + 1013904223u;
+        w = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24) * 0.2f - 0.1f;
+    }
+    return std::make_shared<ov::opset8::Constant>(ov::element::f32, ov::Shape{out, in, kernel, kernel}, weights);
+}
+
+inline ov::Output<ov::Node> conv3x3(const ov::Output<ov::Node>& input, size_t in, size_t out, uint32_t seed) {
+    auto conv = std::make_shared<ov::opset8::Convolution>(input,
+                                                          conv_weights(out, in, 3, seed)->output(0),
+                                                          ov::Strides{1, 1},
+                                                          ov::CoordinateDiff{1, 1},
+                                                          ov::CoordinateDiff{1, 1},
+                                                          ov::Strides{1, 1});
+    return conv->output(0);
+}
+
+inline ov::Output<ov::Node> reshape(const ov::Output<ov::Node>& input, const std::vector<int64_t>& shape) {
+    auto target = std::make_shared<ov::opset8::Constant>(ov::element::i64, ov::Shape{shape.size()}, shape);
+    return std::make_shared<ov::opset8::Reshape>(input, target->output(0), false)->output(0);
+}
+
+}  // namespace bench_detail
+
+/**
+ * @brief tiny super-resolution network: [conv3x3(3->features) -> relu] -> conv3x3(->3*scale*scale) -> depth-to-space.
+ * frames == 0 generates a 4D NCHW model, otherwise a 5D NFCHW model with frames input frames,
+ * features == 0 drops the hidden layer.
+ */
+inline std::shared_ptr<ov::Model> make_sr_model(size_t width,
+                                                size_t height,
+                                                size_t scale,
+                                                size_t frames,
+                                                size_t features) {
+    using namespace bench_detail;
+    const size_t channels = 3;
+    const size_t batch = frames ? frames : 1;
+    ov::Shape shape = frames ? ov::Shape{1, frames, channels, height, width} : ov::Shape{1, channels, height, width};
+
+    auto input = std::make_shared<ov::opset8::Parameter>(ov::element::f32, ov::PartialShape(shape));
+    ov::Output<ov::Node> x = input->output(0);
+    // frames are folded into the batch, the convolutions are per frame
+    if (frames)
+        x = reshape(x, {static_cast<int64_t>(batch), static_cast<int64_t>(channels), static_cast<int64_t>(height),
+                        static_cast<int64_t>(width)});
+
+    size_t in = channels;
+    if (features) {
+        x = std::make_shared<ov::opset8::Relu>(conv3x3(x, in, features, 1))->output(0);
+        in = features;
+    }
+    x = conv3x3(x, in, channels * scale * scale, 2);
+    x = std::make_shared<ov::opset8::DepthToSpace>(x, ov::opset8::DepthToSpace::DepthToSpaceMode::DEPTH_FIRST, scale)
+            ->output(0);
+
+    if (frames)
+        x = reshape(x, {1, static_cast<int64_t>(frames), static_cast<int64_t>(channels),
+                        static_cast<int64_t>(height * scale), static_cast<int64_t>(width * scale)});
+    auto result = std::make_shared<ov::opset8::Result>(x);
+    return std::make_shared<ov::Model>(ov::ResultVector{result}, ov::ParameterVector{input});
+}
+
+#endif  // IVSR_BENCH_MODEL_HPP
@@ -0,0 +1,501 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_bench.cpp
+ * micro-benchmarks of the SDK hot paths on synthetic buffers,
+ * engine benchmarks use a tiny generated model on CPU, so no real model or accelerator is needed.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "InferTask.hpp"
+#include "bench_model.hpp"
+#include "ivsr.h"
+#include "ivsr_cpu_isa.hpp"
+#include "ivsr_smart_patch.hpp"
+#include "ivsr_strip_patch.hpp"
+#include "ov_engine.hpp"
+#include "threading/ivsr_thread_executor.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+const Resolution kResolutions[] = {{"540p", 960, 540}, {"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+
+// patch size of the SDK samples, every resolution above is split into at least 2x2 patches
+const int kPatchHeight = 400;
+const int kPatchWidth = 700;
+const int kChannels = 3;
+
+struct BenchOptions {
+    std::string filter;
+    double minTimeMs = 500.0;
+};
+
+BenchOptions g_options;
+
+bool selected(const std::string& name) {
+    return g_options.filter.empty() || name.find(g_options.filter) != std::string::npos;
+}
+
+// run op once to warm caches and page in buffers, then repeatedly for at least minTimeMs
+double measure_ns_per_op(const std::function<void()>& op, size_t opsPerCall = 1) {
+    op();
+    size_t calls = 0;
+    auto start = Time::now();
+    double elapsedNs = 0.0;
+    do {
+        op();
+        ++calls;
+        elapsedNs = std::chrono::duration_cast<ns>(Time::now() - start).count();
+    } while (elapsedNs < g_options.minTimeMs * 1e6);
+    return elapsedNs / (calls * opsPerCall);
+}
+
+void report(const std::string& name, const std::string& size, double nsPerOp, double bytesPerOp = 0.0) {
+    std::cout << std::left << std::setw(28) << name << std::setw(10) << size << std::right << std::setw(16)
+              << std::fixed << std::setprecision(1) << nsPerOp;
+    if (bytesPerOp > 0.0)
+        std::cout << std::setw(12) << std::setprecision(2) << bytesPerOp / nsPerOp;  // bytes per ns == GB/s
+    else
+        std::cout << std::setw(12) << "-";
+    std::cout << std::endl;
+}
+
+std::vector<float> synthetic_buffer(size_t size) {
+    std::vector<float> buf(size);
+    for (size_t i = 0; i < size; ++i)
+        buf[i] = static_cast<float>(i % 251) / 251.0f;
+    return buf;
+}
+
+int blocks(int size, int patch) {
+    return static_cast<int>(std::ceil(size * 1.0 / patch));
+}
+
+// calculatePatchCoordinateList + fill_patch of one 1x1x3xHxW frame, as in SmartPatch::generatePatch()
+void bench_patch_split(const Resolution& res) {
+    std::vector<int> dims = {1, 1, kChannels, res.height, res.width};
+    int patchSize[] = {kPatchHeight, kPatchWidth};
+    int blockSize[] = {blocks(res.height, kPatchHeight), blocks(res.width, kPatchWidth)};
+    size_t patchElems = static_cast<size_t>(kChannels) * kPatchHeight * kPatchWidth;
+    size_t numPatches = static_cast<size_t>(blockSize[0]) * blockSize[1];
+
+    auto input = synthetic_buffer(static_cast<size_t>(kChannels) * res.height * res.width);
+    std::vector<float> patches(patchElems * numPatches);
+
+    double nsPerOp = measure_ns_per_op([&] {
+        auto coords = calculatePatchCoordinateList(res.height, res.width, patchSize, blockSize);
+        float* patchBuf = patches.data();
+        for (auto& corners : coords)
+            patchBuf = fill_patch(corners, input.data(), dims, patchBuf);
+    });
+    // every patch element is read once and written once
+    report("patch_split", res.name, nsPerOp, 2.0 * sizeof(float) * patchElems * numPatches);
+}
+
+// fill_image of one 1x1x3xHxW frame from overlapping patches, as in SmartPatch::restoreImageFromPatches()
+void bench_patch_merge(const Resolution& res) {
+    std::vector<int> imgDims = {1, 1, kChannels, res.height, res.width};
+    std::vector<int> patchDims = {1, 1, kChannels, kPatchHeight, kPatchWidth};
+    int patchSize[] = {kPatchHeight, kPatchWidth};
+    int blockSize[] = {blocks(res.height, kPatchHeight), blocks(res.width, kPatchWidth)};
+    size_t patchElems = static_cast<size_t>(kChannels) * kPatchHeight * kPatchWidth;
+    size_t imageElems = static_cast<size_t>(kChannels) * res.height * res.width;
+    auto coords = calculatePatchCoordinateList(res.height, res.width, patchSize, blockSize);
+
+    auto patches = synthetic_buffer(patchElems * coords.size());
+    std::vector<char*> patchList;
+    for (size_t i = 0; i < coords.size(); ++i)
+        patchList.push_back(reinterpret_cast<char*>(patches.data() + i * patchElems));
+    std::vector<float> image(imageElems);
+
+    double nsPerOp = measure_ns_per_op([&] {
+        // fill_image accumulates into the output
+        std::memset(image.data(), 0, imageElems * sizeof(float));
+        fill_image(coords, reinterpret_cast<char*>(image.data()), patchDims, imgDims, patchList);
+    });
+    // patches are read once, the image is written once
+    report("patch_merge", res.name, nsPerOp, sizeof(float) * (patchElems * coords.size() + imageElems));
+}
+
+// split and merge of one 1x1x3xHxW frame a row of patches at a time, as in PATCH_MODE strip.
+// Compare with patch_split + patch_merge, the staging is two rows of patches instead of the frame.
+void bench_patch_strip(const Resolution& res) {
+    PatchConfig config;
+    config.patchHeight = kPatchHeight;
+    config.patchWidth = kPatchWidth;
+    config.scale = 1;
+    config.nif = 1;
+    config.channels = kChannels;
+    StripPatch strips(config, res.height, res.width);
+    size_t patchElems = static_cast<size_t>(kChannels) * kPatchHeight * kPatchWidth;
+    size_t numPatches = static_cast<size_t>(strips.rows()) * strips.columns();
+    size_t imageElems = static_cast<size_t>(kChannels) * res.height * res.width;
+
+    auto input = synthetic_buffer(imageElems);
+    std::vector<float> image(imageElems);
+
+    double nsPerOp = measure_ns_per_op([&] {
+        for (int row = 0; row < strips.rows(); ++row) {
+            strips.split(row, reinterpret_cast<const char*>(input.data()));
+            // the input patches stand in for the inferred ones, the copy is included in the time
+            for (int column = 0; column < strips.columns(); ++column)
+                std::memcpy(strips.outputPatch(row, column), strips.inputPatch(row, column), patchElems * sizeof(float));
+            strips.merge(row, reinterpret_cast<char*>(image.data()));
+        }
+    });
+    // as patch_split and patch_merge together
+    report("patch_strip", res.name, nsPerOp, sizeof(float) * (3 * patchElems * numPatches + imageElems));
+}
+
+// the FFmpeg plugin before ivsr_convert: copy to a temporary buffer, transpose, then scale in another pass
+void legacy_nhwc_u8_to_nchw_f32(const uint8_t* src, float* dst, int channels, int height, int width, float scale) {
+    const size_t size = static_cast<size_t>(channels) * height * width;
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = src[i] / 255.0f;
+    std::vector<float> temp(dst, dst + size);
+    for (int h = 0; h < height; ++h)
+        for (int w = 0; w < width; ++w)
+            for (int c = 0; c < channels; ++c)
+                dst[(static_cast<size_t>(c) * height + h) * width + w] = temp[(static_cast<size_t>(h) * width + w) * channels + c];
+    for (size_t i = 0; i < size; ++i)
+        dst[i] *= scale;
+}
+
+void legacy_nchw_f32_to_nhwc_u8(float* src, uint8_t* dst, int channels, int height, int width, float scale) {
+    const size_t size = static_cast<size_t>(channels) * height * width;
+    std::vector<float> temp(src, src + size);
+    for (int h = 0; h < height; ++h)
+        for (int w = 0; w < width; ++w)
+            for (int c = 0; c < channels; ++c)
+                src[(static_cast<size_t>(h) * width + w) * channels + c] = temp[(static_cast<size_t>(c) * height + h) * width + w];
+    for (size_t i = 0; i < size; ++i)
+        src[i] /= scale;
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = static_cast<uint8_t>(std::min(255L, std::max(0L, lrintf(src[i] * 255.0f))));
+}
+
+// frame <-> model tensor conversion of the FFmpeg plugin, multi-pass legacy code against one ivsr_convert call
+void bench_convert(const Resolution& res) {
+    const size_t size = static_cast<size_t>(kChannels) * res.height * res.width;
+    const float normalize = 255.0f;
+    std::vector<uint8_t> frame(size);
+    for (size_t i = 0; i < size; ++i)
+        frame[i] = static_cast<uint8_t>(i % 251);
+    std::vector<float> tensor(size);
+    // one thread for both, the legacy code parallelizes only some of its passes
+    ivsr_image_t packed = {frame.data(), IVSR_SAMPLE_U8, IVSR_LAYOUT_NHWC, 1, kChannels, res.height, res.width, 0, 0};
+    ivsr_image_t planar = {tensor.data(), IVSR_SAMPLE_F32, IVSR_LAYOUT_NCHW, 1, kChannels, res.height, res.width, 0, 0};
+    ivsr_convert_param_t toModel = {normalize / 255.0f, 0.0f, 0.0f, 0, 1};
+    ivsr_convert_param_t toFrame = {255.0f / normalize, 0.0f, 0.0f, 0, 1};
+    // every sample is read once and written once
+    const double bytes = size * (sizeof(uint8_t) + sizeof(float));
+
+    report("convert_in/legacy", res.name, measure_ns_per_op([&] {
+               legacy_nhwc_u8_to_nchw_f32(frame.data(), tensor.data(), kChannels, res.height, res.width, normalize);
+           }), bytes);
+    report("convert_in/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&packed, &planar, &toModel);
+           }), bytes);
+    report("convert_out/legacy", res.name, measure_ns_per_op([&] {
+               legacy_nchw_f32_to_nhwc_u8(tensor.data(), frame.data(), kChannels, res.height, res.width, normalize);
+           }), bytes);
+    report("convert_out/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&planar, &packed, &toFrame);
+           }), bytes);
+}
+
+// FFmpeg swscale wrappers of high bit depth samples, followed by the separate normalize pass of the plugin
+void legacy_uint_y_to_float_y(const uint16_t* src, float* dst, size_t size, float maxValue, float normalize) {
+    const float normFactor = 1.0f / maxValue;
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = static_cast<float>(src[i]) * normFactor;
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = dst[i] * normalize;
+}
+
+void legacy_float_y_to_uint_y(float* src, uint16_t* dst, size_t size, int maxValue, float normalize, int lo, int hi) {
+    for (size_t i = 0; i < size; ++i)
+        src[i] = src[i] / normalize;
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = static_cast<uint16_t>(std::min(static_cast<long>(maxValue), std::max(0L, lrintf(maxValue * src[i]))));
+    // TV range clamp of the Y plane
+    for (size_t i = 0; i < size; ++i)
+        dst[i] = static_cast<uint16_t>(std::min(hi, std::max(lo, static_cast<int>(dst[i]))));
+}
+
+// packed 16-bit RGB to GBRP16, as converted by swscale before the Y wrapper
+void legacy_rgb48_to_planar(const uint16_t* src, uint16_t* dst, int height, int width) {
+    const size_t plane = static_cast<size_t>(height) * width;
+    for (size_t i = 0; i < plane; ++i)
+        for (int c = 0; c < kChannels; ++c)
+            dst[c * plane + i] = src[i * kChannels + c];
+}
+
+template <typename T>
+void check_identical(const char* name, const std::vector<T>& legacy, const std::vector<T>& fused) {
+    if (memcmp(legacy.data(), fused.data(), legacy.size() * sizeof(T)) != 0)
+        std::cerr << name << ": fused output differs from legacy output" << std::endl;
+}
+
+// 10-bit Y planes and 16-bit RGB frames <-> normalized model tensors, the fused results must be bit-identical
+void bench_convert_hbd(const Resolution& res) {
+    const size_t plane = static_cast<size_t>(res.height) * res.width;
+    const float normalize = 255.0f;
+    std::vector<uint16_t> y10(plane), rgb48(plane * kChannels);
+    for (size_t i = 0; i < plane; ++i)
+        y10[i] = static_cast<uint16_t>(i % 1021);
+    for (size_t i = 0; i < rgb48.size(); ++i)
+        rgb48[i] = static_cast<uint16_t>(i * 257 % 65521);
+    std::vector<float> legacyTensor(plane * kChannels), tensor(plane * kChannels);
+    std::vector<uint16_t> legacyFrame(plane * kChannels), frame(plane * kChannels);
+
+    ivsr_image_t yPlane = {y10.data(), IVSR_SAMPLE_U16, IVSR_LAYOUT_NHWC, 1, 1, res.height, res.width, 0, 0, 10, 0};
+    ivsr_image_t yTensor = {tensor.data(), IVSR_SAMPLE_F32, IVSR_LAYOUT_NCHW, 1, 1, res.height, res.width, 0, 0, 0, 0};
+    ivsr_image_t yOut = {frame.data(), IVSR_SAMPLE_U16, IVSR_LAYOUT_NHWC, 1, 1, res.height, res.width, 0, 0, 10, 0};
+    ivsr_image_t packed = {rgb48.data(), IVSR_SAMPLE_U16, IVSR_LAYOUT_NHWC, 1, kChannels, res.height, res.width,
+                           0, 0, 0, 0};
+    ivsr_image_t planar = {tensor.data(), IVSR_SAMPLE_F32, IVSR_LAYOUT_NCHW, 1, kChannels, res.height, res.width,
+                           0, 0, 0, 0};
+    // the same roundings as the legacy passes
+    ivsr_convert_param_t y10ToModel = {1.0f / 1023.0f, 0.0f, 0.0f, 0, 1, 0.0f, normalize};
+    ivsr_convert_param_t modelToY10 = {1.0f, 64.0f, 940.0f, 0, 1, normalize, 1023.0f};
+    ivsr_convert_param_t rgb48ToModel = {1.0f / 65535.0f, 0.0f, 0.0f, 0, 1, 0.0f, normalize};
+
+    const double yBytes = plane * (sizeof(uint16_t) + sizeof(float));
+    report("convert_in_y10/legacy", res.name, measure_ns_per_op([&] {
+               legacy_uint_y_to_float_y(y10.data(), legacyTensor.data(), plane, 1023.0f, normalize);
+           }), yBytes);
+    report("convert_in_y10/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&yPlane, &yTensor, &y10ToModel);
+           }), yBytes);
+    legacyTensor.resize(plane);
+    tensor.resize(plane);
+    check_identical("convert_in_y10", legacyTensor, tensor);
+
+    std::vector<float> modelOut(legacyTensor);
+    report("convert_out_y10/legacy", res.name, measure_ns_per_op([&] {
+               // the legacy passes work in place on the model output
+               std::copy(modelOut.begin(), modelOut.end(), legacyTensor.begin());
+               legacy_float_y_to_uint_y(legacyTensor.data(), legacyFrame.data(), plane, 1023, normalize, 64, 940);
+           }), yBytes);
+    yTensor.data = modelOut.data();
+    report("convert_out_y10/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&yTensor, &yOut, &modelToY10);
+           }), yBytes);
+    legacyFrame.resize(plane);
+    frame.resize(plane);
+    check_identical("convert_out_y10", legacyFrame, frame);
+
+    legacyTensor.resize(plane * kChannels);
+    tensor.resize(plane * kChannels);
+    legacyFrame.resize(plane * kChannels);
+    planar.data = tensor.data();
+    const double rgbBytes = plane * kChannels * (sizeof(uint16_t) + sizeof(float));
+    report("convert_in_rgb48/legacy", res.name, measure_ns_per_op([&] {
+               legacy_rgb48_to_planar(rgb48.data(), legacyFrame.data(), res.height, res.width);
+               legacy_uint_y_to_float_y(legacyFrame.data(), legacyTensor.data(), plane * kChannels, 65535.0f,
+                                        normalize);
+           }), rgbBytes);
+    report("convert_in_rgb48/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&packed, &planar, &rgb48ToModel);
+           }), rgbBytes);
+    check_identical("convert_in_rgb48", legacyTensor, tensor);
+
+    // P010 Y plane to an fp16 tensor, f16 is converted with F16C where available
+    std::vector<uint16_t> p010(plane), half(plane);
+    for (size_t i = 0; i < plane; ++i)
+        p010[i] = static_cast<uint16_t>(y10[i] << 6);
+    ivsr_image_t p010Plane = {p010.data(), IVSR_SAMPLE_U16, IVSR_LAYOUT_NHWC, 1, 1, res.height, res.width, 0, 0, 10, 1};
+    ivsr_image_t halfTensor = {half.data(), IVSR_SAMPLE_F16, IVSR_LAYOUT_NCHW, 1, 1, res.height, res.width, 0, 0, 0, 0};
+    report("convert_in_p010_f16/fused", res.name, measure_ns_per_op([&] {
+               ivsr_convert(&p010Plane, &halfTensor, &y10ToModel);
+           }), plane * 2 * sizeof(uint16_t));
+}
+
+std::unique_ptr<ov_engine> make_engine(const SyntheticModel& model, size_t requests) {
+    tensor_desc_t desc = {.precision = "fp32",
+                          .layout = "NCHW",
+                          .tensor_color_format = {0},
+                          .model_color_format = {0},
+                          .scale = 0.0f,
+                          .dimension = 4,
+                          .shape = {0}};
+    std::unique_ptr<ov_engine> engine(new ov_engine("CPU", model.path(), "", {}, {}, desc, desc));
+    if (engine->init() != OK || engine->create_infer_requests(requests) != OK)
+        throw std::runtime_error("failed to initialize the CPU engine");
+    return engine;
+}
+
+// get_idle_request/put_idle_request round trips from several threads on a small pool
+void bench_request_pool(const SyntheticModel& model) {
+    const size_t requests = 4;
+    auto engine = make_engine(model, requests);
+    for (int threads : {1, 2, 4, 8}) {
+        const size_t roundTrips = 1000;
+        double nsPerOp = measure_ns_per_op(
+            [&] {
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; ++t) {
+                    workers.emplace_back([&] {
+                        InferTask task(nullptr, nullptr, nullptr, InferFlag::CPU, nullptr);
+                        for (size_t i = 0; i < roundTrips; ++i)
+                            engine->put_idle_request(engine->get_idle_request(task)->id());
+                    });
+                }
+                for (auto& worker : workers)
+                    worker.join();
+            },
+            roundTrips * threads);
+        report("request_pool/threads:" + std::to_string(threads), "-", nsPerOp);
+    }
+}
+
+// IVSRThreadExecutor Enqueue -> worker -> run_impl -> completion -> wait_all with a tiny model
+void bench_executor(const SyntheticModel& model, const ov::Shape& shape) {
+    const size_t requests = 4;
+    auto engine = make_engine(model, requests);
+    IVSRThread::Config config{"ivsr_bench_executor", 8};
+    IVSRThread::IVSRThreadExecutor executor(config, engine.get());
+
+    size_t elems = ov::shape_size(shape);
+    std::vector<std::vector<float>> inputs(requests, synthetic_buffer(elems));
+    std::vector<std::vector<float>> outputs(requests, std::vector<float>(elems));
+    double nsPerOp = measure_ns_per_op(
+        [&] {
+            for (size_t i = 0; i < requests; ++i) {
+                auto task = executor.CreateTask(reinterpret_cast<char*>(inputs[i].data()),
+                                                reinterpret_cast<char*>(outputs[i].data()),
+                                                InferFlag::CPU);
+                executor.Enqueue(task);
+            }
+            executor.wait_all(requests);
+        },
+        requests);
+    report("executor_roundtrip", "8x8", nsPerOp);
+}
+
+// ov::Tensor wrapping and set_input/output_tensor of user buffers, as done for every task in run_impl
+void bench_tensor_wrap(const Resolution& res) {
+    ov::Shape shape = {1, static_cast<size_t>(kChannels), static_cast<size_t>(res.height),
+                       static_cast<size_t>(res.width)};
+    SyntheticModel model(make_relu_model(shape));
+    ov::Core core;
+    auto compiled = core.compile_model(core.read_model(model.path()), "CPU");
+    auto request = compiled.create_infer_request();
+
+    auto input = synthetic_buffer(ov::shape_size(shape));
+    std::vector<float> output(ov::shape_size(shape));
+    double nsPerOp = measure_ns_per_op([&] {
+        ov::Tensor inputTensor(ov::element::f32, shape, input.data());
+        request.set_input_tensor(inputTensor);
+        ov::Tensor outputTensor(ov::element::f32, shape, output.data());
+        request.set_output_tensor(outputTensor);
+    });
+    report("tensor_wrap", res.name, nsPerOp);
+}
+
+void run_engine_bench(const std::string& name, const std::function<void()>& bench) {
+    if (!selected(name))
+        return;
+    try {
+        bench();
+    } catch (const std::exception& e) {
+        std::cout << std::left << std::setw(28) << name << "skipped: " << e.what() << std::endl;
+    }
+}
+
+void usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [--filter=<substring>] [--min_time=<ms>]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.rfind("--filter=", 0) == 0) {
+            g_options.filter = arg.substr(strlen("--filter="));
+        } else if (arg.rfind("--min_time=", 0) == 0) {
+            g_options.minTimeMs = std::stod(arg.substr(strlen("--min_time=")));
+        } else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+
+    // kernels of a run, IVSR_CPU_ISA selects a lower instruction set to compare hosts
+    std::cout << "cpu_isa: " << cpu_isa_name(cpu_isa()) << " (detected " << cpu_isa_name(cpu_isa_detected()) << ")"
+              << std::endl;
+    std::cout << std::left << std::setw(28) << "benchmark" << std::setw(10) << "size" << std::right << std::setw(16)
+              << "ns/op" << std::setw(12) << "GB/s" << std::endl;
+
+    for (const auto& res : kResolutions) {
+        if (selected("patch_split"))
+            bench_patch_split(res);
+    }
+    for (const auto& res : kResolutions) {
+        if (selected("patch_merge"))
+            bench_patch_merge(res);
+    }
+    for (const auto& res : kResolutions) {
+        if (selected("patch_strip"))
+            bench_patch_strip(res);
+    }
+
+    for (const auto& res : kResolutions) {
+        if (selected("convert"))
+            bench_convert(res);
+    }
+    for (const auto& res : kResolutions) {
+        if (selected("convert"))
+            bench_convert_hbd(res);
+    }
+
+    const ov::Shape tinyShape = {1, 3, 8, 8};
+    std::unique_ptr<SyntheticModel> tinyModel;
+    run_engine_bench("request_pool", [&] {
+        tinyModel.reset(new SyntheticModel(make_relu_model(tinyShape)));
+        bench_request_pool(*tinyModel);
+    });
+    run_engine_bench("executor_roundtrip", [&] {
+        if (!tinyModel)
+            tinyModel.reset(new SyntheticModel(make_relu_model(tinyShape)));
+        bench_executor(*tinyModel, tinyShape);
+    });
+    for (const auto& res : kResolutions) {
+        run_engine_bench("tensor_wrap", [&] {
+            bench_tensor_wrap(res);
+        });
+    }
+
+    return 0;
+}
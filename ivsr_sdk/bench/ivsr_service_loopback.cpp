@@ -0,0 +1,432 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_service_loopback.cpp
+ * loopback test of ivsr_service: starts the service on a temporary socket, runs N client
+ * processes on one generated model and checks their outputs bit for bit against a local handle.
+ * Clients submit half of their frames from plain buffers, which are staged, and half from
+ * ivsr_buffer_alloc buffers, which are passed without a copy.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_model.hpp"
+#include "ivsr.h"
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Options {
+    std::string device = "CPU";
+    size_t width = 240;
+    size_t height = 136;
+    size_t scale = 2;
+    size_t features = 8;
+    size_t clients = 4;
+    size_t frames = 50;  // per client
+    size_t nireq = 4;
+    std::string service;  // ivsr_service binary, next to this one if not set
+
+    // set by the parent for the client processes
+    int client = -1;
+    std::string model;
+    std::string socket;
+    std::string reference;
+};
+
+const size_t kInputs = 4;  // distinct input frames, client i frame f uses input (i + f) % kInputs
+
+void fill_input(float* data, size_t count, size_t k) {
+    for (size_t i = 0; i < count; ++i)
+        data[i] = static_cast<float>((i * 31 + k * 17) % 256) / 255.0f;
+}
+
+struct Model {
+    tensor_desc_t desc;
+    std::string inputRes;
+    std::string nireq;
+    std::vector<ivsr_config_t> configs;
+
+    Model(const Options& options, const std::string& path, const char* socket) {
+        desc = {.precision = "fp32",
+                .layout = "NCHW",
+                .tensor_color_format = {0},
+                .model_color_format = {0},
+                .scale = 0.0,
+                .dimension = 4,
+                .shape = {0}};
+        inputRes = std::to_string(options.width) + "," + std::to_string(options.height);
+        nireq = std::to_string(options.nireq);
+        configs = {{IVSRConfigKey::INPUT_MODEL, path.c_str(), nullptr},
+                   {IVSRConfigKey::TARGET_DEVICE, options.device.c_str(), nullptr},
+                   {IVSRConfigKey::INPUT_RES, inputRes.c_str(), nullptr},
+                   {IVSRConfigKey::INFER_REQ_NUMBER, nireq.c_str(), nullptr},
+                   {IVSRConfigKey::INPUT_TENSOR_DESC_SETTING, &desc, nullptr},
+                   {IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING, &desc, nullptr},
+                   {IVSRConfigKey::SERVICE_SOCKET, socket, nullptr}};  // "" keeps the handle local
+        for (size_t i = 0; i + 1 < configs.size(); ++i)
+            configs[i].next = &configs[i + 1];
+    }
+};
+
+size_t input_count(const Options& options) {
+    return 3 * options.width * options.height;
+}
+
+size_t output_count(const Options& options) {
+    return input_count(options) * options.scale * options.scale;
+}
+
+int run_client(const Options& options) {
+    Model model(options, options.model, options.socket.c_str());
+    ivsr_handle handle = nullptr;
+    if (ivsr_init(model.configs.data(), &handle) != IVSRStatus::OK) {
+        std::cout << "client " << options.client << ": failed to connect" << std::endl;
+        return 1;
+    }
+
+    const size_t inputBytes = input_count(options) * sizeof(float);
+    const size_t outputBytes = output_count(options) * sizeof(float);
+    size_t attrInput = 0, attrOutput = 0;
+    ivsr_get_attr(handle, IVSRAttrKey::INPUT_FRAME_BYTES, &attrInput);
+    ivsr_get_attr(handle, IVSRAttrKey::OUTPUT_FRAME_BYTES, &attrOutput);
+    if (attrInput != inputBytes || attrOutput != outputBytes) {
+        std::cout << "client " << options.client << ": unexpected frame bytes " << attrInput << "/" << attrOutput
+                  << std::endl;
+        ivsr_deinit(handle);
+        return 1;
+    }
+
+    int fd = open(options.reference.c_str(), O_RDONLY);
+    void* mapped = fd >= 0 ? mmap(nullptr, kInputs * outputBytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (fd >= 0)
+        close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cout << "client " << options.client << ": failed to map the reference" << std::endl;
+        ivsr_deinit(handle);
+        return 1;
+    }
+    const char* reference = static_cast<const char*>(mapped);
+
+    size_t mismatches = 0, failed = 0;
+    auto check = [&](const char* output, size_t k) {
+        if (memcmp(output, reference + k * outputBytes, outputBytes) != 0)
+            ++mismatches;
+    };
+    auto start = Clock::now();
+
+    // 1. plain buffers, copied to and from the service
+    std::vector<float> input(input_count(options)), output(output_count(options));
+    const size_t staged = options.frames / 2;
+    for (size_t f = 0; f < staged; ++f) {
+        size_t k = (options.client + f) % kInputs;
+        fill_input(input.data(), input.size(), k);
+        if (ivsr_process(handle, reinterpret_cast<char*>(input.data()), reinterpret_cast<char*>(output.data()),
+                         nullptr) != IVSRStatus::OK) {
+            ++failed;
+            continue;
+        }
+        check(reinterpret_cast<const char*>(output.data()), k);
+    }
+
+    // 2. shared buffers, two frames in flight
+    char* inputs[2] = {static_cast<char*>(ivsr_buffer_alloc(handle, inputBytes)),
+                       static_cast<char*>(ivsr_buffer_alloc(handle, inputBytes))};
+    char* outputs[2] = {static_cast<char*>(ivsr_buffer_alloc(handle, outputBytes)),
+                        static_cast<char*>(ivsr_buffer_alloc(handle, outputBytes))};
+    if (!inputs[0] || !inputs[1] || !outputs[0] || !outputs[1]) {
+        std::cout << "client " << options.client << ": ivsr_buffer_alloc failed" << std::endl;
+        ++failed;
+    } else {
+        ivsr_token_t tokens[2] = {0, 0};
+        size_t ks[2] = {0, 0};
+        auto complete = [&](int slot) {
+            ivsr_event_t event;
+            if (tokens[slot] == 0)
+                return;
+            if (ivsr_wait(handle, tokens[slot], -1, &event) != IVSRStatus::OK || event.status != IVSRStatus::OK)
+                ++failed;
+            else
+                check(outputs[slot], ks[slot]);
+            tokens[slot] = 0;
+        };
+        for (size_t f = staged; f < options.frames; ++f) {
+            int slot = f % 2;
+            complete(slot);
+            ks[slot] = (options.client + f) % kInputs;
+            fill_input(reinterpret_cast<float*>(inputs[slot]), input_count(options), ks[slot]);
+            if (ivsr_submit(handle, inputs[slot], outputs[slot], nullptr, &tokens[slot]) != IVSRStatus::OK) {
+                tokens[slot] = 0;
+                ++failed;
+            }
+        }
+        complete(0);
+        complete(1);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (int i = 0; i < 2; ++i) {
+        if (inputs[i])
+            ivsr_buffer_free(handle, inputs[i]);
+        if (outputs[i])
+            ivsr_buffer_free(handle, outputs[i]);
+    }
+    munmap(mapped, kInputs * outputBytes);
+    ivsr_deinit(handle);
+
+    std::cout << "client " << options.client << ": " << options.frames << " frames, " << options.frames / seconds
+              << " fps, " << mismatches << " mismatches, " << failed << " failed" << std::endl;
+    return mismatches == 0 && failed == 0 ? 0 : 1;
+}
+
+// outputs of a local handle for every input
+bool write_reference(const Options& options, const std::string& model_path, const std::string& path,
+                     ivsr_memory_usage_t& usage) {
+    Model model(options, model_path, "");
+    ivsr_handle handle = nullptr;
+    if (ivsr_init(model.configs.data(), &handle) != IVSRStatus::OK)
+        return false;
+
+    std::vector<float> input(input_count(options)), output(output_count(options));
+    FILE* file = fopen(path.c_str(), "wb");
+    bool ok = file != nullptr;
+    for (size_t k = 0; ok && k < kInputs; ++k) {
+        fill_input(input.data(), input.size(), k);
+        ok = ivsr_process(handle, reinterpret_cast<char*>(input.data()), reinterpret_cast<char*>(output.data()),
+                          nullptr) == IVSRStatus::OK &&
+             fwrite(output.data(), sizeof(float), output.size(), file) == output.size();
+    }
+    if (file)
+        fclose(file);
+    ivsr_get_attr(handle, IVSRAttrKey::MEMORY_USAGE, &usage);
+    ivsr_deinit(handle);
+    return ok;
+}
+
+bool wait_for_socket(const std::string& path, pid_t service) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    for (int i = 0; i < 200; ++i) {
+        int status = 0;
+        if (waitpid(service, &status, WNOHANG) == service)
+            return false;
+        int sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        bool connected = connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(sock);
+        if (connected)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+pid_t spawn(const std::vector<std::string>& args) {
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    std::cout << "Failed to run " << args[0] << ": " << strerror(errno) << std::endl;
+    _exit(127);
+}
+
+std::string self_dir() {
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0)
+        return ".";
+    path[length] = '\0';
+    std::string self(path);
+    return self.substr(0, self.rfind('/'));
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        auto eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            return false;
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        try {
+            if (key == "device")
+                options.device = value;
+            else if (key == "width")
+                options.width = std::stoul(value);
+            else if (key == "height")
+                options.height = std::stoul(value);
+            else if (key == "scale")
+                options.scale = std::stoul(value);
+            else if (key == "features")
+                options.features = std::stoul(value);
+            else if (key == "clients")
+                options.clients = std::stoul(value);
+            else if (key == "frames")
+                options.frames = std::stoul(value);
+            else if (key == "nireq")
+                options.nireq = std::stoul(value);
+            else if (key == "service")
+                options.service = value;
+            else if (key == "client")
+                options.client = std::stoi(value);
+            else if (key == "model")
+                options.model = value;
+            else if (key == "socket")
+                options.socket = value;
+            else if (key == "reference")
+                options.reference = value;
+            else
+                return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return options.width > 0 && options.height > 0 && options.scale > 0 && options.clients > 0 &&
+           options.frames > 0 && options.nireq > 0;
+}
+
+void usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [--option=value ...]\n"
+              << "  --device    device to run on (CPU)\n"
+              << "  --width     input width (240)\n"
+              << "  --height    input height (136)\n"
+              << "  --scale     upscale factor (2)\n"
+              << "  --features  channels of the hidden layer, 0 for none (8)\n"
+              << "  --clients   client processes sharing the model (4)\n"
+              << "  --frames    frames per client (50)\n"
+              << "  --nireq     infer requests of the shared model (4)\n"
+              << "  --service   ivsr_service binary, the one next to this program if not set\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return -1;
+    }
+    if (options.client >= 0)
+        return run_client(options);
+
+    // 1. generate the model and the reference outputs of a local handle
+    char dir[] = "/tmp/ivsr_loopback_XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cout << "Failed to create a temporary directory" << std::endl;
+        return -1;
+    }
+    const std::string socket_path = std::string(dir) + "/ivsr.sock";
+    const std::string reference_path = std::string(dir) + "/reference.bin";
+    std::unique_ptr<SyntheticModel> model;
+    try {
+        model.reset(new SyntheticModel(make_sr_model(options.width, options.height, options.scale, 0, options.features)));
+    } catch (const std::exception& e) {
+        std::cout << "Failed to generate the model: " << e.what() << std::endl;
+        return -1;
+    }
+    ivsr_memory_usage_t local_usage = {};
+    if (!write_reference(options, model->path(), reference_path, local_usage)) {
+        std::cout << "Failed to compute the reference outputs" << std::endl;
+        return -1;
+    }
+
+    // 2. start the service
+    if (options.service.empty())
+        options.service = self_dir() + "/ivsr_service";
+    pid_t service = spawn({options.service, "--socket", socket_path});
+    if (!wait_for_socket(socket_path, service)) {
+        std::cout << "ivsr_service did not start" << std::endl;
+        kill(service, SIGKILL);
+        waitpid(service, nullptr, 0);
+        return -1;
+    }
+
+    // 3. run the clients, each is a process of its own
+    std::string self = self_dir() + "/" + std::string(argv[0]).substr(std::string(argv[0]).rfind('/') + 1);
+    std::vector<pid_t> clients;
+    auto start = Clock::now();
+    for (size_t i = 0; i < options.clients; ++i) {
+        clients.push_back(spawn({self,
+                                 "--device=" + options.device,
+                                 "--width=" + std::to_string(options.width),
+                                 "--height=" + std::to_string(options.height),
+                                 "--scale=" + std::to_string(options.scale),
+                                 "--frames=" + std::to_string(options.frames),
+                                 "--nireq=" + std::to_string(options.nireq),
+                                 "--client=" + std::to_string(i),
+                                 "--model=" + model->path(),
+                                 "--socket=" + socket_path,
+                                 "--reference=" + reference_path}));
+    }
+
+    // a handle of the same configs shares the model, it reports the memory of the service
+    Model shared(options, model->path(), socket_path.c_str());
+    ivsr_handle observer = nullptr;
+    ivsr_memory_usage_t service_usage = {};
+    if (ivsr_init(shared.configs.data(), &observer) == IVSRStatus::OK) {
+        ivsr_get_attr(observer, IVSRAttrKey::MEMORY_USAGE, &service_usage);
+    }
+
+    size_t failures = 0;
+    for (pid_t client : clients) {
+        int status = 0;
+        waitpid(client, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            ++failures;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    ivsr_perf_stats_t stats = {};
+    if (observer) {
+        ivsr_get_attr(observer, IVSRAttrKey::PERF_STATS, &stats);
+        ivsr_deinit(observer);
+    }
+    kill(service, SIGTERM);
+    waitpid(service, nullptr, 0);
+    unlink(reference_path.c_str());
+    rmdir(dir);
+
+    // 4. report
+    std::cout << "clients: " << options.clients << ", frames: " << options.clients * options.frames
+              << ", aggregate fps: " << options.clients * options.frames / seconds << "\n"
+              << "service frames: " << stats.frames << ", failed: " << stats.failed << "\n"
+              << "model and infer requests, one local handle: " << (local_usage.model + local_usage.infer_requests)
+              << " bytes, all clients in the service: " << (service_usage.model + service_usage.infer_requests)
+              << " bytes\n"
+              << (failures ? "FAILED: " + std::to_string(failures) + " clients" : std::string("PASSED")) << std::endl;
+    return failures ? 1 : 0;
+}
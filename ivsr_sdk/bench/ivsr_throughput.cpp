@@ -0,0 +1,476 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_throughput.cpp
+ * end-to-end throughput of ivsr_process_async with a generated super-resolution model,
+ * N streams keep one frame in flight each, or K frames with FRAME_PARALLEL, results are written as JSON.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_model.hpp"
+#include "ivsr.h"
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Options {
+    std::string device = "CPU";
+    size_t width = 480;
+    size_t height = 270;
+    size_t scale = 2;
+    size_t frames = 0;  // 0: 4D model, otherwise number of frames of a 5D model
+    size_t features = 16;
+    size_t streams = 1;
+    size_t nireq = 0;  // 0: one infer request per stream
+    size_t frameParallel = 0;  // frames in flight per stream with FRAME_PARALLEL, 0 for one frame without it
+    std::string numa;  // NUMA_NODE of the handles, every stream has a handle of its own if set
+    size_t handles = 0;  // 0: one shared handle, or one per stream with numa
+    bool asyncInit = false;  // handles are created with ivsr_init_async and initialize in parallel
+    bool clone = false;  // handles after the first one are created with ivsr_clone
+    std::string latencyBudget;  // LATENCY_BUDGET of the handles in ms, no fallback if empty
+    size_t warmupMs = 1000;
+    size_t durationMs = 10000;
+    std::string output;  // JSON file, stdout if empty
+};
+
+struct Stream;
+
+// a frame in flight of a FRAME_PARALLEL stream
+struct Frame {
+    Stream* stream = nullptr;
+    size_t seq = 0;
+    Clock::time_point start;
+    std::vector<float> output;
+    ivsr_cb_t cb;
+};
+
+struct Stream {
+    std::vector<float> input;
+    std::vector<float> output;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::vector<double> latencies;  // ms, completions inside the measurement window only
+    size_t failed = 0;
+
+    std::vector<std::unique_ptr<Frame>> frames;  // FRAME_PARALLEL only, frame n uses frames[n % K]
+    size_t inFlight = 0;
+    size_t delivered = 0;   // sequence number of the next expected completion
+    size_t outOfOrder = 0;  // completions delivered before an earlier frame
+    Clock::time_point measureStart, end;
+};
+
+void on_done(void* args) {
+    auto stream = static_cast<Stream*>(args);
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->done = true;
+    }
+    stream->cv.notify_one();
+}
+
+void run_stream(ivsr_handle handle, Stream& stream, Clock::time_point measureStart, Clock::time_point end) {
+    ivsr_cb_t cb = {on_done, &stream};
+    while (Clock::now() < end) {
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            stream.done = false;
+        }
+        auto start = Clock::now();
+        IVSRStatus status = ivsr_process_async(handle,
+                                               reinterpret_cast<char*>(stream.input.data()),
+                                               reinterpret_cast<char*>(stream.output.data()),
+                                               &cb);
+        if (status != IVSRStatus::OK) {
+            // a failing submission fails again, stop the stream instead of spinning
+            ++stream.failed;
+            break;
+        }
+        std::unique_lock<std::mutex> lock(stream.mutex);
+        stream.cv.wait(lock, [&] {
+            return stream.done;
+        });
+        auto finish = Clock::now();
+        if (start >= measureStart && finish <= end)
+            stream.latencies.push_back(std::chrono::duration<double, std::milli>(finish - start).count());
+    }
+}
+
+void on_frame_done(void* args) {
+    auto frame = static_cast<Frame*>(args);
+    Stream& stream = *frame->stream;
+    auto finish = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        if (frame->seq != stream.delivered)
+            ++stream.outOfOrder;
+        stream.delivered = frame->seq + 1;
+        if (frame->start >= stream.measureStart && finish <= stream.end)
+            stream.latencies.push_back(std::chrono::duration<double, std::milli>(finish - frame->start).count());
+        --stream.inFlight;
+    }
+    stream.cv.notify_one();
+}
+
+void run_stream_parallel(ivsr_handle handle, Stream& stream, Clock::time_point measureStart, Clock::time_point end) {
+    stream.measureStart = measureStart;
+    stream.end = end;
+    const size_t depth = stream.frames.size();
+    for (size_t seq = 0; Clock::now() < end; ++seq) {
+        Frame& frame = *stream.frames[seq % depth];
+        {
+            // completions are in order, so the slot of frame seq - depth is free once fewer than depth are in flight
+            std::unique_lock<std::mutex> lock(stream.mutex);
+            stream.cv.wait(lock, [&] {
+                return stream.inFlight < depth;
+            });
+            ++stream.inFlight;
+        }
+        frame.seq = seq;
+        frame.start = Clock::now();
+        IVSRStatus status = ivsr_process_async(handle,
+                                               reinterpret_cast<char*>(stream.input.data()),
+                                               reinterpret_cast<char*>(frame.output.data()),
+                                               &frame.cb);
+        if (status != IVSRStatus::OK) {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            --stream.inFlight;
+            ++stream.failed;
+            break;
+        }
+    }
+    std::unique_lock<std::mutex> lock(stream.mutex);
+    stream.cv.wait(lock, [&] {
+        return stream.inFlight == 0;
+    });
+}
+
+// init callbacks of ivsr_init_async handles
+struct InitWait {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending = 0;
+};
+
+void on_init_done(void* args) {
+    auto wait = static_cast<InitWait*>(args);
+    {
+        std::lock_guard<std::mutex> lock(wait->mutex);
+        --wait->pending;
+    }
+    wait->cv.notify_one();
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = static_cast<size_t>(p * sorted.size() + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        auto eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            return false;
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        try {
+            if (key == "device")
+                options.device = value;
+            else if (key == "width")
+                options.width = std::stoul(value);
+            else if (key == "height")
+                options.height = std::stoul(value);
+            else if (key == "scale")
+                options.scale = std::stoul(value);
+            else if (key == "frames")
+                options.frames = std::stoul(value);
+            else if (key == "features")
+                options.features = std::stoul(value);
+            else if (key == "streams")
+                options.streams = std::stoul(value);
+            else if (key == "nireq")
+                options.nireq = std::stoul(value);
+            else if (key == "frame_parallel")
+                options.frameParallel = std::stoul(value);
+            else if (key == "numa")
+                options.numa = value;
+            else if (key == "handles")
+                options.handles = std::stoul(value);
+            else if (key == "async_init")
+                options.asyncInit = std::stoul(value) != 0;
+            else if (key == "clone")
+                options.clone = std::stoul(value) != 0;
+            else if (key == "latency_budget")
+                options.latencyBudget = value;
+            else if (key == "warmup_ms")
+                options.warmupMs = std::stoul(value);
+            else if (key == "duration_ms")
+                options.durationMs = std::stoul(value);
+            else if (key == "output")
+                options.output = value;
+            else
+                return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return options.width > 0 && options.height > 0 && options.scale > 0 && options.streams > 0 &&
+           options.durationMs > 0;
+}
+
+void usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [--option=value ...]\n"
+              << "  --device       device to run on (CPU)\n"
+              << "  --width        input width (480)\n"
+              << "  --height       input height (270)\n"
+              << "  --scale        upscale factor (2)\n"
+              << "  --frames       frames of a 5D NFCHW model, 0 for a 4D NCHW model (0)\n"
+              << "  --features     channels of the hidden layer, 0 for none (16)\n"
+              << "  --streams      concurrent streams, each keeps one frame in flight (1)\n"
+              << "  --nireq        infer requests, 0 for one per stream (0)\n"
+              << "  --frame_parallel  frames in flight per stream with FRAME_PARALLEL, 0 for one (0)\n"
+              << "  --numa         NUMA_NODE of a handle per stream, a node or auto, one shared handle if not set\n"
+              << "  --handles      handles the streams are spread over, 0 for one or one per stream with --numa (0)\n"
+              << "  --async_init   1 to initialize the handles in parallel with ivsr_init_async (0)\n"
+              << "  --clone        1 to clone the handles after the first one with ivsr_clone (0)\n"
+              << "  --latency_budget  LATENCY_BUDGET in ms, frames over it are upscaled by the fallback filter (none)\n"
+              << "  --warmup_ms    run time excluded from the results (1000)\n"
+              << "  --duration_ms  measured run time (10000)\n"
+              << "  --output       JSON result file, stdout if not set\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return -1;
+    }
+    // with --numa every stream has a handle, and infer requests, of its own
+    const size_t numHandles = options.handles ? options.handles : options.numa.empty() ? 1 : options.streams;
+    const size_t nireq = options.nireq ? options.nireq : std::max<size_t>(1, options.streams / numHandles);
+    const size_t nif = options.frames ? options.frames : 1;
+
+    // 1. generate the model
+    std::unique_ptr<SyntheticModel> model;
+    try {
+        model.reset(new SyntheticModel(
+            make_sr_model(options.width, options.height, options.scale, options.frames, options.features)));
+    } catch (const std::exception& e) {
+        std::cout << "Failed to generate the model: " << e.what() << std::endl;
+        return -1;
+    }
+
+    // 2. set ivsr config, input and output are fp32 in the model layout so no pre/post-processing is timed
+    const uint8_t dimension = options.frames ? 5 : 4;
+    const char* layout = options.frames ? "NFCHW" : "NCHW";
+    tensor_desc_t tensor_desc = {.precision = "fp32",
+                                 .layout = {0},
+                                 .tensor_color_format = {0},
+                                 .model_color_format = {0},
+                                 .scale = 0.0,
+                                 .dimension = dimension,
+                                 .shape = {0}};
+    strcpy(tensor_desc.layout, layout);
+
+    std::string input_res = std::to_string(options.width) + "," + std::to_string(options.height);
+    std::string nireq_str = std::to_string(nireq);
+    std::vector<ivsr_config_t> configs = {{IVSRConfigKey::INPUT_MODEL, model->path().c_str(), nullptr},
+                                          {IVSRConfigKey::TARGET_DEVICE, options.device.c_str(), nullptr},
+                                          {IVSRConfigKey::INPUT_RES, input_res.c_str(), nullptr},
+                                          {IVSRConfigKey::INFER_REQ_NUMBER, nireq_str.c_str(), nullptr},
+                                          {IVSRConfigKey::INPUT_TENSOR_DESC_SETTING, &tensor_desc, nullptr},
+                                          {IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING, &tensor_desc, nullptr}};
+    std::string frame_parallel = std::to_string(options.frameParallel);
+    if (options.frameParallel > 0)
+        configs.push_back({IVSRConfigKey::FRAME_PARALLEL, frame_parallel.c_str(), nullptr});
+    if (!options.numa.empty())
+        configs.push_back({IVSRConfigKey::NUMA_NODE, options.numa.c_str(), nullptr});
+    if (!options.latencyBudget.empty())
+        configs.push_back({IVSRConfigKey::LATENCY_BUDGET, options.latencyBudget.c_str(), nullptr});
+    for (size_t i = 0; i + 1 < configs.size(); ++i)
+        configs[i].next = &configs[i + 1];
+
+    // 3. initialize ivsr, "auto" places the handles round-robin on the nodes
+    std::vector<ivsr_handle> handles(numHandles, nullptr);
+    std::vector<int> nodes(numHandles, -1);
+    InitWait initWait;
+    ivsr_cb_t initCb = {on_init_done, &initWait};
+    auto initStart = Clock::now();
+    for (size_t i = 0; i < numHandles; ++i) {
+        IVSRStatus status = IVSRStatus::OK;
+        if (options.clone && i > 0) {
+            // waits for an ivsr_init_async source, NUMA_NODE of the source is kept
+            status = ivsr_clone(handles[0], &handles[i], nullptr);
+        } else if (options.asyncInit) {
+            {
+                std::lock_guard<std::mutex> lock(initWait.mutex);
+                ++initWait.pending;
+            }
+            status = ivsr_init_async(configs.data(), &handles[i], &initCb);
+            if (status != IVSRStatus::OK)
+                on_init_done(&initWait);
+        } else {
+            status = ivsr_init(configs.data(), &handles[i]);
+        }
+        if (status != IVSRStatus::OK) {
+            std::cout << "Failed to initialize ivsr engine!" << std::endl;
+            for (size_t j = 0; j < i; ++j)
+                ivsr_deinit(handles[j]);
+            return -1;
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(initWait.mutex);
+        initWait.cv.wait(lock, [&] {
+            return initWait.pending == 0;
+        });
+    }
+    const double initMs = std::chrono::duration<double, std::milli>(Clock::now() - initStart).count();
+    for (size_t i = 0; i < numHandles; ++i) {
+        IVSRStatus status = IVSRStatus::OK;
+        ivsr_get_attr(handles[i], IVSRAttrKey::INIT_STATUS, &status);
+        if (status != IVSRStatus::OK) {
+            std::cout << "Failed to initialize ivsr engine!" << std::endl;
+            for (auto handle : handles)
+                ivsr_deinit(handle);
+            return -1;
+        }
+        ivsr_numa_stats_t numa;
+        if (ivsr_get_attr(handles[i], IVSRAttrKey::NUMA_STATS, &numa) == IVSRStatus::OK)
+            nodes[i] = numa.node;
+    }
+
+    // 4. run the streams
+    const size_t inputSize = nif * 3 * options.height * options.width;
+    const size_t outputSize = inputSize * options.scale * options.scale;
+    std::vector<std::unique_ptr<Stream>> streams;
+    for (size_t i = 0; i < options.streams; ++i) {
+        std::unique_ptr<Stream> stream(new Stream());
+        stream->input.assign(inputSize, 0.5f);
+        stream->output.assign(outputSize, 0.0f);
+        for (size_t k = 0; k < options.frameParallel; ++k) {
+            std::unique_ptr<Frame> frame(new Frame());
+            frame->stream = stream.get();
+            frame->output.assign(outputSize, 0.0f);
+            frame->cb = {on_frame_done, frame.get()};
+            stream->frames.push_back(std::move(frame));
+        }
+        streams.push_back(std::move(stream));
+    }
+
+    auto measureStart = Clock::now() + std::chrono::milliseconds(options.warmupMs);
+    auto end = measureStart + std::chrono::milliseconds(options.durationMs);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < streams.size(); ++i)
+        workers.emplace_back(options.frameParallel > 0 ? run_stream_parallel : run_stream,
+                             handles[i % numHandles],
+                             std::ref(*streams[i]),
+                             measureStart,
+                             end);
+    for (auto& worker : workers)
+        worker.join();
+
+    const char* cpuIsa = "unknown";
+    ivsr_get_attr(handles[0], IVSRAttrKey::CPU_ISA, &cpuIsa);
+
+    // counted since ivsr_init, frames of the warmup included
+    uint64_t fallback = 0;
+    for (auto handle : handles) {
+        ivsr_perf_stats_t stats;
+        if (ivsr_get_attr(handle, IVSRAttrKey::PERF_STATS, &stats) == IVSRStatus::OK)
+            fallback += stats.fallback;
+        ivsr_deinit(handle);
+    }
+
+    // 5. report
+    std::vector<double> latencies;
+    size_t failed = 0, outOfOrder = 0;
+    std::map<int, size_t> nodeRequests;  // completions in the measurement window per NUMA node
+    for (size_t i = 0; i < streams.size(); ++i) {
+        latencies.insert(latencies.end(), streams[i]->latencies.begin(), streams[i]->latencies.end());
+        failed += streams[i]->failed;
+        outOfOrder += streams[i]->outOfOrder;
+        if (nodes[i % numHandles] >= 0)
+            nodeRequests[nodes[i % numHandles]] += streams[i]->latencies.size();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0.0;
+    for (auto latency : latencies)
+        mean += latency;
+    mean = latencies.empty() ? 0.0 : mean / latencies.size();
+    const double seconds = options.durationMs / 1000.0;
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"model\": {\"dimension\": " << static_cast<int>(dimension) << ", \"width\": " << options.width
+         << ", \"height\": " << options.height << ", \"scale\": " << options.scale << ", \"frames\": " << nif
+         << ", \"features\": " << options.features << "},\n"
+         << "  \"device\": \"" << options.device << "\",\n"
+         << "  \"cpu_isa\": \"" << cpuIsa << "\",\n"
+         << "  \"streams\": " << options.streams << ",\n"
+         << "  \"infer_requests\": " << nireq << ",\n"
+         << "  \"frame_parallel\": " << options.frameParallel << ",\n"
+         << "  \"handles\": " << numHandles << ",\n"
+         << "  \"async_init\": " << (options.asyncInit ? "true" : "false") << ",\n"
+         << "  \"clone\": " << (options.clone ? "true" : "false") << ",\n"
+         << "  \"init_ms\": " << initMs << ",\n"
+         << "  \"latency_budget_ms\": " << (options.latencyBudget.empty() ? "null" : options.latencyBudget) << ",\n"
+         << "  \"fallback\": " << fallback << ",\n"
+         << "  \"warmup_ms\": " << options.warmupMs << ",\n"
+         << "  \"duration_ms\": " << options.durationMs << ",\n"
+         << "  \"requests\": " << latencies.size() << ",\n"
+         << "  \"frames\": " << latencies.size() * nif << ",\n"
+         << "  \"failed\": " << failed << ",\n"
+         << "  \"out_of_order\": " << outOfOrder << ",\n"
+         << "  \"numa_fps\": {";
+    for (auto it = nodeRequests.begin(); it != nodeRequests.end(); ++it)
+        json << (it == nodeRequests.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second * nif / seconds;
+    json << "},\n"
+         << "  \"fps\": " << latencies.size() * nif / seconds << ",\n"
+         << "  \"latency_ms\": {\"mean\": " << mean << ", \"p50\": " << percentile(latencies, 0.50)
+         << ", \"p95\": " << percentile(latencies, 0.95) << ", \"p99\": " << percentile(latencies, 0.99)
+         << ", \"max\": " << (latencies.empty() ? 0.0 : latencies.back()) << "}\n"
+         << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(options.output);
+        if (!file) {
+            std::cout << "Failed to open " << options.output << std::endl;
+            return -1;
+        }
+        file << json.str();
+    }
+    return 0;
+}
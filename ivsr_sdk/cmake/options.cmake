@@ -6,3 +6,8 @@ option(ENABLE_PERF "ENABLE_PERF" OFF)
 # Log
 option(ENABLE_LOG "ENABLE_LOG" OFF)
 
+# Bench
+option(ENABLE_BENCH "Build the ivsr_bench micro-benchmarks" OFF)
+
+# Service
+option(ENABLE_SERVICE "Build the ivsr_service daemon" OFF)
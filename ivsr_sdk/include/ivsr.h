@@ -57,7 +57,11 @@ typedef enum {
     UNSUPPORTED_KEY = -3,
     UNSUPPORTED_CONFIG = -4,
     EXCEPTION_ERROR    = -5,
-    UNSUPPORTED_SHAPE  = -6
+    UNSUPPORTED_SHAPE  = -6,
+    WOULD_BLOCK        = -7, //!< no free infer request, the task is not submitted>
+    TIMEOUT            = -8, //!< nothing completed before the timeout>
+    OUT_OF_MEMORY_BUDGET = -9, //!< the model does not fit in MAX_MEMORY even with one infer request and the smallest patch>
+    NOT_READY          = -10 //!< an ivsr_init_async handle is still initializing and INIT_QUEUE_SIZE submissions are held already>
 }IVSRStatus;
 
 /**
@@ -67,6 +71,15 @@ typedef enum {
  *     RESHAPE_SETTINGS - it's to reshape the model's input tensor, NHW in current version
  *     INPUT_TENSOR_DESC_SETTING - input data's tensor description
  *     OUTPUT_TENSOR_DESC_SETTING - output data's tensor description
+ *     LUMA_ONLY - input/output buffers are planar YUV 4:2:0 frames, only the Y plane is inferred
+ *     TEMPORAL_WINDOW - input buffers are single frames of a multi-frame model, the SDK keeps the window
+ *     DYNAMIC_SHAPE - the model is compiled with bounded height and width, each submission may have its own frame size
+ *     SERVICE_SOCKET - the handle is a client of an ivsr_service daemon which holds the model and infer requests
+ *     FRAME_PARALLEL - frames are inferred concurrently and their completions are delivered in submission order
+ *     NUMA_NODE - the model, infer requests, buffers and threads of the handle are placed on one NUMA node
+ *     INIT_QUEUE_SIZE - submissions to an ivsr_init_async handle which are held until it is initialized
+ *     LATENCY_BUDGET - frames predicted to finish later than the budget are upscaled by the FALLBACK_FILTER instead of the model
+ *     PATCH_MODE - frames larger than the model input are processed a frame of patches or a row of patches at a time
  *
  * RESHAPE_SETTINGS carries data for BATCH, WIDTH, HEIGH, in NHW format.
  * We may extent the type from one vector to a structure which specifies layout and different dimensions
@@ -84,7 +97,23 @@ typedef enum {
     RESHAPE_SETTINGS = 0x9, //!< Optional. To set reshape setting for the input model>
     INPUT_RES        = 0xA, //!< Required. To specify the input frame resolution>
     INPUT_TENSOR_DESC_SETTING     = 0xB,
-    OUTPUT_TENSOR_DESC_SETTING    = 0xC
+    OUTPUT_TENSOR_DESC_SETTING    = 0xC,
+    LUMA_ONLY        = 0xD, //!< Optional. Chroma filter "bicubic" or "lanczos". Process YUV 4:2:0 frames with a Y-input model and upscale U/V in the SDK>
+    WARMUP_ITERATIONS    = 0xE, //!< Optional. Number of synthetic inferences run on every infer request during ivsr_init>
+    WARMUP_IN_BACKGROUND = 0xF, //!< Optional. "1" to run the warmup in background, submissions wait until it is finished>
+    PRIORITY         = 0x10, //!< Optional. "HIGH", "MEDIUM" or "LOW". Default priority of submissions and device priority of the model>
+    READY_CALLBACK   = 0x11, //!< Optional. ivsr_cb_t*, called whenever an infer request becomes free>
+    TRACE_FILE       = 0x12, //!< Optional. Chrome trace JSON file to write at ivsr_deinit, IVSR_TRACE_FILE env is used if not set>
+    MAX_MEMORY       = 0x13, //!< Optional. Host memory budget of the handle in bytes, "K", "M" or "G" suffix allowed. Infer requests and patch size are reduced to fit>
+    TEMPORAL_WINDOW  = 0x14, //!< Optional. Number of input frames of a multi-frame model. Input buffers hold one frame, each submission infers the window of the last frames>
+    DYNAMIC_SHAPE    = 0x15, //!< Optional. "<alignment>" or "<height alignment>,<width alignment>" the model needs. Height and width are dynamic up to RESHAPE_SETTINGS or INPUT_RES, frames are padded to the alignment only>
+    SERVICE_SOCKET   = 0x16, //!< Optional. Unix socket of an ivsr_service daemon, the model is loaded and inferred there. IVSR_SERVICE_SOCKET env is used if not set>
+    FRAME_PARALLEL   = 0x17, //!< Optional. Frames in flight of async submissions, "0" for twice INFER_REQ_NUMBER. Completions are delivered in submission order>
+    NUMA_NODE        = 0x18, //!< Optional. "<node>" or "auto" for round-robin over the nodes. The handle compiles its model and allocates its buffers on the node, its threads run on the CPUs of the node>
+    INIT_QUEUE_SIZE  = 0x19, //!< Optional. Async submissions held while an ivsr_init_async handle initializes, started in order once it is ready. Default "0" rejects them with NOT_READY>
+    LATENCY_BUDGET   = 0x1A, //!< Optional. Milliseconds from submission to completion of an async frame. A frame predicted to exceed it is upscaled by FALLBACK_FILTER on the submitting thread>
+    FALLBACK_FILTER  = 0x1B, //!< Optional. "bicubic" or "lanczos" upscaler of LATENCY_BUDGET, default "bicubic">
+    PATCH_MODE       = 0x1C  //!< Optional. "frame" (default) splits and merges the patches of the whole frame, "strip" one row of patches at a time so the staging memory is two rows>
 }IVSRConfigKey;
 
 typedef enum {
@@ -93,7 +122,17 @@ typedef enum {
     OUTPUT_TENSOR_DESC = 0x3,
     NUM_INPUT_FRAMES   = 0x4,
     INPUT_DIMS         = 0x5,
-    OUTPUT_DIMS        = 0x6
+    OUTPUT_DIMS        = 0x6,
+    WARMUP_DURATION    = 0x7, //!< double, warmup duration in milliseconds, waits for a background warmup to finish>
+    DEADLINE_MISSED_NUM = 0x8, //!< size_t, number of tasks finished after their deadline>
+    READY_EVENT_FD      = 0x9, //!< int, eventfd signaled whenever an infer request becomes free>
+    PERF_STATS          = 0xA, //!< ivsr_perf_stats_t, snapshot of the counters and latency histograms of the handle>
+    MEMORY_USAGE        = 0xB, //!< ivsr_memory_usage_t, memory allocated by the handle and by the process>
+    INPUT_FRAME_BYTES   = 0xC, //!< size_t, size of the input buffer of a submission at INPUT_RES>
+    OUTPUT_FRAME_BYTES  = 0xD, //!< size_t, size of the output buffer of a submission at INPUT_RES>
+    NUMA_STATS          = 0xE, //!< ivsr_numa_stats_t, node of the handle and frames per node of the process>
+    INIT_STATUS         = 0xF, //!< IVSRStatus, NOT_READY while an ivsr_init_async handle initializes, then the result of the initialization>
+    CPU_ISA             = 0x10 //!< const char*, instruction set the SDK kernels of the process run with: "generic", "avx2", "avx512" or "amx", see IVSR_CPU_ISA>
 }IVSRAttrKey;
 
 /**
@@ -106,6 +145,158 @@ typedef struct ivsr_config {
     struct ivsr_config *next;
 }ivsr_config_t;
 
+/**
+ * @brief Scheduling class of a submission.
+ * Tasks of a higher class are always picked first, tasks of the same class are
+ * picked earliest-deadline-first, then in submission order.
+ */
+typedef enum {
+    IVSR_PRIORITY_HIGH   = 0,
+    IVSR_PRIORITY_MEDIUM = 1,
+    IVSR_PRIORITY_LOW    = 2
+} IVSRPriority;
+
+/**
+ * @struct Per-submission options.
+ *
+ */
+typedef struct ivsr_task_option {
+    IVSRPriority priority;
+    uint32_t     deadline_us; //!< deadline relative to the submission in microseconds, 0 means no deadline>
+    uint32_t     width;       //!< frame size of a DYNAMIC_SHAPE handle, buffers are tightly packed at this size. 0 for INPUT_RES>
+    uint32_t     height;
+} ivsr_task_option_t;
+
+/**
+ * @brief Identifier of a submission returned by ivsr_submit, never 0.
+ */
+typedef uint64_t ivsr_token_t;
+
+/**
+ * @struct Completion event of a submission.
+ * Times are in milliseconds.
+ */
+typedef struct ivsr_event {
+    ivsr_token_t token;
+    IVSRStatus   status;
+    double       queue_time; //!< from submission to the start of the inference>
+    double       infer_time; //!< from the start to the end of the inference>
+    double       total_time; //!< from submission to completion, including chroma resampling in LUMA_ONLY mode>
+} ivsr_event_t;
+
+/**
+ * @struct Latency distribution, times are in milliseconds.
+ */
+typedef struct ivsr_latency_stats {
+    uint64_t count;
+    double   mean;
+    double   p50;
+    double   p95;
+    double   p99;
+    double   max;
+} ivsr_latency_stats_t;
+
+/**
+ * @struct Counters and latencies of a handle since ivsr_init.
+ */
+typedef struct ivsr_perf_stats {
+    uint64_t frames;   //!< frames completed>
+    uint64_t patches;  //!< inference tasks of ivsr_process, one per patch>
+    uint64_t failed;   //!< submissions or inferences which failed>
+    uint64_t dropped;  //!< submissions rejected with WOULD_BLOCK>
+    ivsr_latency_stats_t end_to_end; //!< from submission to completion of a frame>
+    ivsr_latency_stats_t queue_wait; //!< from submission to the start of an inference>
+    ivsr_latency_stats_t inference;  //!< inference of a frame or a patch>
+    ivsr_latency_stats_t split;      //!< patch split of a frame>
+    ivsr_latency_stats_t merge;      //!< patch merge of a frame>
+    ivsr_latency_stats_t callback;   //!< completion callbacks>
+    ivsr_latency_stats_t reorder;    //!< from completion to the in-order delivery of FRAME_PARALLEL frames>
+    uint64_t fallback; //!< frames upscaled by the FALLBACK_FILTER instead of the model to meet LATENCY_BUDGET, counted in frames too>
+} ivsr_perf_stats_t;
+
+/**
+ * @struct Memory allocated by the SDK in bytes.
+ * Model and infer request sizes are the tensors the SDK asks OpenVINO for,
+ * plugin-internal buffers such as intermediate activations are not included.
+ */
+typedef struct ivsr_memory_usage {
+    size_t model;          //!< weights of the compiled model>
+    size_t infer_requests; //!< input, output and state tensors of all infer requests>
+    size_t patch_staging;  //!< patch buffers of frames being split or merged>
+    size_t pixel_counter;  //!< overlap counters of frames being merged>
+    size_t frame_window;   //!< input frames kept for TEMPORAL_WINDOW>
+    size_t total;          //!< sum of the above>
+    size_t peak;           //!< highest total since ivsr_init>
+    size_t process_total;  //!< total of all handles of the process>
+    size_t process_peak;   //!< highest process_total>
+} ivsr_memory_usage_t;
+
+#define IVSR_MAX_NUMA_NODES 16
+
+/**
+ * @struct NUMA placement of a handle and throughput of every node in the process.
+ * Frames and fps count the handles with NUMA_NODE, fps is measured from the first handle of the node.
+ */
+typedef struct ivsr_numa_stats {
+    int      node;       //!< node of the handle, -1 if NUMA_NODE is not set>
+    int      num_nodes;  //!< nodes with CPUs, at most IVSR_MAX_NUMA_NODES are reported>
+    int      node_ids[IVSR_MAX_NUMA_NODES];
+    uint32_t cpus[IVSR_MAX_NUMA_NODES];   //!< CPUs of the node the process may run on>
+    uint64_t frames[IVSR_MAX_NUMA_NODES]; //!< frames completed by the handles of the node>
+    double   fps[IVSR_MAX_NUMA_NODES];
+} ivsr_numa_stats_t;
+
+/**
+ * @brief Sample type of an image converted by ivsr_convert.
+ */
+typedef enum {
+    IVSR_SAMPLE_U8  = 0,
+    IVSR_SAMPLE_U16 = 1, //!< 16-bit, or high bit depth samples in the low bits, see ivsr_image_t.bit_depth>
+    IVSR_SAMPLE_F16 = 2,
+    IVSR_SAMPLE_F32 = 3,
+    IVSR_SAMPLE_Y410 = 4 //!< 32-bit word per pixel with 10-bit U, Y, V from the low bits and 2-bit alpha, NHWC with 3 channels in U, Y, V order>
+} IVSRSampleType;
+
+typedef enum {
+    IVSR_LAYOUT_NCHW = 0, //!< planar, one plane per channel>
+    IVSR_LAYOUT_NHWC = 1  //!< packed, channels of a pixel are adjacent>
+} IVSRImageLayout;
+
+/**
+ * @struct Image or batch of images converted by ivsr_convert.
+ * Images of a batch are contiguous: channels * plane_stride bytes apart in NCHW,
+ * height * row_stride bytes apart in NHWC.
+ */
+typedef struct ivsr_image {
+    void*           data;
+    IVSRSampleType  type;
+    IVSRImageLayout layout;
+    int             batch;
+    int             channels;
+    int             height;
+    int             width;
+    size_t          row_stride;   //!< bytes between rows, 0 for tightly packed rows>
+    size_t          plane_stride; //!< bytes between NCHW channel planes, 0 for height * row_stride, e.g. padded model tensors>
+    int             bit_depth;  //!< significant bits of U16 samples, e.g. 10, 0 for 16. Integer outputs saturate to it>
+    int             msb_aligned; //!< U16 samples hold bit_depth bits in their high bits, e.g. P010, low bits are written as zero>
+} ivsr_image_t;
+
+/**
+ * @struct Arithmetic of ivsr_convert, every sample is computed as
+ * dst = round(clamp(src * scale / divisor * post_scale, min_value, max_value)), rounding applies to integer outputs only.
+ * Each operation is rounded to float in this order, so a normalization done in separate passes,
+ * e.g. swscale then a normalize factor, is reproduced bit for bit.
+ */
+typedef struct ivsr_convert_param {
+    float scale;
+    float min_value; //!< the clamp is skipped if min_value >= max_value, integer outputs still saturate>
+    float max_value;
+    int   swap_rb;   //!< reverse the order of the first three channels, RGB <-> BGR>
+    int   threads;   //!< threads splitting the rows, 0 for the OpenMP default>
+    float divisor;   //!< 0 to skip the division>
+    float post_scale; //!< 0 to skip the second multiplication>
+} ivsr_convert_param_t;
+
 typedef struct tensor_desc {
     char precision[20];
     char layout[20];
@@ -129,6 +320,36 @@ extern "C" {
  */
 IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle);
 
+/**
+ * @brief initialize the intel vsr sdk in background
+ * The handle is returned at once, the model is loaded and compiled on a thread of its own, so several
+ * handles initialize in parallel. Async submissions before it is ready are held up to INIT_QUEUE_SIZE,
+ * or rejected with NOT_READY. Synchronous calls wait for the initialization, attributes other than
+ * INIT_STATUS return NOT_READY. If the initialization fails, held submissions are completed with its
+ * error and the handle only accepts ivsr_deinit.
+ *
+ * @param configs configurations as for ivsr_init, they are copied and can be freed once the call returns.
+ * @param handle returns the handle.
+ * @param init_cb called once the initialization is finished, successfully or not, can be NULL.
+ *     It runs on the initializing thread and must not call ivsr_deinit.
+ * @return IVSRStatus
+ */
+IVSRStatus ivsr_init_async(ivsr_config_t *configs, ivsr_handle *handle, ivsr_cb_t *init_cb);
+
+/**
+ * @brief create a handle of the same model as an initialized handle, without loading or compiling it again.
+ * The clone shares the compiled model, the patch plan and read-only tables of the source, and gets its own
+ * infer requests with their recurrent state, temporal window, counters and notifications. The source can be
+ * de-initialized before its clones. SERVICE_SOCKET handles can not be cloned.
+ *
+ * @param handle initialized source handle, an ivsr_init_async handle is waited for.
+ * @param new_handle returns the clone.
+ * @param overrides NULL, or INFER_REQ_NUMBER, PRIORITY, READY_CALLBACK, TRACE_FILE, WARMUP_ITERATIONS or
+ *     FRAME_PARALLEL of the clone. Other keys return UNSUPPORTED_KEY. READY_CALLBACK is not inherited.
+ * @return IVSRStatus
+ */
+IVSRStatus ivsr_clone(ivsr_handle handle, ivsr_handle *new_handle, ivsr_config_t *overrides);
+
 /**
  * @brief process function
  *
@@ -142,6 +363,79 @@ IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data,
 
 IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output_data, ivsr_cb_t* cb);
 
+/**
+ * @brief process functions with per-submission options
+ *
+ * @param option scheduling options, NULL to use the handle's default priority and no deadline.
+ * @return IVSRStatus
+ */
+IVSRStatus ivsr_process_ex(ivsr_handle handle,
+                           char* input_data,
+                           char* output_data,
+                           ivsr_cb_t* cb,
+                           const ivsr_task_option_t* option);
+
+IVSRStatus ivsr_process_async_ex(ivsr_handle handle,
+                                 char* input_data,
+                                 char* output_data,
+                                 ivsr_cb_t* cb,
+                                 const ivsr_task_option_t* option);
+
+/**
+ * @brief non-blocking variant of ivsr_process_async_ex
+ * Returns WOULD_BLOCK at once if no infer request is free, wait for READY_CALLBACK or
+ * READY_EVENT_FD before submitting again.
+ *
+ * @return IVSRStatus
+ */
+IVSRStatus ivsr_try_process_async(ivsr_handle handle,
+                                  char* input_data,
+                                  char* output_data,
+                                  ivsr_cb_t* cb,
+                                  const ivsr_task_option_t* option);
+
+/**
+ * @brief submit a task whose completion is reported through ivsr_poll/ivsr_wait instead of a callback
+ *
+ * @param option scheduling options, can be NULL.
+ * @param token returns the token of the submission.
+ * @return IVSRStatus
+ */
+IVSRStatus ivsr_submit(ivsr_handle handle,
+                       char* input_data,
+                       char* output_data,
+                       const ivsr_task_option_t* option,
+                       ivsr_token_t* token);
+
+/**
+ * @brief get completed submissions in completion order
+ *
+ * @param events array of at least max_events elements.
+ * @param timeout_ms <0 waits until one submission completes, 0 returns at once.
+ * @param num_events returns the number of events copied out.
+ * @return IVSRStatus OK, or TIMEOUT if nothing completed in time.
+ */
+IVSRStatus ivsr_poll(ivsr_handle handle, ivsr_event_t* events, size_t max_events, int timeout_ms, size_t* num_events);
+
+/**
+ * @brief wait for one submission, its event is not returned by ivsr_poll afterwards
+ *
+ * @param event can be NULL.
+ * @return IVSRStatus OK, TIMEOUT, or GENERAL_ERROR for an unknown or already polled token.
+ */
+IVSRStatus ivsr_wait(ivsr_handle handle, ivsr_token_t token, int timeout_ms, ivsr_event_t* event);
+
+/**
+ * @brief add a frame to the temporal window without inferring it, TEMPORAL_WINDOW handles only.
+ * Submissions of a TEMPORAL_WINDOW handle take one frame in model input format, it is copied into
+ * the window and the last NUM_INPUT_FRAMES frames are inferred. Frames before the first one are
+ * copies of the first frame. Frames must be pushed and submitted from one thread at a time.
+ *
+ * @param frame one input frame, it can be reused once the call returns.
+ * @return IVSRStatus UNSUPPORTED_CONFIG if TEMPORAL_WINDOW is not set.
+ */
+IVSRStatus ivsr_push_frame(ivsr_handle handle, const char* frame);
+
 /**
  * @brief reset the configures for vsr
  *
@@ -161,6 +455,33 @@ IVSRStatus ivsr_reconfig(ivsr_handle handle, ivsr_config_t* configs);
  */
 IVSRStatus ivsr_get_attr(ivsr_handle handle, IVSRAttrKey key, void* value);
 
+/**
+ * @brief convert layout, channel order, sample type, scale and clamp of an image in a single pass.
+ * Used to move frames between decoder/encoder buffers and model tensors without intermediate copies.
+ * src and dst must have the same batch, channels, height and width, they may only overlap when they
+ * have the same layout, sample size and strides.
+ *
+ * @param param NULL for scale 1, no clamp and no channel swap.
+ * @return IVSRStatus UNSUPPORTED_SHAPE if the images do not match, UNSUPPORTED_CONFIG for invalid types or strides.
+ */
+IVSRStatus ivsr_convert(const ivsr_image_t* src, ivsr_image_t* dst, const ivsr_convert_param_t* param);
+
+/**
+ * @brief allocate a frame buffer for the input or output of submissions.
+ * Buffers of a SERVICE_SOCKET handle are shared memory mapped by the daemon, frames in them are
+ * passed without a copy, other buffers are copied in and out. For other handles it is a page-aligned allocation.
+ *
+ * @return NULL on error.
+ */
+void* ivsr_buffer_alloc(ivsr_handle handle, size_t size);
+
+/**
+ * @brief free a buffer of ivsr_buffer_alloc, it must not be used by a submission in flight.
+ *
+ * @return IVSRStatus GENERAL_ERROR if the buffer was not allocated by the handle.
+ */
+IVSRStatus ivsr_buffer_free(ivsr_handle handle, void* buffer);
+
 /**
  * @brief free created vsr handle and conresponding resources.
  *
@@ -0,0 +1,373 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "frame_io.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char kY4mMagic[] = "YUV4MPEG2 ";
+const char kY4mFrame[] = "FRAME";
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// madvise needs a page aligned start, the range is widened to whole pages
+void advise(uint8_t* base, size_t size, size_t offset, size_t length, int advice) {
+    if (!base || length == 0 || offset >= size)
+        return;
+    length = std::min(length, size - offset);
+    size_t start = offset / page_size() * page_size();
+    madvise(base + start, offset + length - start, advice);
+}
+
+bool parse_y4m_colorspace(const std::string& tag, FrameFormat& format) {
+    // C420jpeg, C420paldv and C420mpeg2 only differ in chroma siting
+    if (tag == "420" || tag == "420jpeg" || tag == "420paldv" || tag == "420mpeg2") {
+        format.chroma = ChromaFormat::YUV420;
+        format.bitDepth = 8;
+    } else if (tag == "444") {
+        format.chroma = ChromaFormat::YUV444;
+        format.bitDepth = 8;
+    } else if (tag == "420p10") {
+        format.chroma = ChromaFormat::YUV420;
+        format.bitDepth = 10;
+    } else if (tag == "444p10") {
+        format.chroma = ChromaFormat::YUV444;
+        format.bitDepth = 10;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string y4m_colorspace(const FrameFormat& format) {
+    std::string tag = format.chroma == ChromaFormat::YUV444 ? "444" : "420";
+    if (format.bitDepth > 8)
+        tag += "p" + std::to_string(format.bitDepth);
+    else if (format.chroma == ChromaFormat::YUV420)
+        tag += "jpeg";
+    return tag;
+}
+
+// parses the stream header line, returns the offset of the first frame or 0 on error
+size_t parse_y4m_header(const uint8_t* data, size_t size, FrameFormat& format, std::string& params) {
+    const size_t magicLen = sizeof(kY4mMagic) - 1;
+    if (size < magicLen || memcmp(data, kY4mMagic, magicLen) != 0)
+        return 0;
+    auto end = static_cast<const uint8_t*>(memchr(data, '\n', size));
+    if (!end)
+        return 0;
+
+    format = FrameFormat();  // Y4M without a C tag is 8-bit 4:2:0
+    std::istringstream header(std::string(reinterpret_cast<const char*>(data) + magicLen,
+                                          reinterpret_cast<const char*>(end)));
+    std::string token;
+    while (header >> token) {
+        char tag = token[0];
+        std::string value = token.substr(1);
+        if (tag == 'W') {
+            format.width = std::atoi(value.c_str());
+        } else if (tag == 'H') {
+            format.height = std::atoi(value.c_str());
+        } else if (tag == 'C') {
+            if (!parse_y4m_colorspace(value, format)) {
+                std::cout << "Unsupported Y4M colorspace C" << value << std::endl;
+                return 0;
+            }
+        } else {
+            params += (params.empty() ? "" : " ") + token;
+        }
+    }
+    if (format.width <= 0 || format.height <= 0)
+        return 0;
+    return static_cast<size_t>(end - data) + 1;
+}
+
+inline int sample_at(const uint8_t* plane, size_t index, int bytes) {
+    if (bytes == 1)
+        return plane[index];
+    return plane[2 * index] | (plane[2 * index + 1] << 8);
+}
+
+inline void store_sample(uint8_t* plane, size_t index, int bytes, int value) {
+    if (bytes == 1) {
+        plane[index] = static_cast<uint8_t>(value);
+    } else {
+        plane[2 * index] = static_cast<uint8_t>(value & 0xff);
+        plane[2 * index + 1] = static_cast<uint8_t>(value >> 8);
+    }
+}
+
+inline int clamp_round(float value, int maxValue) {
+    return std::min(maxValue, std::max(0, static_cast<int>(std::lround(value))));
+}
+
+inline uint8_t clamp_u8(float value) {
+    return static_cast<uint8_t>(clamp_round(value, 255));
+}
+
+}  // namespace
+
+bool parse_pixel_format(const std::string& name, FrameFormat& format) {
+    if (name == "yuv420p" || name == "yuv420p10le") {
+        format.chroma = ChromaFormat::YUV420;
+    } else if (name == "yuv444p" || name == "yuv444p10le") {
+        format.chroma = ChromaFormat::YUV444;
+    } else {
+        return false;
+    }
+    format.bitDepth = name.find("p10") != std::string::npos ? 10 : 8;
+    return true;
+}
+
+bool is_y4m_file(const std::string& path) {
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+}
+
+std::unique_ptr<FrameReader> FrameReader::open(const std::string& path, const FrameFormat& rawFormat) {
+    std::unique_ptr<FrameReader> reader(new FrameReader());
+    reader->fd_ = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (reader->fd_ < 0 || fstat(reader->fd_, &st) != 0 || st.st_size == 0) {
+        std::cout << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    reader->size_ = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, reader->size_, PROT_READ, MAP_PRIVATE, reader->fd_, 0);
+    if (base == MAP_FAILED) {
+        std::cout << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    reader->base_ = static_cast<uint8_t*>(base);
+    // frames are consumed in order, the kernel reads ahead aggressively and frees behind
+    madvise(reader->base_, reader->size_, MADV_SEQUENTIAL);
+
+    const uint8_t* data = reader->base_;
+    const size_t size = reader->size_;
+    size_t offset = parse_y4m_header(data, size, reader->format_, reader->y4mParams_);
+    if (offset > 0) {
+        // every frame starts with a "FRAME[ params]\n" line, frames are indexed once at open
+        const size_t frameBytes = reader->format_.frame_bytes();
+        const size_t frameTagLen = sizeof(kY4mFrame) - 1;
+        while (offset < size) {
+            if (size - offset < frameTagLen || memcmp(data + offset, kY4mFrame, frameTagLen) != 0)
+                break;
+            auto end = static_cast<const uint8_t*>(memchr(data + offset, '\n', size - offset));
+            if (!end || static_cast<size_t>(end - data) + 1 + frameBytes > size)
+                break;
+            offset = static_cast<size_t>(end - data) + 1;
+            reader->offsets_.push_back(offset);
+            offset += frameBytes;
+        }
+    } else if (memcmp(data, kY4mMagic, std::min(size, sizeof(kY4mMagic) - 1)) == 0) {
+        std::cout << "Invalid Y4M header in " << path << std::endl;
+        return nullptr;
+    } else {
+        if (rawFormat.width <= 0 || rawFormat.height <= 0) {
+            std::cout << "Resolution of the raw file " << path << " is not set" << std::endl;
+            return nullptr;
+        }
+        reader->format_ = rawFormat;
+        const size_t frameBytes = rawFormat.frame_bytes();
+        for (size_t frame = 0; (frame + 1) * frameBytes <= size; ++frame)
+            reader->offsets_.push_back(frame * frameBytes);
+    }
+
+    if (reader->offsets_.empty()) {
+        std::cout << "No complete frame in " << path << std::endl;
+        return nullptr;
+    }
+    return reader;
+}
+
+FrameReader::~FrameReader() {
+    if (base_)
+        munmap(base_, size_);
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+void FrameReader::prefetch(size_t first, size_t count) const {
+    if (first >= offsets_.size())
+        return;
+    count = std::min(count, offsets_.size() - first);
+    advise(base_, size_, offsets_[first], offsets_[first + count - 1] + format_.frame_bytes() - offsets_[first],
+           MADV_WILLNEED);
+}
+
+void FrameReader::release(size_t first, size_t count) const {
+    if (first >= offsets_.size())
+        return;
+    count = std::min(count, offsets_.size() - first);
+    // pages shared with a neighbouring frame which may still be in use are kept
+    size_t begin = (offsets_[first] + page_size() - 1) / page_size() * page_size();
+    size_t end = (offsets_[first + count - 1] + format_.frame_bytes()) / page_size() * page_size();
+    if (end > begin)
+        madvise(base_ + begin, end - begin, MADV_DONTNEED);
+}
+
+std::unique_ptr<FrameWriter> FrameWriter::create(const std::string& path,
+                                                 const FrameFormat& format,
+                                                 size_t frameCount,
+                                                 bool y4m,
+                                                 const std::string& y4mParams) {
+    std::unique_ptr<FrameWriter> writer(new FrameWriter());
+    writer->format_ = format;
+    std::string header;
+    if (y4m) {
+        header = std::string(kY4mMagic) + "W" + std::to_string(format.width) + " H" +
+                 std::to_string(format.height) + " C" + y4m_colorspace(format);
+        if (!y4mParams.empty())
+            header += " " + y4mParams;
+        header += "\n";
+        writer->frameHeaderBytes_ = sizeof(kY4mFrame);  // "FRAME\n"
+    }
+    writer->dataOffset_ = header.size();
+    writer->frameStride_ = writer->frameHeaderBytes_ + format.frame_bytes();
+    writer->size_ = writer->dataOffset_ + frameCount * writer->frameStride_;
+
+    writer->fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd_ < 0 || ftruncate(writer->fd_, static_cast<off_t>(writer->size_)) != 0) {
+        std::cout << "Failed to create " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    void* base = mmap(nullptr, writer->size_, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd_, 0);
+    if (base == MAP_FAILED) {
+        std::cout << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    writer->base_ = static_cast<uint8_t*>(base);
+
+    memcpy(writer->base_, header.data(), header.size());
+    for (size_t i = 0; y4m && i < frameCount; ++i) {
+        uint8_t* frameHeader = writer->base_ + writer->dataOffset_ + i * writer->frameStride_;
+        memcpy(frameHeader, kY4mFrame, sizeof(kY4mFrame) - 1);
+        frameHeader[sizeof(kY4mFrame) - 1] = '\n';
+    }
+    return writer;
+}
+
+FrameWriter::~FrameWriter() {
+    if (base_) {
+        msync(base_, size_, MS_ASYNC);
+        munmap(base_, size_);
+    }
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+void FrameWriter::flush(size_t first, size_t count) {
+    if (count == 0)
+        return;
+    size_t begin = dataOffset_ + first * frameStride_;
+    size_t length = count * frameStride_;
+    size_t start = begin / page_size() * page_size();
+    msync(base_ + start, begin + length - start, MS_ASYNC);
+    // the data stays in the page cache of the shared mapping, only whole pages of these frames are dropped
+    size_t alignedBegin = (begin + page_size() - 1) / page_size() * page_size();
+    size_t alignedEnd = (begin + length) / page_size() * page_size();
+    if (alignedEnd > alignedBegin)
+        madvise(base_ + alignedBegin, alignedEnd - alignedBegin, MADV_DONTNEED);
+}
+
+void frame_to_bgr(const uint8_t* frame, const FrameFormat& format, uint8_t* bgr) {
+    const int bytes = format.bytes_per_sample();
+    const int shift = format.bitDepth - 8;
+    const uint8_t* yPlane = frame;
+    const uint8_t* uPlane = yPlane + format.plane_bytes(0);
+    const uint8_t* vPlane = uPlane + format.plane_bytes(1);
+    const int chromaShift = format.chroma == ChromaFormat::YUV420 ? 1 : 0;
+    const int chromaWidth = format.plane_width(1);
+
+    for (int y = 0; y < format.height; ++y) {
+        for (int x = 0; x < format.width; ++x) {
+            size_t c = static_cast<size_t>(y >> chromaShift) * chromaWidth + (x >> chromaShift);
+            float luma = 1.164f * ((sample_at(yPlane, static_cast<size_t>(y) * format.width + x, bytes) >> shift) - 16);
+            float cb = static_cast<float>((sample_at(uPlane, c, bytes) >> shift) - 128);
+            float cr = static_cast<float>((sample_at(vPlane, c, bytes) >> shift) - 128);
+            uint8_t* px = bgr + (static_cast<size_t>(y) * format.width + x) * 3;
+            px[0] = clamp_u8(luma + 2.017f * cb);
+            px[1] = clamp_u8(luma - 0.392f * cb - 0.813f * cr);
+            px[2] = clamp_u8(luma + 1.596f * cr);
+        }
+    }
+}
+
+void rgb_to_frame(const float* rgb, float scale, const FrameFormat& format, uint8_t* frame) {
+    const int bytes = format.bytes_per_sample();
+    const int maxValue = (1 << format.bitDepth) - 1;
+    const float depth = static_cast<float>(1 << (format.bitDepth - 8));
+    const size_t planeSize = static_cast<size_t>(format.width) * format.height;
+    const float* r = rgb;
+    const float* g = r + planeSize;
+    const float* b = g + planeSize;
+    uint8_t* yPlane = frame;
+    uint8_t* uPlane = yPlane + format.plane_bytes(0);
+    uint8_t* vPlane = uPlane + format.plane_bytes(1);
+    const float norm = scale / 255.0f;
+
+    for (size_t i = 0; i < planeSize; ++i) {
+        float luma = 16.0f + 65.481f * r[i] * norm + 128.553f * g[i] * norm + 24.966f * b[i] * norm;
+        store_sample(yPlane, i, bytes, clamp_round(luma * depth, maxValue));
+    }
+
+    const int step = format.chroma == ChromaFormat::YUV420 ? 2 : 1;
+    const int chromaWidth = format.plane_width(1);
+    for (int cy = 0; cy < format.plane_height(1); ++cy) {
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            float sr = 0.0f, sg = 0.0f, sb = 0.0f;
+            int n = 0;
+            for (int y = cy * step; y < std::min(cy * step + step, format.height); ++y) {
+                for (int x = cx * step; x < std::min(cx * step + step, format.width); ++x) {
+                    size_t i = static_cast<size_t>(y) * format.width + x;
+                    sr += r[i];
+                    sg += g[i];
+                    sb += b[i];
+                    ++n;
+                }
+            }
+            sr *= norm / n;
+            sg *= norm / n;
+            sb *= norm / n;
+            size_t c = static_cast<size_t>(cy) * chromaWidth + cx;
+            store_sample(uPlane, c, bytes, clamp_round((128.0f - 37.797f * sr - 74.203f * sg + 112.0f * sb) * depth, maxValue));
+            store_sample(vPlane, c, bytes, clamp_round((128.0f + 112.0f * sr - 93.786f * sg - 18.214f * sb) * depth, maxValue));
+        }
+    }
+}
+
+void yuv_float_to_frame(const float* yuv, float scale, const FrameFormat& format, uint8_t* frame) {
+    const int bytes = format.bytes_per_sample();
+    const int maxValue = (1 << format.bitDepth) - 1;
+    for (int plane = 0; plane < 3; ++plane) {
+        const size_t samples = static_cast<size_t>(format.plane_width(plane)) * format.plane_height(plane);
+        for (size_t i = 0; i < samples; ++i)
+            store_sample(frame, i, bytes, clamp_round(yuv[i] * scale, maxValue));
+        yuv += samples;
+        frame += samples * bytes;
+    }
+}
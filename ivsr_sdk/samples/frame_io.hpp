@@ -0,0 +1,177 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file frame_io.hpp
+ * mmap-based reader and writer of raw planar YUV and Y4M files,
+ * frames are accessed in place in the mapping, readahead and release are driven by madvise.
+ */
+
+#ifndef FRAME_IO_HPP
+#define FRAME_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ChromaFormat { YUV420, YUV444 };
+
+struct FrameFormat {
+    int width = 0;
+    int height = 0;
+    ChromaFormat chroma = ChromaFormat::YUV420;
+    int bitDepth = 8;  // 8 or 10, samples above 8 bits are 16-bit little-endian
+
+    int bytes_per_sample() const {
+        return bitDepth > 8 ? 2 : 1;
+    }
+
+    int plane_width(int plane) const {
+        return plane == 0 || chroma == ChromaFormat::YUV444 ? width : (width + 1) / 2;
+    }
+
+    int plane_height(int plane) const {
+        return plane == 0 || chroma == ChromaFormat::YUV444 ? height : (height + 1) / 2;
+    }
+
+    size_t plane_bytes(int plane) const {
+        return static_cast<size_t>(plane_width(plane)) * plane_height(plane) * bytes_per_sample();
+    }
+
+    // Y, U and V planes are contiguous
+    size_t frame_bytes() const {
+        return plane_bytes(0) + plane_bytes(1) + plane_bytes(2);
+    }
+};
+
+/**
+ * @brief parse an FFmpeg pixel format name: yuv420p, yuv420p10le, yuv444p or yuv444p10le.
+ */
+bool parse_pixel_format(const std::string& name, FrameFormat& format);
+
+/**
+ * @brief Y4M files are recognized by extension, everything else is raw.
+ */
+bool is_y4m_file(const std::string& path);
+
+class FrameReader {
+public:
+    /**
+     * @brief map a raw or Y4M file read-only.
+     * The format is taken from the Y4M header, raw files need rawFormat.
+     * @return nullptr on error, the reason is printed.
+     */
+    static std::unique_ptr<FrameReader> open(const std::string& path, const FrameFormat& rawFormat);
+
+    ~FrameReader();
+
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    const FrameFormat& format() const {
+        return format_;
+    }
+
+    // Y4M stream parameters after the size and colorspace, e.g. frame rate and interlacing
+    const std::string& y4m_params() const {
+        return y4mParams_;
+    }
+
+    size_t frame_count() const {
+        return offsets_.size();
+    }
+
+    // planar frame data inside the mapping, valid until the reader is destroyed
+    const uint8_t* frame(size_t index) const {
+        return base_ + offsets_[index];
+    }
+
+    // start reading frames ahead asynchronously
+    void prefetch(size_t first, size_t count) const;
+
+    // drop consumed frames from the process, they stay in the page cache
+    void release(size_t first, size_t count) const;
+
+private:
+    FrameReader() = default;
+
+    int fd_ = -1;
+    uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    FrameFormat format_;
+    std::string y4mParams_;
+    std::vector<size_t> offsets_;
+};
+
+class FrameWriter {
+public:
+    /**
+     * @brief create a file of frameCount frames and map it writable, frames may be written in any order.
+     * y4mParams is appended to the Y4M stream header, it is ignored for raw files.
+     * @return nullptr on error, the reason is printed.
+     */
+    static std::unique_ptr<FrameWriter> create(const std::string& path,
+                                               const FrameFormat& format,
+                                               size_t frameCount,
+                                               bool y4m,
+                                               const std::string& y4mParams = "");
+
+    // writes back the mapping asynchronously
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    const FrameFormat& format() const {
+        return format_;
+    }
+
+    uint8_t* frame(size_t index) {
+        return base_ + dataOffset_ + index * frameStride_ + frameHeaderBytes_;
+    }
+
+    // start writing back finished frames and drop them from the process
+    void flush(size_t first, size_t count);
+
+private:
+    FrameWriter() = default;
+
+    int fd_ = -1;
+    uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    FrameFormat format_;
+    size_t dataOffset_ = 0;        // bytes of the stream header
+    size_t frameHeaderBytes_ = 0;  // bytes of "FRAME\n" per frame
+    size_t frameStride_ = 0;
+};
+
+/**
+ * @brief BT.601 limited range YUV frame to packed 8-bit BGR, 10-bit samples are reduced to 8 bits.
+ */
+void frame_to_bgr(const uint8_t* frame, const FrameFormat& format, uint8_t* bgr);
+
+/**
+ * @brief planar float RGB (3 x H x W, full range 0..255 after multiplying by scale) to a BT.601 limited range frame.
+ * 4:2:0 chroma is the average of each 2x2 block.
+ */
+void rgb_to_frame(const float* rgb, float scale, const FrameFormat& format, uint8_t* frame);
+
+/**
+ * @brief planar float YUV to frame samples, the planes hold sample values after multiplying by scale.
+ */
+void yuv_float_to_frame(const float* yuv, float scale, const FrameFormat& format, uint8_t* frame);
+
+#endif  // FRAME_IO_HPP
@@ -15,15 +15,22 @@
 #include<dirent.h>
 #include<iostream>
 #include<unistd.h>
+#include<sys/stat.h>
 #include "opencv2/opencv.hpp"
 #include <opencv2/core/utility.hpp>
 #include "ivsr.h"
 #include "utils.hpp"
+#include "frame_io.hpp"
 #include "stdlib.h"
 #include <chrono>
 #include <ctime>
 #include <mutex>
 #include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
 
 typedef std::chrono::high_resolution_clock Time;
 typedef std::chrono::nanoseconds ns;
@@ -32,7 +39,7 @@ typedef std::chrono::nanoseconds ns;
 const std::string keys =
     "{h                 | | Print Help Message}"
     "{model_path        | | Required. Path to an openvino ir model(.xml).}"
-    "{data_path         | | Required. Path to a folder with images for inference.}"
+    "{data_path         | | Required. Path to a folder with images, or to a raw YUV (.yuv) or Y4M (.y4m) file for inference.}"
     "{extension         | | Optional option. Required for CPU custom layers. Absolute path to a shared library with the kernels implementations. }"
     "{device            |CPU| Optional. Specify a target device to infer on, default: CPU. Use MULTI:<comma-separated_devices_list> format to specify MULTI device}"
     "{save_predictions  |false| Optional. Whether to save the infer results to <save_path> or not.}"
@@ -44,6 +51,13 @@ const std::string keys =
     "{precision         |f32| Optional. For inference precision.fp32:f32, fp16:f16, bf16:bf16}"
     "{reshape_values    | | Optional. Reshape network to fit the input image size. e.g. --reshape_values=\"(1,3,720,1280)\"}"
     "{num_infer_req     | | Optional. Number of infer request number.}"
+    "{warmup            | | Optional. Number of synthetic inferences run on every infer request during initialization.}"
+    "{ring_size         |8| Optional. Number of frame group buffers in flight between decode, inference and encode.}"
+    "{decode_threads    |2| Optional. Number of threads decoding input images.}"
+    "{encode_threads    |2| Optional. Number of threads encoding and writing predictions.}"
+    "{input_format      |yuv420p| Optional. Pixel format of a raw YUV data_path: yuv420p, yuv420p10le, yuv444p or yuv444p10le.}"
+    "{input_res         | | Optional. Resolution of a raw YUV data_path, e.g. --input_res=1920x1080.}"
+    "{luma_only         | | Optional. Chroma filter, bicubic or lanczos. Only the Y plane of a 4:2:0 YUV data_path is inferred by a Y-input model.}"
    ;
 
 bool checkPath(const std::string& path){
@@ -60,6 +74,17 @@ bool checkPath(const std::string& path){
 }
 
 
+// raw YUV and Y4M inputs are files, image inputs are folders
+bool isFrameFile(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+std::string baseName(const std::string& path) {
+    auto pos = path.find_last_of('/');
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
 int getFileNames(std::string path,std::vector<std::string>& filenames)
 {
     DIR *pDir;
@@ -137,37 +162,6 @@ void imagesFromBlob(const cv::Mat& blob_, std::vector<cv::Mat>& images_)
     }
 }
 
-std::mutex _mutex;
-size_t count = 0;
-struct callback_args{
-    int flag;
-    int nif;
-    Time::time_point time;
-    callback_args():flag(0), nif(0){}
-    callback_args(int f, int nif, Time::time_point t):flag(f),nif(nif),time(t){}
-};
-
-
-void completion_callback (void *args)
-{
-#ifdef ENABLE_LOG
-    std::cout << "[Trace]: "<< "vsr_sample callback called." << std::endl;
-#endif
-    callback_args * cb_args = (callback_args*)args;
-    cb_args->flag = 1;
-
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        count += 1;
-    }
-#ifdef ENABLE_PERF
-    auto duration = get_duration_ms_till_now(cb_args->time);
-    std::cout << "Finished group id: " << (count - 1) <<std::endl;
-    std::cout << "[PERF] " << "Process Latency: " << double_to_string(duration) <<"ms"<<std::endl;
-    std::cout << "[PERF] " << "Process Throughput: " << double_to_string(cb_args->nif * 1000.0 / duration) <<"FPS"<<std::endl;
-#endif
-}
-
 bool commandLineCheck(int argc, char**argv,std::string keys){
     for(int i = 1; i < argc; i++){
         std::string arg(argv[i]);
@@ -189,6 +183,70 @@ bool commandLineCheck(int argc, char**argv,std::string keys){
     return true;
 }
 
+// Unbounded queue, the number of frame group buffers in the ring bounds its size.
+template <typename T>
+class BlockingQueue {
+public:
+    void push(T value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(value));
+        }
+        cv_.notify_one();
+    }
+
+    // false once the queue is closed and empty, waitedMs accumulates the time spent blocked
+    bool pop(T& value, double& waitedMs) {
+        auto startTime = Time::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+            return !queue_.empty() || closed_;
+        });
+        waitedMs += get_duration_ms_till_now(startTime);
+        if (queue_.empty())
+            return false;
+        value = std::move(queue_.front());
+        queue_.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::deque<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool closed_ = false;
+};
+
+// One input group and its prediction, recycled through the ring.
+struct FrameSlot {
+    size_t group = 0;
+    std::vector<uint8_t> input;  // nif x H x W x 3, BGR
+    uint8_t* mappedInput = nullptr;  // YUV frame inside the input file mapping in luma-only mode, used instead of input
+    std::vector<float> output;   // nif x 3 x (H * scale) x (W * scale)
+    IVSRStatus status = OK;
+};
+
+// Time a pipeline stage spent working and blocked, summed over its threads.
+struct StageStats {
+    std::mutex mutex;
+    double busyMs = 0.0;
+    double waitMs = 0.0;
+
+    void add(double busy, double wait) {
+        std::lock_guard<std::mutex> lock(mutex);
+        busyMs += busy;
+        waitMs += wait;
+    }
+};
+
 void print_tensor_desc(const tensor_desc_t* tensor) {
     if (!tensor) {
         printf("Invalid tensor descriptor!\n");
@@ -214,7 +272,6 @@ void print_tensor_desc(const tensor_desc_t* tensor) {
     printf("]\n");
 }
 
-using IVSRFunction = std::function<IVSRStatus(ivsr_handle, char*, char*, ivsr_cb_t*)>;
 
 int main(int argc, char** argv){
     // -------- Parsing and validation of input arguments --------
@@ -250,7 +307,8 @@ int main(int argc, char** argv){
         return -1;
     }
     // input and output path check
-    if(!checkPath(data_path)){
+    const bool frameFile = isFrameFile(data_path);
+    if(!frameFile && !checkPath(data_path)){
         std::cout << "Invalid input directory path!" << std::endl;
         std::cout << "Directory NOT found or PATH ended with '/' " << std::endl;
         std::cout << "Please confirm your path is existed and does NOT end with '/' " << std::endl;
@@ -266,16 +324,49 @@ int main(int argc, char** argv){
     // 0. Check inputs and retrieve input frame resolution
     std::cout << "[INFO] " << "Inputs Path: " << data_path << std::endl;
     std::vector<std::string> filePathList;
-    getFileNames(data_path, filePathList);
-    if (filePathList.size() == 0) {
-        std::cout << "No file in input directory path!" << std::endl;
-        return -1;
-    }
-    std::string imgPath = data_path + "/" + filePathList[0];
-    cv::Mat img = cv::imread(imgPath, cv::IMREAD_COLOR);
+    std::unique_ptr<FrameReader> frameReader;
     unsigned int frameHeight = 0, frameWidth = 0;
-    frameHeight = img.rows;
-    frameWidth  = img.cols;
+    size_t inputFrames = 0;
+    auto luma_only = parser.get<std::string>("luma_only");
+    if (frameFile) {
+        // frames are read in place from the mapped file, no per-frame file open or decode
+        FrameFormat rawFormat;
+        auto input_format = parser.get<std::string>("input_format");
+        auto raw_res = parser.get<std::string>("input_res");
+        if (!parse_pixel_format(input_format, rawFormat)) {
+            std::cout << "Unsupported input_format: " << input_format << std::endl;
+            return -1;
+        }
+        if (!raw_res.empty() && sscanf(raw_res.c_str(), "%dx%d", &rawFormat.width, &rawFormat.height) != 2) {
+            std::cout << "Invalid input_res: " << raw_res << ", expected <width>x<height>" << std::endl;
+            return -1;
+        }
+        frameReader = FrameReader::open(data_path, rawFormat);
+        if (!frameReader)
+            return -1;
+        frameWidth = frameReader->format().width;
+        frameHeight = frameReader->format().height;
+        inputFrames = frameReader->frame_count();
+        if (!luma_only.empty() && frameReader->format().chroma != ChromaFormat::YUV420) {
+            std::cout << "luma_only requires a 4:2:0 input!" << std::endl;
+            return -1;
+        }
+    } else {
+        getFileNames(data_path, filePathList);
+        if (filePathList.size() == 0) {
+            std::cout << "No file in input directory path!" << std::endl;
+            return -1;
+        }
+        std::string imgPath = data_path + "/" + filePathList[0];
+        cv::Mat img = cv::imread(imgPath, cv::IMREAD_COLOR);
+        frameHeight = img.rows;
+        frameWidth  = img.cols;
+        inputFrames = filePathList.size();
+        if (!luma_only.empty()) {
+            std::cout << "luma_only requires a YUV data_path!" << std::endl;
+            return -1;
+        }
+    }
 
     // 1. set ivsr config
     std::list<ivsr_config_t *> configs;
@@ -310,6 +401,9 @@ int main(int argc, char** argv){
     auto nireq = parser.get<std::string>("num_infer_req");
     if (!nireq.empty()) add_config(IVSRConfigKey::INFER_REQ_NUMBER, nireq.c_str());
 
+    auto warmup = parser.get<std::string>("warmup");
+    if (!warmup.empty()) add_config(IVSRConfigKey::WARMUP_ITERATIONS, warmup.c_str());
+
     // in format "<width>,<height>"
     std::string input_res = std::to_string(frameWidth) + "," + std::to_string(frameHeight);
     add_config(IVSRConfigKey::INPUT_RES, input_res.c_str());
@@ -338,6 +432,15 @@ int main(int argc, char** argv){
                                             .dimension = dimension_set,
                                             .shape = {0, 0, 0, 0}};
 
+    if (!luma_only.empty()) {
+        // planar YUV buffers, the Y plane is the NCHW input of a one channel model
+        add_config(IVSRConfigKey::LUMA_ONLY, luma_only.c_str());
+        strcpy(input_tensor_desc_set.precision, frameReader->format().bitDepth > 8 ? "u16" : "u8");
+        strcpy(input_tensor_desc_set.layout, "NCHW");
+        input_tensor_desc_set.tensor_color_format[0] = '\0';
+        input_tensor_desc_set.model_color_format[0] = '\0';
+    }
+
     add_config(IVSRConfigKey::INPUT_TENSOR_DESC_SETTING, &input_tensor_desc_set);
     add_config(IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING, &output_tensor_desc_set);
 
@@ -361,106 +464,251 @@ int main(int argc, char** argv){
         std::cout <<"Failed to get the attribute: " << IVSRAttrKey::NUM_INPUT_FRAMES <<std::endl;
         return -1;
     }
-    // 3. prepare input data
+    // 3. prepare the pipeline, memory is bounded by the ring size instead of the number of groups
     // 3.1 Check the input frames
-    if(filePathList.size() < (size_t)nif) {
+    if(inputFrames < (size_t)nif) {
         std::cout << "Not enough frames for an inference!" << std::endl;
         std::cout << "At least NIF frames in the data_path are needed!" << std::endl;
         return -1;
     }
-    std::vector<cv::Mat> inputDataList;
-    std::vector<cv::Mat> outputDataList;
-    int oriHeight =0,oriWidth=0;
-    for(size_t idx =0; idx < filePathList.size() && idx < (size_t)nig * nif; idx += nif){
-        // 3.2 Read input images and preprocess with opencv
-        std::vector<cv::Mat> inMatList;
-        for(int i = 0; i < nif; i++){
-            std::string filePath = data_path + "/" + filePathList[idx + i];
+    // nig=0 processes every complete group of the data_path
+    size_t totalGroups = inputFrames / nif;
+    if (nig > 0 && (size_t)nig < totalGroups)
+        totalGroups = nig;
+
+    int ringSize = parser.get<int>("ring_size");
+    int decodeThreads = parser.get<int>("decode_threads");
+    int encodeThreads = parser.get<int>("encode_threads");
+    if (ringSize < 1 || decodeThreads < 1 || encodeThreads < 1) {
+        std::cout << "ring_size, decode_threads and encode_threads must be positive!" << std::endl;
+        return -1;
+    }
+
+    const int oriHeight = frameHeight, oriWidth = frameWidth;
+    const size_t frameSize = (size_t)oriHeight * oriWidth * 3;
+    const bool lumaOnly = !luma_only.empty();
+    std::vector<FrameSlot> slots(ringSize);
+    BlockingQueue<FrameSlot*> freeSlots, decodedSlots, inferredSlots;
+    for (auto& slot : slots) {
+        // luma-only input is consumed from the mapping, the output is fp32 planar YUV 4:2:0
+        if (!lumaOnly)
+            slot.input.resize(frameSize * nif);
+        slot.output.resize(lumaOnly ? FrameFormat{oriWidth * scaleFactor, oriHeight * scaleFactor}.frame_bytes()
+                                    : frameSize * nif * scaleFactor * scaleFactor);
+        freeSlots.push(&slot);
+    }
+
+    // YUV predictions go to one file of the input container and pixel format, written in place
+    std::unique_ptr<FrameWriter> frameWriter;
+    if (frameFile && save_predictions) {
+        FrameFormat outFormat = frameReader->format();
+        outFormat.width *= scaleFactor;
+        outFormat.height *= scaleFactor;
+        std::string outPath = save_path + "/" + baseName(data_path);
+        frameWriter = FrameWriter::create(outPath, outFormat, totalGroups * nif, is_y4m_file(data_path),
+                                          frameReader->y4m_params());
+        if (!frameWriter)
+            return -1;
+        std::cout << "[INFO] " << "Outputs Path: " << outPath << std::endl;
+    }
+
+    std::cout << "[INFO] " << "Inference start: " << totalGroups << " groups, ring of " << ringSize << std::endl;
+    auto totalStartTime = Time::now();
+
+    // 3.2 decode pool, groups may complete out of order, every slot carries its group index
+    std::atomic<size_t> nextGroup{0};
+    StageStats decodeStats, submitStats, encodeStats;
+    auto decode = [&]() {
+        double busy = 0.0, wait = 0.0;
+        FrameSlot* slot = nullptr;
+        while (freeSlots.pop(slot, wait)) {
+            size_t group = nextGroup++;
+            if (group >= totalGroups) {
+                freeSlots.push(slot);
+                break;
+            }
+            auto startTime = Time::now();
+            slot->group = group;
+            slot->status = OK;
+            if (frameReader) {
+                // the kernel reads the frames of the next ring round while this one is converted
+                frameReader->prefetch((group + ringSize) * nif, nif);
+                for (int i = 0; i < nif; i++) {
+                    const uint8_t* frame = frameReader->frame(group * nif + i);
+                    if (lumaOnly)
+                        slot->mappedInput = const_cast<uint8_t*>(frame);
+                    else
+                        frame_to_bgr(frame, frameReader->format(), slot->input.data() + i * frameSize);
+                }
+                busy += get_duration_ms_till_now(startTime);
+                decodedSlots.push(slot);
+                continue;
+            }
+            for (int i = 0; i < nif; i++) {
+                std::string filePath = data_path + "/" + filePathList[group * nif + i];
 #ifdef ENABLE_LOG
-            std::cout << "Reading image: " << filePath << std::endl;
+                std::cout << "Reading image: " << filePath << std::endl;
 #endif
-            cv::Mat img = cv::imread(filePath, cv::IMREAD_COLOR);
-            inMatList.push_back(img);
+                cv::Mat img = cv::imread(filePath, cv::IMREAD_COLOR);
+                if (img.empty() || img.rows != oriHeight || img.cols != oriWidth || !img.isContinuous()) {
+                    std::cout << "Invalid image or resolution mismatch: " << filePath << std::endl;
+                    slot->status = GENERAL_ERROR;
+                    break;
+                }
+                memcpy(slot->input.data() + i * frameSize, img.data, frameSize);
+            }
+            busy += get_duration_ms_till_now(startTime);
+            decodedSlots.push(slot);
         }
+        decodeStats.add(busy, wait);
+    };
 
-        // check images' shape
-        oriHeight = inMatList[0].rows, oriWidth = inMatList[0].cols;
-        /* how to check image size and model input? */
-
-        // refer to cv::dnn::blobFromImages
-        cv::Mat inputNHWC = inMatList[0]; //blobFromImages(inMatList, normalize_factor/255.0, true);
-        int sz[] = { 1, nif, oriHeight, oriWidth, 3 };
-        cv::Mat inputImg(5, sz, CV_8U, (char *)inputNHWC.data);
-        inputDataList.push_back(inputImg.clone());
-
-        int outputSize[] = {1, nif, 3, oriHeight * scaleFactor, oriWidth * scaleFactor};
-        cv::Mat outputImg = cv::Mat::zeros(5, outputSize, CV_32F);
-        outputDataList.push_back(outputImg.clone());
-    }
+    // 3.3 encode pool, slots go back to the ring once written
+    std::atomic<size_t> failedGroups{0};
+    auto encode = [&]() {
+        double busy = 0.0, wait = 0.0;
+        FrameSlot* slot = nullptr;
+        while (inferredSlots.pop(slot, wait)) {
+            auto startTime = Time::now();
+            if (slot->status != OK) {
+                std::cout << "Failed to process the inference on input data seq." << slot->group << std::endl;
+                failedGroups++;
+            } else if (frameWriter) {
+                // 5. convert predictions into the mapped output file
+                const size_t outPlaneSize = (size_t)oriHeight * scaleFactor * oriWidth * scaleFactor;
+                for (int i = 0; i < nif; i++) {
+                    size_t index = slot->group * nif + i;
+                    if (lumaOnly)
+                        yuv_float_to_frame(slot->output.data(), normalize_factor, frameWriter->format(),
+                                           frameWriter->frame(index));
+                    else
+                        rgb_to_frame(slot->output.data() + i * 3 * outPlaneSize, normalize_factor,
+                                     frameWriter->format(), frameWriter->frame(index));
+                }
+                frameWriter->flush(slot->group * nif, nif);
+            } else if (save_predictions) {
+                // 5. post process and save outputs
+                int nchwSize[] = {nif, 3, oriHeight * scaleFactor, oriWidth * scaleFactor};
+                cv::Mat outputF32(4, nchwSize, CV_32F, (void*)slot->output.data());
+                cv::Mat outputNCHW;
+                outputF32.convertTo(outputNCHW, CV_8U, normalize_factor);
+                std::vector<cv::Mat> outMatList;
+                imagesFromBlob(outputNCHW, outMatList);
+                for (int i = 0; i < nif; i++) {
+                    std::string filePath = save_path + "/" + filePathList[slot->group * nif + i];
+#ifdef ENABLE_LOG
+                    std::cout << "[Trace]: "
+                              << "Saving image: " << filePath << std::endl;
+#endif
+                    cv::imwrite(filePath, outMatList[i]);
+                }
+            }
+            if (frameReader)
+                frameReader->release(slot->group * nif, nif);
+            busy += get_duration_ms_till_now(startTime);
+            freeSlots.push(slot);
+        }
+        encodeStats.add(busy, wait);
+    };
 
-    std::cout << "[INFO] " << "Inference start: " << std::endl;
+    // 4. inference, one thread submits decoded groups while this thread collects completions
+    std::mutex inflightMutex;
+    std::unordered_map<ivsr_token_t, FrameSlot*> inflight;
+    std::atomic<size_t> submitted{0};
+    std::atomic<bool> submitDone{false};
+    auto submit = [&]() {
+        double busy = 0.0, wait = 0.0;
+        FrameSlot* slot = nullptr;
+        for (size_t n = 0; n < totalGroups && decodedSlots.pop(slot, wait); n++) {
+            if (slot->status != OK) {
+                inferredSlots.push(slot);
+                continue;
+            }
+            auto startTime = Time::now();
+            // registered before the poller can see the token
+            std::lock_guard<std::mutex> lock(inflightMutex);
+            ivsr_token_t token = 0;
+            char* input = slot->mappedInput ? (char*)slot->mappedInput : (char*)slot->input.data();
+            IVSRStatus result = ivsr_submit(handle, input, (char*)slot->output.data(), nullptr, &token);
+            if (result < 0) {
+                slot->status = result;
+                inferredSlots.push(slot);
+            } else {
+                inflight[token] = slot;
+                submitted++;
+            }
+            busy += get_duration_ms_till_now(startTime);
+        }
+        submitStats.add(busy, wait);
+        submitDone = true;
+    };
 
-    size_t id = 0;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < decodeThreads; i++)
+        workers.emplace_back(decode);
+    for (int i = 0; i < encodeThreads; i++)
+        workers.emplace_back(encode);
+    std::thread submitter(submit);
+
+    ivsr_event_t events[16];
+    double inferMs = 0.0;
+    for (size_t finished = 0; !submitDone || finished < submitted;) {
+        size_t num_events = 0;
+        if (ivsr_poll(handle, events, sizeof(events) / sizeof(events[0]), 100, &num_events) != OK)
+            continue;
+        finished += num_events;
+        std::lock_guard<std::mutex> lock(inflightMutex);
+        for (size_t i = 0; i < num_events; i++) {
+            auto it = inflight.find(events[i].token);
+            FrameSlot* slot = it->second;
+            inflight.erase(it);
+            slot->status = events[i].status;
+            inferMs += events[i].infer_time;
 #ifdef ENABLE_PERF
-    auto totalStartTime = Time::now();
+            std::cout << "Finished group id: " << slot->group << std::endl;
+            std::cout << "[PERF] " << "Process Latency: " << double_to_string(events[i].total_time) << "ms"
+                      << " (queue " << double_to_string(events[i].queue_time) << "ms, infer "
+                      << double_to_string(events[i].infer_time) << "ms)" << std::endl;
 #endif
-
-    IVSRFunction process_fn = nireq.empty() ? ivsr_process : ivsr_process_async;
-    for (; id < inputDataList.size() && id < outputDataList.size(); id++) {
-        auto inputImg = inputDataList[id];
-        auto outputImg = outputDataList[id];
-        ivsr_cb_t cb;
-        auto startTime = Time::now();
-        callback_args cb_args(0, nif, startTime);
-        cb.ivsr_cb = completion_callback;
-        cb.args = (void*)(&cb_args);
-        // 4. inference
-        IVSRStatus result = process_fn(handle, (char*)inputImg.data, (char*)outputImg.data, &cb);
-        if (result < 0) {
-            std::cout << "Failed to process the inference on input data seq." << id << std::endl;
+            inferredSlots.push(slot);
         }
     }
+    submitter.join();
+    inferredSlots.close();
+    for (auto& worker : workers)
+        worker.join();
 
-    //wait for the completion callback
-    while (count != id) {
-        usleep(100);
-    }
-#ifdef ENABLE_PERF
     auto duration = get_duration_ms_till_now(totalStartTime);
-    std::cout << "[PERF] " << "Total processed groups: " << nig <<std::endl;
-    std::cout << "[PERF] " << "Total latency for all input groups: " << double_to_string(duration) <<"ms"<<std::endl;
-    std::cout << "[PERF] " << "Average throughput for all input groups: " << double_to_string(nig * nif * 1000.0 / duration) <<"FPS"<<std::endl;
-#endif
     std::cout << "[INFO] " << "Inference finished" << std::endl;
 
-    // save outputs
-    if (save_predictions) {
-        if (save_path == "") {
-            std::cout << "save_path is needed!" << std::endl;
-            return -1;
-        }
-        std::cout << "[INFO] "
-                  << " Saving outputs to path: " << save_path << std::endl;
-        for (size_t idx = 0; idx < outputDataList.size(); idx++) {
-            // 5. post process and save outputs
-            auto outputImg = outputDataList[idx];
-            outputImg.convertTo(outputImg, CV_8U, normalize_factor);
-            int nchwSize[] = {nif, 3, oriHeight * scaleFactor, oriWidth * scaleFactor};
-            cv::Mat outputNCHW(4, nchwSize, CV_8U, (void*)outputImg.data);
-            std::vector<cv::Mat> outMatList;
-            imagesFromBlob(outputNCHW, outMatList);
-
-            // save group
-            for (int i = 0; i < nif; i++) {
-                std::string filePath = save_path + "/" + filePathList[idx * nif + i];
-#ifdef ENABLE_LOG
-                std::cout << "[Trace]: "
-                          << "Saving image: " << filePath << std::endl;
-#endif
-                cv::imwrite(filePath, outMatList[i]);
-            }
-        }
+    // 4.1 capacity of every stage in frames per second, the slowest one bounds the pipeline
+    size_t frames = (totalGroups - failedGroups) * nif;
+    int inferRequests = nireq.empty() ? 1 : std::max(1, atoi(nireq.c_str()));
+    auto capacity = [frames](double busyMs, int parallel) {
+        return busyMs > 0.0 ? frames * 1000.0 * parallel / busyMs : 0.0;
+    };
+    struct StageReport {
+        const char* name;
+        double fps;
+        double waitMs;
+        const char* waitReason;
+    } stages[] = {
+        {"decode", capacity(decodeStats.busyMs, decodeThreads), decodeStats.waitMs, "waiting for a free slot"},
+        {"inference", capacity(inferMs, inferRequests), submitStats.waitMs, "submitter waiting for decoded groups"},
+        {"encode", capacity(encodeStats.busyMs, encodeThreads), encodeStats.waitMs, "waiting for inferred groups"},
+    };
+    const StageReport* bottleneck = nullptr;
+    for (const auto& stage : stages) {
+        std::cout << "[INFO] " << "Stage " << stage.name << ": " << double_to_string(stage.fps) << " FPS capacity, "
+                  << double_to_string(stage.waitMs) << "ms " << stage.waitReason << std::endl;
+        if (stage.fps > 0.0 && (!bottleneck || stage.fps < bottleneck->fps))
+            bottleneck = &stage;
     }
+    std::cout << "[INFO] " << "Processed " << frames << " frames in " << double_to_string(duration) << "ms, "
+              << double_to_string(frames * 1000.0 / duration) << " FPS";
+    if (bottleneck)
+        std::cout << ", bottleneck: " << bottleneck->name;
+    std::cout << std::endl;
 
     //release resources
     res = ivsr_deinit(handle);
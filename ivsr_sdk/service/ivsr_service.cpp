@@ -0,0 +1,613 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_service.cpp
+ * local inference service: holds the compiled models and infer requests of all SERVICE_SOCKET
+ * handles of the host. Handles with the same configs share one model and its request pool,
+ * frames are read from and written to the shared memory buffers of the clients in place.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "ivsr.h"
+#include "ivsr_service.hpp"
+#include "utils.hpp"
+
+using namespace service;
+using Clock = std::chrono::steady_clock;
+
+static bool verbose = false;
+
+// a client buffer mapped into the service, unmapped once removed and no submission uses it
+struct Mapping {
+    char* data = nullptr;
+    size_t size = 0;
+
+    ~Mapping() {
+        if (data)
+            munmap(data, size);
+    }
+};
+
+struct Session;
+
+// a submission between SUBMIT and DONE
+struct InFlight {
+    std::shared_ptr<Session> session;
+    uint64_t id = 0;
+    std::shared_ptr<Mapping> input;
+    std::shared_ptr<Mapping> output;
+    Clock::time_point received;
+    ivsr_cb_t cb = {nullptr, nullptr};  // try submissions, the task keeps a pointer to it
+};
+
+/**
+ * A compiled model and its infer requests, shared by all sessions with the same configs.
+ * Stateful TEMPORAL_WINDOW models belong to a single session.
+ */
+struct Model {
+    std::string key;  // serialized configs
+    bool shared = true;
+    ivsr_handle handle = nullptr;
+    InitReply info{};
+    std::shared_future<IVSRStatus> ready;
+    int refs = 0;
+
+    // ivsr_submit blocks while no request is free and splits frames into patches on the calling
+    // thread, submissions are serialized while the inferences overlap in the request pool
+    std::mutex submitMutex;
+
+    // completions of ivsr_submit, an event may be polled before its token is registered
+    std::thread poller;
+    std::atomic<bool> stopping{false};
+    std::mutex tokenMutex;
+    std::unordered_map<ivsr_token_t, std::unique_ptr<InFlight>> tokens;
+    std::unordered_map<ivsr_token_t, ivsr_event_t> orphans;
+};
+
+struct Session {
+    int sock = -1;
+    std::mutex sendMutex;
+    std::shared_ptr<Model> model;
+    std::unordered_map<uint32_t, std::shared_ptr<Mapping>> buffers;  // session thread only
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t inFlight = 0;
+
+    void send(MsgType type, uint64_t id, IVSRStatus status, const void* payload = nullptr, size_t bytes = 0) {
+        MsgHeader header = {type, status, id, static_cast<uint32_t>(bytes), 0};
+        std::lock_guard<std::mutex> lock(sendMutex);
+        // a client which went away is noticed by the session thread
+        send_message(sock, header, payload);
+    }
+
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() {
+            return inFlight == 0;
+        });
+    }
+};
+
+static std::mutex registryMutex;
+static std::map<std::string, std::shared_ptr<Model>> registry;
+
+static void finish(InFlight& task, IVSRStatus status, double queueTime, double inferTime) {
+    DoneMsg done = {queueTime, inferTime};
+    task.session->send(MsgType::DONE, task.id, status, &done, sizeof(done));
+    std::lock_guard<std::mutex> lock(task.session->mutex);
+    --task.session->inFlight;
+    task.session->cv.notify_all();
+}
+
+static void poll_completions(Model* model) {
+    ivsr_event_t events[16];
+    while (!model->stopping.load()) {
+        size_t count = 0;
+        if (ivsr_poll(model->handle, events, 16, 100, &count) != IVSRStatus::OK)
+            continue;
+        for (size_t i = 0; i < count; ++i) {
+            std::unique_ptr<InFlight> task;
+            {
+                std::lock_guard<std::mutex> lock(model->tokenMutex);
+                auto it = model->tokens.find(events[i].token);
+                if (it == model->tokens.end()) {
+                    model->orphans[events[i].token] = events[i];
+                    continue;
+                }
+                task = std::move(it->second);
+                model->tokens.erase(it);
+            }
+            finish(*task, events[i].status, events[i].queue_time, events[i].infer_time);
+        }
+    }
+}
+
+static void try_done(void* args) {
+    std::unique_ptr<InFlight> task(static_cast<InFlight*>(args));
+    // the queue wait of a try submission is not known, it is part of the inference time
+    double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - task->received).count();
+    finish(*task, IVSRStatus::OK, 0.0, elapsed);
+}
+
+
+// INPUT_RES "<width>,<height>" and DYNAMIC_SHAPE of the configs
+static void parse_frame_info(const std::vector<ivsr_config_t>& configs, InitReply& info) {
+    for (auto& config : configs) {
+        if (config.key == IVSRConfigKey::INPUT_RES) {
+            auto res = split(static_cast<const char*>(config.value), ',');
+            if (res.size() >= 2) {
+                info.width = static_cast<uint32_t>(std::stoul(res[0]));
+                info.height = static_cast<uint32_t>(std::stoul(res[1]));
+            }
+        } else if (config.key == IVSRConfigKey::DYNAMIC_SHAPE) {
+            info.dynamicShape = 1;
+        }
+    }
+}
+
+static IVSRStatus load_model(Model& model, const std::vector<char>& blob) {
+    std::vector<ivsr_config_t> configs;
+    if (!deserialize_config(blob, configs) || configs.empty()) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "malformed configs from a client");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    IVSRStatus status;
+    try {
+        parse_frame_info(configs, model.info);
+        status = ivsr_init(configs.data(), &model.handle);
+    } catch (const std::exception& e) {
+        ivsr_status_log(IVSRStatus::EXCEPTION_ERROR, e.what());
+        status = IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    if (status != IVSRStatus::OK) {
+        model.handle = nullptr;
+        return status;
+    }
+
+    size_t input_bytes = 0, output_bytes = 0;
+    ivsr_get_attr(model.handle, IVSRAttrKey::INPUT_FRAME_BYTES, &input_bytes);
+    ivsr_get_attr(model.handle, IVSRAttrKey::OUTPUT_FRAME_BYTES, &output_bytes);
+    model.info.inputBytes = input_bytes;
+    model.info.outputBytes = output_bytes;
+    model.poller = std::thread(poll_completions, &model);
+    return IVSRStatus::OK;
+}
+
+static void unload_model(Model& model) {
+    if (model.handle == nullptr)
+        return;
+    model.stopping = true;
+    if (model.poller.joinable())
+        model.poller.join();
+    ivsr_deinit(model.handle);
+    model.handle = nullptr;
+}
+
+// the first session of a config compiles the model, later ones wait for it and share it
+static IVSRStatus acquire_model(const std::vector<char>& blob, std::shared_ptr<Model>& acquired) {
+    std::vector<ivsr_config_t> configs;
+    if (!deserialize_config(blob, configs)) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "malformed configs from a client");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    bool shared = true;
+    for (auto& config : configs) {
+        if (config.key == IVSRConfigKey::TEMPORAL_WINDOW)
+            shared = false;
+    }
+
+    std::string key(blob.begin(), blob.end());
+    std::shared_ptr<Model> model;
+    std::promise<IVSRStatus> loaded;
+    bool creator = false;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto it = shared ? registry.find(key) : registry.end();
+        if (it != registry.end()) {
+            model = it->second;
+            ++model->refs;
+        } else {
+            model = std::make_shared<Model>();
+            model->key = key;
+            model->shared = shared;
+            model->refs = 1;
+            model->ready = loaded.get_future().share();
+            if (shared)
+                registry[key] = model;
+            creator = true;
+        }
+    }
+
+    if (creator) {
+        IVSRStatus status = load_model(*model, blob);
+        if (status != IVSRStatus::OK && shared) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.erase(key);
+        }
+        if (verbose && status == IVSRStatus::OK)
+            std::cout << "[INFO] " << "Model loaded, " << (shared ? "shared" : "private to the session") << std::endl;
+        loaded.set_value(status);
+    } else if (verbose) {
+        std::cout << "[INFO] " << "Sharing a loaded model" << std::endl;
+    }
+
+    IVSRStatus status = model->ready.get();
+    if (status != IVSRStatus::OK)
+        return status;
+    acquired = std::move(model);
+    return IVSRStatus::OK;
+}
+
+static void release_model(std::shared_ptr<Model>& model) {
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        last = --model->refs == 0;
+        if (last && model->shared)
+            registry.erase(model->key);
+    }
+    if (last) {
+        unload_model(*model);
+        if (verbose)
+            std::cout << "[INFO] " << "Model released" << std::endl;
+    }
+    model.reset();
+}
+
+// Resolve a buffer reference, the region must hold bytes.
+static std::shared_ptr<Mapping> find_buffer(Session& session, const BufferRef& ref, size_t bytes) {
+    auto it = session.buffers.find(ref.buffer);
+    if (it == session.buffers.end() || ref.offset > it->second->size || it->second->size - ref.offset < bytes)
+        return nullptr;
+    return it->second;
+}
+
+static IVSRStatus handle_submit(const std::shared_ptr<Session>& session, uint64_t id, const std::vector<char>& payload) {
+    if (payload.size() != sizeof(SubmitMsg))
+        return IVSRStatus::GENERAL_ERROR;
+    SubmitMsg msg;
+    memcpy(&msg, payload.data(), sizeof(msg));
+    Model& model = *session->model;
+    const ivsr_task_option_t* option = msg.hasOption ? &msg.option : nullptr;
+
+    std::unique_ptr<InFlight> task(new InFlight());
+    task->session = session;
+    task->id = id;
+    task->received = Clock::now();
+    task->input = find_buffer(*session, msg.input, frame_bytes(model.info.inputBytes, model.info, option));
+    task->output = find_buffer(*session, msg.output, frame_bytes(model.info.outputBytes, model.info, option));
+    if (!task->input || !task->output) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "submission outside of the shared buffers of the client");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    char* input = task->input->data + msg.input.offset;
+    char* output = task->output->data + msg.output.offset;
+
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        ++session->inFlight;
+    }
+    auto cancel = [&session]() {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        --session->inFlight;
+        session->cv.notify_all();
+    };
+
+    if (msg.kind == SubmitKind::TRY) {
+        // a submission waiting for a free request holds the lock, so none is free
+        std::unique_lock<std::mutex> lock(model.submitMutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            cancel();
+            return IVSRStatus::WOULD_BLOCK;
+        }
+        InFlight* pending = task.release();
+        pending->cb = {try_done, pending};
+        IVSRStatus status = ivsr_try_process_async(model.handle, input, output, &pending->cb, option);
+        if (status != IVSRStatus::OK) {
+            delete pending;
+            cancel();
+        }
+        return status;
+    }
+
+    ivsr_token_t token = 0;
+    IVSRStatus status;
+    {
+        std::lock_guard<std::mutex> lock(model.submitMutex);
+        status = ivsr_submit(model.handle, input, output, option, &token);
+    }
+    if (status != IVSRStatus::OK) {
+        cancel();
+        return status;
+    }
+
+    ivsr_event_t event;
+    {
+        std::lock_guard<std::mutex> lock(model.tokenMutex);
+        auto orphan = model.orphans.find(token);
+        if (orphan == model.orphans.end()) {
+            model.tokens[token] = std::move(task);
+            return IVSRStatus::OK;
+        }
+        event = orphan->second;
+        model.orphans.erase(orphan);
+    }
+    // finished before it was registered, the client accepts DONE ahead of the REPLY
+    finish(*task, event.status, event.queue_time, event.infer_time);
+    return IVSRStatus::OK;
+}
+
+static void run_session(int sock) {
+    auto session = std::make_shared<Session>();
+    session->sock = sock;
+    if (verbose)
+        std::cout << "[INFO] " << "Client connected" << std::endl;
+
+    MsgHeader header;
+    std::vector<char> payload;
+    int fd = -1;
+    while (recv_message(sock, header, payload, &fd)) {
+        IVSRStatus status = IVSRStatus::OK;
+        std::vector<char> reply;
+
+        if (header.type != MsgType::INIT && !session->model) {
+            status = IVSRStatus::GENERAL_ERROR;
+        } else {
+            switch (header.type) {
+            case MsgType::INIT:
+                if (session->model) {
+                    status = IVSRStatus::GENERAL_ERROR;
+                    break;
+                }
+                status = acquire_model(payload, session->model);
+                if (status == IVSRStatus::OK) {
+                    reply.resize(sizeof(InitReply));
+                    memcpy(reply.data(), &session->model->info, sizeof(InitReply));
+                }
+                break;
+            case MsgType::GET_ATTR: {
+                int32_t key = 0;
+                size_t bytes = 0;
+                if (payload.size() == sizeof(key)) {
+                    memcpy(&key, payload.data(), sizeof(key));
+                    bytes = attr_value_bytes(static_cast<IVSRAttrKey>(key));
+                }
+                if (bytes == 0) {
+                    status = IVSRStatus::UNSUPPORTED_KEY;
+                    break;
+                }
+                reply.resize(bytes);
+                status = ivsr_get_attr(session->model->handle, static_cast<IVSRAttrKey>(key), reply.data());
+                if (status != IVSRStatus::OK)
+                    reply.clear();
+                break;
+            }
+            case MsgType::ADD_BUFFER: {
+                AddBufferMsg msg;
+                struct stat info;
+                // an unsealed buffer could be truncated by the client while it is mapped here
+                int seals = fd >= 0 ? fcntl(fd, F_GET_SEALS) : -1;
+                if (payload.size() != sizeof(msg) || fd < 0 || fstat(fd, &info) != 0 || seals < 0 ||
+                    (seals & kBufferSeals) != kBufferSeals) {
+                    status = IVSRStatus::GENERAL_ERROR;
+                    break;
+                }
+                memcpy(&msg, payload.data(), sizeof(msg));
+                void* data = MAP_FAILED;
+                if (msg.size > 0 && static_cast<uint64_t>(info.st_size) >= msg.size)
+                    data = mmap(nullptr, msg.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (data == MAP_FAILED) {
+                    status = IVSRStatus::GENERAL_ERROR;
+                    break;
+                }
+                auto mapping = std::make_shared<Mapping>();
+                mapping->data = static_cast<char*>(data);
+                mapping->size = msg.size;
+                session->buffers[msg.buffer] = std::move(mapping);
+                break;
+            }
+            case MsgType::REMOVE_BUFFER: {
+                uint32_t buffer = 0;
+                if (payload.size() == sizeof(buffer))
+                    memcpy(&buffer, payload.data(), sizeof(buffer));
+                status = session->buffers.erase(buffer) ? IVSRStatus::OK : IVSRStatus::GENERAL_ERROR;
+                break;
+            }
+            case MsgType::SUBMIT:
+                status = handle_submit(session, header.id, payload);
+                break;
+            case MsgType::PUSH_FRAME: {
+                BufferRef ref;
+                std::shared_ptr<Mapping> frame;
+                if (payload.size() == sizeof(ref)) {
+                    memcpy(&ref, payload.data(), sizeof(ref));
+                    frame = find_buffer(*session, ref, session->model->info.inputBytes);
+                }
+                status = frame ? ivsr_push_frame(session->model->handle, frame->data + ref.offset)
+                               : IVSRStatus::GENERAL_ERROR;
+                break;
+            }
+            case MsgType::DEINIT:
+                session->wait_idle();
+                release_model(session->model);
+                break;
+            default:
+                status = IVSRStatus::GENERAL_ERROR;
+                break;
+            }
+        }
+
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        session->send(MsgType::REPLY, header.id, status, reply.data(), reply.size());
+    }
+
+    // the client exited or closed the handle, its submissions still write into the buffers
+    session->wait_idle();
+    if (session->model)
+        release_model(session->model);
+    session->buffers.clear();
+    {
+        std::lock_guard<std::mutex> lock(session->sendMutex);
+        close(sock);
+        session->sock = -1;
+    }
+    if (verbose)
+        std::cout << "[INFO] " << "Client disconnected" << std::endl;
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void on_signal(int) {
+    stopRequested = 1;
+}
+
+static void usage(const char* name) {
+    std::cout << "Usage: " << name << " [--socket <path>] [--verbose]\n"
+              << "  --socket   Unix socket to listen on, $XDG_RUNTIME_DIR/ivsr_service.sock by default,\n"
+              << "             or /tmp/ivsr_service-<uid>/ivsr_service.sock without XDG_RUNTIME_DIR.\n"
+              << "             Clients set the same path in SERVICE_SOCKET or IVSR_SERVICE_SOCKET.\n"
+              << "  --verbose  log clients and model loads.\n";
+}
+
+// The socket lives in a directory only the user can enter: $XDG_RUNTIME_DIR, or a 0700 directory of the user
+// in /tmp. An existing one must be the user's own, not something planted by another user.
+static bool default_socket_path(std::string& path) {
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir != nullptr && runtime_dir[0] == '/') {
+        path = std::string(runtime_dir) + "/ivsr_service.sock";
+        return true;
+    }
+    std::string dir = "/tmp/ivsr_service-" + std::to_string(geteuid());
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        std::cerr << "[ERROR] " << "can not create " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (lstat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != geteuid() ||
+        (info.st_mode & 077) != 0) {
+        std::cerr << "[ERROR] " << dir << " is not a private directory of the user" << std::endl;
+        return false;
+    }
+    path = dir + "/ivsr_service.sock";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string socket_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    // handles of the service itself are always local
+    unsetenv("IVSR_SERVICE_SOCKET");
+    if (socket_path.empty() && !default_socket_path(socket_path))
+        return 1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] " << "socket path is too long: " << socket_path << std::endl;
+        return 1;
+    }
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+    // a socket left by a previous run is replaced, anything else at the path is not ours to remove
+    struct stat existing;
+    if (lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "[ERROR] " << socket_path << " exists and is not a socket" << std::endl;
+            return 1;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    // clients load models and libraries into the service, the socket is only for the user.
+    // The umask keeps it private from bind to chmod.
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    mode_t mask = umask(0177);
+    bool bound = listener >= 0 && bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+    umask(mask);
+    if (!bound || chmod(socket_path.c_str(), 0600) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "[ERROR] " << "can not listen on " << socket_path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "[INFO] " << "ivsr_service listening on " << socket_path << std::endl;
+    while (!stopRequested) {
+        // the signal may be delivered to any thread, the flag is checked twice a second
+        struct pollfd waiting = {listener, POLLIN, 0};
+        if (poll(&waiting, 1, 500) <= 0)
+            continue;
+        int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno != EINTR)
+                std::cerr << "[ERROR] " << "accept: " << strerror(errno) << std::endl;
+            continue;
+        }
+        // a peer of another user is refused even if the socket was made reachable to it
+        struct ucred peer;
+        socklen_t peer_bytes = sizeof(peer);
+        if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &peer_bytes) != 0 || peer.uid != geteuid()) {
+            std::cerr << "[WARNING] " << "client of another user rejected" << std::endl;
+            close(client);
+            continue;
+        }
+        std::thread(run_session, client).detach();
+    }
+
+    std::cout << "[INFO] " << "ivsr_service shutting down" << std::endl;
+    close(listener);
+    unlink(socket_path.c_str());
+    // sessions are not joined, clients see their connection closed by the exit
+    _exit(0);
+}
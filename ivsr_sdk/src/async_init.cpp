@@ -0,0 +1,140 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_async_init.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+// Handles initializing at the same time, every one of them compiles in parallel by default.
+// A limit keeps the peak memory of compilation down when many channels start together.
+class InitGate {
+public:
+    InitGate() {
+        const char* env = getenv("IVSR_INIT_THREADS");
+        if (env != nullptr) {
+            try {
+                limit_ = std::stoul(env);
+            } catch (const std::exception& e) {
+                limit_ = 0;
+            }
+        }
+    }
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+            return limit_ == 0 || running_ < limit_;
+        });
+        ++running_;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        cv_.notify_one();
+    }
+
+private:
+    size_t limit_ = 0;  // no limit
+    size_t running_ = 0;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+InitGate& init_gate() {
+    static InitGate gate;
+    return gate;
+}
+
+}  // namespace
+
+AsyncInit::AsyncInit(size_t queue_size) : queueSize_(queue_size) {}
+
+AsyncInit::~AsyncInit() {
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void AsyncInit::start(std::function<IVSRStatus()> init, std::function<void()> on_done) {
+    thread_ = std::thread([this, init, on_done]() {
+        init_gate().acquire();
+        IVSRStatus status = init();
+        init_gate().release();
+        finish(status);
+        if (on_done)
+            on_done();
+    });
+}
+
+void AsyncInit::finish(IVSRStatus status) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    status_ = status;
+    state_ = status == IVSRStatus::OK ? State::DRAINING : State::FAILED;
+    // submissions held meanwhile are appended and started in order too
+    while (!held_.empty()) {
+        Held submission = std::move(held_.front());
+        held_.pop_front();
+        lock.unlock();
+        submission(status);
+        lock.lock();
+    }
+    if (state_ == State::DRAINING) {
+        state_ = State::READY;
+        ready_.store(true, std::memory_order_release);
+    }
+    cv_.notify_all();
+}
+
+bool AsyncInit::hold(bool blocking, Held submission, IVSRStatus& status) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (state_ == State::FAILED) {
+        status = status_;
+        return true;
+    }
+    if (state_ == State::READY)
+        return false;
+    if (held_.size() < queueSize_) {
+        held_.push_back(std::move(submission));
+        status = IVSRStatus::OK;
+        return true;
+    }
+    if (state_ == State::INITIALIZING) {
+        status = IVSRStatus::NOT_READY;
+        return true;
+    }
+    // the held submissions go first, a new one waits until they are started
+    if (!blocking) {
+        status = IVSRStatus::WOULD_BLOCK;
+        return true;
+    }
+    cv_.wait(lock, [this] {
+        return state_ == State::READY;
+    });
+    return false;
+}
+
+IVSRStatus AsyncInit::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] {
+        return state_ == State::READY || state_ == State::FAILED;
+    });
+    return status_;
+}
+
+IVSRStatus AsyncInit::status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_ == State::READY || state_ == State::FAILED ? status_ : IVSRStatus::NOT_READY;
+}
@@ -0,0 +1,87 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_completion_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+ivsr_token_t CompletionQueue::add_pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ivsr_token_t token = next_token_++;
+    pending_.insert(token);
+    return token;
+}
+
+void CompletionQueue::cancel(ivsr_token_t token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(token);
+}
+
+void CompletionQueue::complete(const ivsr_event_t& event) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.erase(event.token) == 0)
+            return;
+        completed_.push_back(event);
+    }
+    cv_.notify_all();
+}
+
+template <typename Pred>
+bool CompletionQueue::wait_for(std::unique_lock<std::mutex>& lock, int timeout_ms, Pred pred) {
+    if (timeout_ms < 0) {
+        cv_.wait(lock, pred);
+        return true;
+    }
+    return cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), pred);
+}
+
+size_t CompletionQueue::poll(ivsr_event_t* events, size_t max_events, int timeout_ms) {
+    if (events == nullptr || max_events == 0)
+        return 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!wait_for(lock, timeout_ms, [this] {
+            return !completed_.empty();
+        }))
+        return 0;
+
+    size_t num = std::min(max_events, completed_.size());
+    std::copy(completed_.begin(), completed_.begin() + num, events);
+    completed_.erase(completed_.begin(), completed_.begin() + num);
+    return num;
+}
+
+IVSRStatus CompletionQueue::wait(ivsr_token_t token, int timeout_ms, ivsr_event_t* event) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto find_completed = [this, token] {
+        return std::find_if(completed_.begin(), completed_.end(), [token](const ivsr_event_t& e) {
+            return e.token == token;
+        });
+    };
+
+    if (find_completed() == completed_.end() && pending_.count(token) == 0)
+        return GENERAL_ERROR;
+
+    if (!wait_for(lock, timeout_ms, [&] {
+            return find_completed() != completed_.end();
+        }))
+        return TIMEOUT;
+
+    auto it = find_completed();
+    if (event != nullptr)
+        *event = *it;
+    completed_.erase(it);
+    return OK;
+}
@@ -0,0 +1,583 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file convert.cpp
+ * ivsr_convert: layout, channel order, type, scale and clamp in one pass over the image.
+ * Row kernels are templates on the sample types and layouts so the compiler vectorizes
+ * the inner loop, an AVX-512 or AVX2 build of every kernel is picked at runtime by cpu_isa().
+ * Those builds convert f16 with F16C, the generic one in software. Large destinations are
+ * stored non-temporal.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ivsr.h"
+#include "ivsr_cpu_isa.hpp"
+#include "omp.h"
+#include "utils.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define IVSR_CONVERT_X86 1
+#    include <immintrin.h>
+#endif
+
+namespace {
+
+// pixels of one column tile, the destination segment of a tile stays in L1 while every channel is written
+const int kTileWidth = 512;
+// images below this many samples are converted by the calling thread
+const size_t kParallelSamples = 1 << 16;
+
+inline float half_to_float(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t bits;
+    if (exp == 0x1f) {
+        bits = sign | 0x7f800000 | (mant << 13);  // inf, nan
+    } else if (exp != 0) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (mant != 0) {
+        // subnormal half, normal float
+        int shift = __builtin_clz(mant) - 21;
+        bits = sign | static_cast<uint32_t>(113 - shift) << 23 | ((mant << shift) & 0x3ff) << 13;
+    } else {
+        bits = sign;
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// round to nearest even, overflow goes to inf
+inline uint16_t float_to_half(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t absBits = bits & 0x7fffffff;
+    if (absBits >= 0x7f800000)
+        return sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0);
+    if (absBits >= 0x477ff000)  // rounds above the largest half
+        return sign | 0x7c00;
+    if (absBits < 0x38800000) {
+        // subnormal half, the float is scaled so its rounding is done by the FPU
+        float a;
+        memcpy(&a, &absBits, sizeof(a));
+        return sign | static_cast<uint16_t>(std::nearbyint(a * 16777216.0f));
+    }
+    uint32_t rounded = absBits + 0xfff + ((absBits >> 13) & 1);
+    return sign | static_cast<uint16_t>((rounded - 0x38000000) >> 13);
+}
+
+// integer samples are loaded as (raw >> shift) & mask and stored as value << shift,
+// the shift is the padding of MSB-aligned samples or the position of a channel in a packed word
+struct SampleU8 {
+    using type = uint8_t;
+    static const bool integer = true;
+    static const bool packed = false;
+    static float load(uint8_t v, int) {
+        return v;
+    }
+    static uint8_t store(float v, int) {
+        return static_cast<uint8_t>(static_cast<int>(v));
+    }
+};
+
+struct SampleU16 {
+    using type = uint16_t;
+    static const bool integer = true;
+    static const bool packed = false;
+    static float load(uint16_t v, int shift) {
+        return v >> shift;
+    }
+    static uint16_t store(float v, int shift) {
+        return static_cast<uint16_t>(static_cast<int>(v) << shift);
+    }
+};
+
+struct SampleF16 {
+    using type = uint16_t;
+    static const bool integer = false;
+    static const bool packed = false;
+    static float load(uint16_t v, int) {
+        return half_to_float(v);
+    }
+    static uint16_t store(float v, int) {
+        return float_to_half(v);
+    }
+};
+
+struct SampleF32 {
+    using type = float;
+    static const bool integer = false;
+    static const bool packed = false;
+    static float load(float v, int) {
+        return v;
+    }
+    static float store(float v, int) {
+        return v;
+    }
+};
+
+// all channels of a pixel in one word, channel c is at bit 10 * c, stored pixels are opaque
+struct SampleY410 {
+    using type = uint32_t;
+    static const bool integer = true;
+    static const bool packed = true;
+    static const int bits = 10;
+    static const uint32_t alpha = 3u << 30;
+    static float load(uint32_t v, int shift) {
+        return (v >> shift) & 0x3ff;
+    }
+    static uint32_t store(float v, int shift) {
+        return static_cast<uint32_t>(static_cast<int>(v)) << shift;
+    }
+};
+
+// f16 is converted in software unless the kernel is built for F16C
+struct IsaGeneric {
+    static const bool f16c = false;
+};
+
+#ifdef IVSR_CONVERT_X86
+// called once per tile, they are not inlined into kernels built for other targets
+struct IsaF16C {
+    static const bool f16c = true;
+
+    __attribute__((target("avx,f16c"))) static void load_halves(const uint16_t* src,
+                                                                                    int step,
+                                                                                    float* dst,
+                                                                                    int n) {
+        int x = 0;
+        if (step == 1) {
+            for (; x + 8 <= n; x += 8)
+                _mm256_storeu_ps(dst + x, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x))));
+        }
+        for (; x < n; ++x)
+            dst[x] = _cvtsh_ss(src[x * step]);
+    }
+
+    __attribute__((target("avx,f16c"))) static void store_halves(const float* src,
+                                                                                     uint16_t* dst,
+                                                                                     int step,
+                                                                                     int n) {
+        int x = 0;
+        if (step == 1) {
+            for (; x + 8 <= n; x += 8)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                                 _mm256_cvtps_ph(_mm256_loadu_ps(src + x), _MM_FROUND_TO_NEAREST_INT));
+        }
+        for (; x < n; ++x)
+            dst[x * step] = _cvtss_sh(src[x], _MM_FROUND_TO_NEAREST_INT);
+    }
+};
+#endif
+
+struct Arith {
+    float scale;
+    float divisor;
+    float postScale;
+    float lo;
+    float hi;
+};
+
+struct RowArgs {
+    const uint8_t* src;  // first sample of the row, channel 0
+    uint8_t* dst;
+    size_t srcPlane;  // bytes between channel planes of planar images
+    size_t dstPlane;
+    int width;
+    int channels;
+    const int* srcChannel;  // source channel of every destination channel
+    int srcShift;           // padding bits of MSB-aligned U16 samples
+    int dstShift;
+    bool steps;  // divisor or postScale is not 1
+    Arith arith;
+};
+
+// strided run of one channel within a tile
+template <typename S, typename D>
+struct Run {
+    const typename S::type* src;
+    int srcStep;
+    int srcShift;
+    typename D::type* dst;
+    int dstStep;
+    int dstShift;
+    bool first;  // first channel written to a packed destination word
+    int n;
+};
+
+template <bool Steps>
+__attribute__((always_inline)) inline float apply(float v, const Arith& m) {
+    v *= m.scale;
+    if (Steps) {
+        v /= m.divisor;
+        v *= m.postScale;
+    }
+    return std::min(std::max(v, m.lo), m.hi);
+}
+
+template <typename D>
+__attribute__((always_inline)) inline void store_sample(typename D::type* dst, float v, int shift, bool first) {
+    auto bits = D::store(D::integer ? std::nearbyint(v) : v, shift);
+    if constexpr (D::packed)
+        *dst = (first ? D::alpha : *dst) | bits;
+    else
+        *dst = bits;
+}
+
+template <typename S, typename D, typename Isa, bool Steps>
+__attribute__((always_inline)) inline void convert_run(const Run<S, D>& r, const RowArgs& a) {
+    // a local copy, stores to the destination can not alias it
+    const Arith m = a.arith;
+    const bool halves = std::is_same<S, SampleF16>::value || std::is_same<D, SampleF16>::value;
+    if constexpr (halves && Isa::f16c) {
+        // f16 through a float buffer so the F16C conversion and the arithmetic are both vectorized
+        float buf[kTileWidth];
+        if constexpr (std::is_same<S, SampleF16>::value)
+            Isa::load_halves(r.src, r.srcStep, buf, r.n);
+        else
+            for (int x = 0; x < r.n; ++x)
+                buf[x] = S::load(r.src[x * r.srcStep], r.srcShift);
+        for (int x = 0; x < r.n; ++x)
+            buf[x] = apply<Steps>(buf[x], m);
+        if constexpr (std::is_same<D, SampleF16>::value)
+            Isa::store_halves(buf, r.dst, r.dstStep, r.n);
+        else
+            for (int x = 0; x < r.n; ++x)
+                store_sample<D>(r.dst + x * r.dstStep, buf[x], r.dstShift, r.first);
+    } else {
+        for (int x = 0; x < r.n; ++x)
+            store_sample<D>(r.dst + x * r.dstStep, apply<Steps>(S::load(r.src[x * r.srcStep], r.srcShift), m),
+                            r.dstShift, r.first);
+    }
+}
+
+/**
+ * @brief one row, tile by tile, channel by channel.
+ * PC is the channel count of packed images known at compile time, 0 if it is not.
+ */
+template <typename S, typename D, bool SrcPlanar, bool DstPlanar, int PC, typename Isa>
+__attribute__((always_inline)) inline void convert_row(const RowArgs& a) {
+    using ST = typename S::type;
+    using DT = typename D::type;
+    const int C = PC ? PC : a.channels;
+    // a pixel of a packed sample type is one word whatever its channel count
+    const int srcStep = SrcPlanar || S::packed ? 1 : C;
+    const int dstStep = DstPlanar || D::packed ? 1 : C;
+    for (int x0 = 0; x0 < a.width; x0 += kTileWidth) {
+        Run<S, D> r;
+        r.srcStep = srcStep;
+        r.dstStep = dstStep;
+        r.n = std::min(kTileWidth, a.width - x0);
+        for (int c = 0; c < C; ++c) {
+            const int sc = a.srcChannel[c];
+            r.src = reinterpret_cast<const ST*>(a.src + (SrcPlanar ? a.srcPlane * sc : 0)) +
+                    (SrcPlanar || S::packed ? x0 : x0 * C + sc);
+            r.dst = reinterpret_cast<DT*>(a.dst + (DstPlanar ? a.dstPlane * c : 0)) +
+                    (DstPlanar || D::packed ? x0 : x0 * C + c);
+            r.srcShift = S::packed ? SampleY410::bits * sc : a.srcShift;
+            r.dstShift = D::packed ? SampleY410::bits * c : a.dstShift;
+            r.first = c == 0;
+            if (a.steps)
+                convert_run<S, D, Isa, true>(r, a);
+            else
+                convert_run<S, D, Isa, false>(r, a);
+        }
+    }
+}
+
+using RowFn = void (*)(const RowArgs&);
+
+template <typename S, typename D, bool SrcPlanar, bool DstPlanar, int PC>
+void convert_row_ref(const RowArgs& a) {
+    convert_row<S, D, SrcPlanar, DstPlanar, PC, IsaGeneric>(a);
+}
+
+#ifdef IVSR_CONVERT_X86
+template <typename S, typename D, bool SrcPlanar, bool DstPlanar, int PC>
+__attribute__((target("avx2,fma,f16c"))) void convert_row_avx2(const RowArgs& a) {
+    convert_row<S, D, SrcPlanar, DstPlanar, PC, IsaF16C>(a);
+}
+
+// 512-bit vectors, the compiler keeps to 256 bits for AVX-512 targets unless told otherwise
+template <typename S, typename D, bool SrcPlanar, bool DstPlanar, int PC>
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,f16c,prefer-vector-width=512"))) void
+convert_row_avx512(const RowArgs& a) {
+    convert_row<S, D, SrcPlanar, DstPlanar, PC, IsaF16C>(a);
+}
+
+// the levels of cpu_isa() include F16C, IVSR_CPU_ISA selects the kernels here too
+bool cpu_has_avx2() {
+    return cpu_isa() >= CpuIsa::AVX2;
+}
+
+bool cpu_has_avx512() {
+    return cpu_isa() >= CpuIsa::AVX512;
+}
+#endif
+
+template <typename S, typename D, bool SrcPlanar, bool DstPlanar, int PC>
+RowFn pick_kernel() {
+#ifdef IVSR_CONVERT_X86
+    // interleaved stores to packed RGB are slower with 512-bit vectors
+    if (cpu_has_avx512() && (DstPlanar || D::packed))
+        return convert_row_avx512<S, D, SrcPlanar, DstPlanar, PC>;
+    if (cpu_has_avx2())
+        return convert_row_avx2<S, D, SrcPlanar, DstPlanar, PC>;
+#endif
+    return convert_row_ref<S, D, SrcPlanar, DstPlanar, PC>;
+}
+
+template <typename S, typename D>
+RowFn pick_layout(bool srcPlanar, bool dstPlanar, int channels) {
+    // Y410 is packed with 3 channels, no other kernel is instantiated for it
+    if constexpr (S::packed || D::packed) {
+        if (channels != 3 || (S::packed && srcPlanar) || (D::packed && dstPlanar))
+            return nullptr;
+        if (srcPlanar)
+            return pick_kernel<S, D, true, false, 3>();
+        return dstPlanar ? pick_kernel<S, D, false, true, 3>() : pick_kernel<S, D, false, false, 3>();
+    } else {
+        if (srcPlanar && dstPlanar)
+            return pick_kernel<S, D, true, true, 0>();
+        // RGB/BGR is the common packed case, a constant channel count lets the compiler shuffle instead of gather
+        if (channels == 3) {
+            if (srcPlanar)
+                return pick_kernel<S, D, true, false, 3>();
+            return dstPlanar ? pick_kernel<S, D, false, true, 3>() : pick_kernel<S, D, false, false, 3>();
+        }
+        if (srcPlanar)
+            return pick_kernel<S, D, true, false, 0>();
+        return dstPlanar ? pick_kernel<S, D, false, true, 0>() : pick_kernel<S, D, false, false, 0>();
+    }
+}
+
+template <typename S>
+RowFn pick_dst(IVSRSampleType dst, bool srcPlanar, bool dstPlanar, int channels) {
+    switch (dst) {
+    case IVSR_SAMPLE_U8:
+        return pick_layout<S, SampleU8>(srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_U16:
+        return pick_layout<S, SampleU16>(srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_F16:
+        return pick_layout<S, SampleF16>(srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_F32:
+        return pick_layout<S, SampleF32>(srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_Y410:
+        return pick_layout<S, SampleY410>(srcPlanar, dstPlanar, channels);
+    }
+    return nullptr;
+}
+
+RowFn pick_row_kernel(IVSRSampleType src, IVSRSampleType dst, bool srcPlanar, bool dstPlanar, int channels) {
+    switch (src) {
+    case IVSR_SAMPLE_U8:
+        return pick_dst<SampleU8>(dst, srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_U16:
+        return pick_dst<SampleU16>(dst, srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_F16:
+        return pick_dst<SampleF16>(dst, srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_F32:
+        return pick_dst<SampleF32>(dst, srcPlanar, dstPlanar, channels);
+    case IVSR_SAMPLE_Y410:
+        return pick_dst<SampleY410>(dst, srcPlanar, dstPlanar, channels);
+    }
+    return nullptr;
+}
+
+size_t sample_size(IVSRSampleType type) {
+    switch (type) {
+    case IVSR_SAMPLE_U8:
+        return 1;
+    case IVSR_SAMPLE_U16:
+    case IVSR_SAMPLE_F16:
+        return 2;
+    case IVSR_SAMPLE_F32:
+    case IVSR_SAMPLE_Y410:
+        return 4;
+    }
+    return 0;
+}
+
+// padding bits below the samples of an MSB-aligned U16 image
+int sample_shift(const ivsr_image_t& image) {
+    return image.type == IVSR_SAMPLE_U16 && image.msb_aligned && image.bit_depth ? 16 - image.bit_depth : 0;
+}
+
+// geometry of an image with the defaults resolved, one channel images are planar whatever their layout
+struct ImageGeometry {
+    bool planar;
+    size_t rowBytes;  // bytes of the samples of a row
+    size_t rowStride;
+    size_t planeStride;
+    size_t imageStride;
+    size_t totalBytes;
+};
+
+bool image_geometry(const ivsr_image_t& image, ImageGeometry& g) {
+    const size_t elem = sample_size(image.type);
+    const bool packed = image.type == IVSR_SAMPLE_Y410;
+    if (elem == 0 || image.batch <= 0 || image.channels <= 0 || image.height <= 0 || image.width <= 0 ||
+        !image.data || image.bit_depth < 0 || image.bit_depth > 16 ||
+        (packed && (image.channels != 3 || image.layout != IVSR_LAYOUT_NHWC)))
+        return false;
+    g.planar = image.layout == IVSR_LAYOUT_NCHW || image.channels == 1;
+    g.rowBytes = elem * image.width * (g.planar || packed ? 1 : image.channels);
+    g.rowStride = image.row_stride ? image.row_stride : g.rowBytes;
+    if (g.rowStride < g.rowBytes)
+        return false;
+    g.planeStride = g.planar ? (image.plane_stride ? image.plane_stride : g.rowStride * image.height) : 0;
+    if (g.planar && g.planeStride < g.rowStride * image.height)
+        return false;
+    g.imageStride = g.planar ? g.planeStride * image.channels : g.rowStride * image.height;
+    g.totalBytes = g.imageStride * image.batch;
+    return true;
+}
+
+}  // namespace
+
+IVSRStatus ivsr_convert(const ivsr_image_t* src, ivsr_image_t* dst, const ivsr_convert_param_t* param) {
+    if (!src || !dst) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_convert");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    ImageGeometry sg, dg;
+    if (!image_geometry(*src, sg) || !image_geometry(*dst, dg)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for ivsr_convert image type, size or stride");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    if (src->batch != dst->batch || src->channels != dst->channels || src->height != dst->height ||
+        src->width != dst->width) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_SHAPE, "in ivsr_convert, source and destination sizes differ");
+        return IVSRStatus::UNSUPPORTED_SHAPE;
+    }
+
+    const ivsr_convert_param_t defaults = {1.0f, 0.0f, 0.0f, 0, 0, 0.0f, 0.0f};
+    const ivsr_convert_param_t& p = param ? *param : defaults;
+    const bool swap = p.swap_rb && src->channels >= 3;
+
+    // in place is fine while every sample is read before it is written at the same position
+    auto begin = [](const ivsr_image_t& image) {
+        return static_cast<const uint8_t*>(image.data);
+    };
+    bool overlap = begin(*src) < begin(*dst) + dg.totalBytes && begin(*dst) < begin(*src) + sg.totalBytes;
+    if (overlap && (begin(*src) != begin(*dst) || sg.planar != dg.planar || sg.rowStride != dg.rowStride ||
+                    sg.planeStride != dg.planeStride || sg.rowBytes != dg.rowBytes ||
+                    sample_size(src->type) != sample_size(dst->type) || swap)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "in ivsr_convert, overlapping images must share the layout");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    const bool clamp = p.min_value < p.max_value;
+    float lo = -INFINITY, hi = INFINITY;
+    if (clamp) {
+        lo = p.min_value;
+        hi = p.max_value;
+    }
+    if (dst->type == IVSR_SAMPLE_U8 || dst->type == IVSR_SAMPLE_U16 || dst->type == IVSR_SAMPLE_Y410) {
+        int bits = dst->type == IVSR_SAMPLE_U8     ? 8
+                   : dst->type == IVSR_SAMPLE_Y410 ? SampleY410::bits
+                                                   : (dst->bit_depth ? dst->bit_depth : 16);
+        lo = std::max(lo, 0.0f);
+        hi = std::min(hi, static_cast<float>((1 << bits) - 1));
+    }
+
+    std::vector<int> srcChannel(src->channels);
+    for (int c = 0; c < src->channels; ++c)
+        srcChannel[c] = swap && c < 3 ? 2 - c : c;
+
+    RowArgs args;
+    args.srcPlane = sg.planeStride;
+    args.dstPlane = dg.planeStride;
+    args.width = src->width;
+    args.channels = src->channels;
+    args.srcChannel = srcChannel.data();
+    args.srcShift = sample_shift(*src);
+    args.dstShift = sample_shift(*dst);
+    const float divisor = p.divisor != 0.0f ? p.divisor : 1.0f;
+    const float postScale = p.post_scale != 0.0f ? p.post_scale : 1.0f;
+    args.steps = divisor != 1.0f || postScale != 1.0f;
+    args.arith = {p.scale, divisor, postScale, lo, hi};
+
+    const int rows = src->batch * src->height;
+    const uint8_t* srcBase = begin(*src);
+    uint8_t* dstBase = static_cast<uint8_t*>(dst->data);
+
+    // same format and no arithmetic: rows are copied, unless the destination has fewer significant bits
+    // or the samples are aligned differently
+    const bool narrower = src->type == IVSR_SAMPLE_U16 && dst->bit_depth &&
+                          (src->bit_depth == 0 || src->bit_depth > dst->bit_depth);
+    const bool copy = src->type == dst->type && sg.planar == dg.planar && !swap && p.scale == 1.0f &&
+                      !args.steps && !clamp && !narrower && args.srcShift == args.dstShift;
+    const int planes = copy && sg.planar ? src->channels : 1;
+    RowFn kernel = copy ? nullptr : pick_row_kernel(src->type, dst->type, sg.planar, dg.planar, src->channels);
+    if (!copy && !kernel) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for ivsr_convert sample type and layout");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    // A large destination is not read again soon and is written around the caches. Rows are converted
+    // into a buffer which stays in the caches, then streamed out of it.
+    const CpuKernels& kernels = cpu_kernels();
+    const bool stream = dg.totalBytes > kStreamBytes && !overlap;
+    const int dstRows = dg.planar ? dst->channels : 1;
+
+    auto convert_rows = [&](int first, int last) {
+        std::vector<uint8_t> rowBuffer(stream && !copy ? dg.rowBytes * dstRows : 0);
+        for (int row = first; row < last; ++row) {
+            const int n = row / src->height, h = row % src->height;
+            RowArgs a = args;
+            a.src = srcBase + n * sg.imageStride + h * sg.rowStride;
+            a.dst = dstBase + n * dg.imageStride + h * dg.rowStride;
+            if (!copy && !stream) {
+                kernel(a);
+                continue;
+            }
+            if (!copy) {
+                uint8_t* out = a.dst;
+                a.dst = rowBuffer.data();
+                a.dstPlane = dg.rowBytes;
+                kernel(a);
+                kernels.copy_rows(out, dg.planeStride, rowBuffer.data(), dg.rowBytes, dg.rowBytes, dstRows, true);
+                continue;
+            }
+            if (a.src == a.dst)
+                continue;
+            kernels.copy_rows(a.dst, dg.planeStride, a.src, sg.planeStride, sg.rowBytes, planes, stream);
+        }
+    };
+
+    const size_t samples = static_cast<size_t>(rows) * src->width * src->channels;
+    const int threads = p.threads > 0 ? p.threads : omp_get_max_threads();
+    if (samples < kParallelSamples || threads <= 1 || rows < 2) {
+        convert_rows(0, rows);
+        return IVSRStatus::OK;
+    }
+    // contiguous blocks of rows per thread
+#pragma omp parallel num_threads(threads)
+    {
+        const int nthreads = omp_get_num_threads(), t = omp_get_thread_num();
+        const int block = (rows + nthreads - 1) / nthreads;
+        convert_rows(std::min(rows, t * block), std::min(rows, (t + 1) * block));
+    }
+    return IVSRStatus::OK;
+}
@@ -0,0 +1,128 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_cpu_isa.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#ifdef IVSR_CPU_X86
+#    include <cpuid.h>
+#endif
+
+namespace {
+
+#ifdef IVSR_CPU_X86
+// the OS saves the AMX tile state, XCR0 bits 17 and 18
+bool os_saves_amx_state() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 0x60000) == 0x60000;
+}
+#endif
+
+CpuIsa detect() {
+#ifdef IVSR_CPU_X86
+    __builtin_cpu_init();
+    // F16C comes with every AVX2 CPU, the conversion kernels rely on it
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma") || !__builtin_cpu_supports("f16c"))
+        return CpuIsa::GENERIC;
+    if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw") ||
+        !__builtin_cpu_supports("avx512vl") || !__builtin_cpu_supports("avx512dq"))
+        return CpuIsa::AVX2;
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (edx & (1u << 24)) && os_saves_amx_state())
+        return CpuIsa::AMX;
+    return CpuIsa::AVX512;
+#else
+    return CpuIsa::GENERIC;
+#endif
+}
+
+bool parse_isa(const std::string& name, CpuIsa& isa) {
+    for (CpuIsa candidate : {CpuIsa::GENERIC, CpuIsa::AVX2, CpuIsa::AVX512, CpuIsa::AMX}) {
+        if (name == cpu_isa_name(candidate)) {
+            isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct IsaSelection {
+    CpuIsa detected;
+    CpuIsa selected;
+
+    IsaSelection() : detected(detect()), selected(detected) {
+        const char* env = getenv("IVSR_CPU_ISA");
+        if (env == nullptr || *env == '\0')
+            return;
+        CpuIsa requested;
+        if (!parse_isa(env, requested)) {
+            std::cout << "[WARNING]: IVSR_CPU_ISA " << env << " is unknown, using " << cpu_isa_name(detected)
+                      << std::endl;
+        } else if (requested > detected) {
+            std::cout << "[WARNING]: IVSR_CPU_ISA " << env << " is not supported by the CPU, using "
+                      << cpu_isa_name(detected) << std::endl;
+        } else {
+            selected = requested;
+        }
+    }
+};
+
+const IsaSelection& selection() {
+    static const IsaSelection isa;
+    return isa;
+}
+
+// detected when the library is loaded, not by the first frame
+[[maybe_unused]] const IsaSelection& loadTimeSelection = selection();
+
+}  // namespace
+
+CpuIsa cpu_isa() {
+    return selection().selected;
+}
+
+CpuIsa cpu_isa_detected() {
+    return selection().detected;
+}
+
+const char* cpu_isa_name(CpuIsa isa) {
+    switch (isa) {
+    case CpuIsa::GENERIC:
+        return "generic";
+    case CpuIsa::AVX2:
+        return "avx2";
+    case CpuIsa::AVX512:
+        return "avx512";
+    case CpuIsa::AMX:
+        return "amx";
+    }
+    return "unknown";
+}
+
+const CpuKernels& cpu_kernels() {
+    static const CpuKernels& kernels = [] () -> const CpuKernels& {
+#ifdef IVSR_CPU_X86
+        if (cpu_isa() >= CpuIsa::AVX512)
+            return avx512Kernels;
+        if (cpu_isa() >= CpuIsa::AVX2)
+            return avx2Kernels;
+#endif
+        return genericKernels;
+    }();
+    return kernels;
+}
@@ -0,0 +1,81 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_frame_window.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+FrameWindow::FrameWindow(size_t frameBytes, int frames, size_t capacity, MemoryAccount* memory)
+    : frameBytes_(frameBytes),
+      frames_(frames),
+      capacity_(std::max(capacity, static_cast<size_t>(frames))),
+      buffer_(bytes(frameBytes, frames, capacity_)),
+      charge_(memory, MemoryKind::FRAME_WINDOW, buffer_.size()),
+      refs_(capacity_, 0) {}
+
+FrameWindow::~FrameWindow() = default;
+
+void FrameWindow::write(uint64_t seq, const char* frame) {
+    size_t s = slot(seq);
+    std::memcpy(buffer_.data() + s * frameBytes_, frame, frameBytes_);
+    if (s + 1 < static_cast<size_t>(frames_))
+        std::memcpy(buffer_.data() + (capacity_ + s) * frameBytes_, frame, frameBytes_);
+}
+
+bool FrameWindow::push(const char* frame, bool blocking) {
+    uint64_t seq = next_ == 0 ? frames_ - 1 : next_;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto is_free = [this, seq] {
+            return refs_[slot(seq)] == 0;
+        };
+        if (!blocking && !is_free())
+            return false;
+        cv_.wait(lock, is_free);
+    }
+
+    // frames before the first one are the first frame, nothing is referenced yet
+    if (next_ == 0) {
+        for (uint64_t history = 0; history < seq; ++history)
+            write(history, frame);
+    }
+    write(seq, frame);
+    next_ = seq + 1;
+    return true;
+}
+
+char* FrameWindow::acquire(uint64_t& first) {
+    first = next_ - frames_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < frames_; ++i)
+        ++refs_[slot(first + i)];
+    return buffer_.data() + slot(first) * frameBytes_;
+}
+
+void FrameWindow::release(uint64_t first) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < frames_; ++i)
+            --refs_[slot(first + i)];
+    }
+    cv_.notify_all();
+}
+
+void FrameWindow::cancel(uint64_t first) {
+    release(first);
+    next_ = first + frames_ - 1;
+    // only the history of a dropped first frame is left, the next frame refills it
+    if (next_ == static_cast<uint64_t>(frames_ - 1))
+        next_ = 0;
+}
@@ -21,6 +21,7 @@
 #ifndef INFER_TASK_HPP
 #define INFER_TASK_HPP
 
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <string>
@@ -43,7 +44,9 @@ public:
           flag_(flag),
           inputPtr_(inBuf),
           outputPtr_(outBuf),
-          cb(ivsr_cb) {}
+          cb(ivsr_cb),
+          submitTime_(Time::now()),
+          seq_(next_seq()) {}
 
     InferFlag getInferFlag() {
         return flag_;
@@ -54,6 +57,35 @@ public:
         return static_cast<double>(execTime.count()) * 0.000001;
     }
 
+    void set_option(const ivsr_task_option_t* option, IVSRPriority defaultPriority) {
+        priority_ = option ? option->priority : defaultPriority;
+        if (option && option->deadline_us > 0)
+            deadline_ = Time::now() + std::chrono::microseconds(option->deadline_us);
+    }
+
+    bool has_deadline() const {
+        return deadline_ != Time::time_point::max();
+    }
+
+    bool deadline_missed() const {
+        return has_deadline() && Time::now() > deadline_;
+    }
+
+    // scheduling order: priority class, then earliest deadline, then submission order
+    bool scheduled_before(const InferTask& other) const {
+        if (priority_ != other.priority_)
+            return priority_ < other.priority_;
+        if (deadline_ != other.deadline_)
+            return deadline_ < other.deadline_;
+        return seq_ < other.seq_;
+    }
+
+private:
+    static uint64_t next_seq() {
+        static std::atomic<uint64_t> seq{0};
+        return seq.fetch_add(1, std::memory_order_relaxed);
+    }
+
 public:
     QueueCallbackFunction _callbackFunction;
     InferFlag flag_ = InferFlag::GPU;  // Default will use GPU to do inference task
@@ -62,6 +94,16 @@ public:
     Time::time_point _startTime;
     Time::time_point _endTime;
     ivsr_cb_t* cb = nullptr;
+    IVSRStatus status_ = OK;         // set to GENERAL_ERROR if the inference raised an exception
+    Time::time_point submitTime_;
+    IVSRPriority priority_ = IVSR_PRIORITY_MEDIUM;
+    Time::time_point deadline_ = Time::time_point::max();  // no deadline by default
+    uint64_t seq_ = 0;                                     // submission order
+    int64_t frameId_ = -1;                                 // trace ids
+    int32_t patchId_ = -1;
+    bool endsFrame_ = false;                               // completion of this task completes a frame
+    size_t height_ = 0;                                    // frame size of a dynamic shape model, 0 for the static shape
+    size_t width_ = 0;
 };
 
 #endif //INFER_TASK_HPP
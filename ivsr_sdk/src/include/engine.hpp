@@ -36,17 +36,21 @@ class engine {
 private:
     using InitFunc = std::function<IVSRStatus()>;
     using RunFunc = std::function<IVSRStatus(InferTask::Ptr)>;
-    using ProcFunc = std::function<IVSRStatus(void*, void*, void*)>;
+    using ProcFunc = std::function<IVSRStatus(InferTask::Ptr)>;
+    using TryProcFunc = std::function<IVSRStatus(InferTask::Ptr)>;
     using WaitAllFunc = std::function<void()>;
     using CreateInferRequestsFunc = std::function<IVSRStatus(size_t)>;
     using GetInferRequestsSizeFunc = std::function<size_t()>;
+    using WarmupFunc = std::function<IVSRStatus(size_t, bool)>;
 
     InitFunc init_func;
     RunFunc run_func;
     ProcFunc proc_func;
+    TryProcFunc try_proc_func;
     WaitAllFunc wait_all_func;
     CreateInferRequestsFunc create_infer_requests_func;
     GetInferRequestsSizeFunc get_infer_requests_size_func;
+    WarmupFunc warmup_func;
 
     Derived* _derived = nullptr;
 
@@ -58,8 +62,11 @@ public:
           run_func([=](InferTask::Ptr task) -> IVSRStatus {
               return _derived->run_impl(task);
           }),
-          proc_func([=](void* input, void* output, void* cb) -> IVSRStatus {
-              return _derived->process_impl(input, output, cb);
+          proc_func([=](InferTask::Ptr task) -> IVSRStatus {
+              return _derived->process_impl(task);
+          }),
+          try_proc_func([=](InferTask::Ptr task) -> IVSRStatus {
+              return _derived->try_process_impl(task);
           }),
           wait_all_func([=]() {
               _derived->wait_all_impl();
@@ -70,6 +77,9 @@ public:
           get_infer_requests_size_func([=]() -> size_t {
               return _derived->get_infer_requests_size_impl();
           }),
+          warmup_func([=](size_t iterations, bool background) -> IVSRStatus {
+              return _derived->warmup_impl(iterations, background);
+          }),
           _derived(derived) {}
     
     // Default constructor
@@ -83,8 +93,12 @@ public:
         return run_func(task);
     }
 
-    IVSRStatus proc(void* input_data, void* output_data, void* cb) {
-        return proc_func(input_data, output_data, cb);
+    IVSRStatus proc(InferTask::Ptr task) {
+        return proc_func(task);
+    }
+
+    IVSRStatus try_proc(InferTask::Ptr task) {
+        return try_proc_func(task);
     }
 
     template <typename T>
@@ -104,6 +118,10 @@ public:
         return get_infer_requests_size_func();
     }
 
+    IVSRStatus warmup(size_t iterations, bool background) {
+        return warmup_func(iterations, background);
+    }
+
     Derived* get_impl() const {
         return _derived;
     }
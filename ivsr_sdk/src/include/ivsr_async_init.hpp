@@ -0,0 +1,87 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_async_init.hpp
+ * background initialization of an ivsr_init_async handle,
+ * submissions made before the handle is ready are held and started in order once it is.
+ */
+
+#ifndef IVSR_ASYNC_INIT_HPP
+#define IVSR_ASYNC_INIT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "ivsr.h"
+
+class AsyncInit {
+public:
+    // starts a held submission with the init status OK, or fails it with the init error
+    using Held = std::function<void(IVSRStatus)>;
+
+    /**
+     * @param queue_size submissions held while initializing, more are rejected with NOT_READY.
+     */
+    explicit AsyncInit(size_t queue_size);
+
+    // waits for the initialization, it can not be interrupted
+    ~AsyncInit();
+
+    AsyncInit(const AsyncInit&) = delete;
+    AsyncInit& operator=(const AsyncInit&) = delete;
+
+    /**
+     * @brief run init on a thread of its own, then the held submissions, then on_done.
+     * IVSR_INIT_THREADS environment variable limits how many handles of the process initialize at the same time.
+     */
+    void start(std::function<IVSRStatus()> init, std::function<void()> on_done);
+
+    // the handle is initialized and every held submission is started
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief hold a submission made before the handle is ready.
+     * @return false if the handle became ready meanwhile, the caller submits itself. Otherwise status is
+     * OK if the submission is held, NOT_READY if the queue is full, WOULD_BLOCK if it is not blocking and the
+     * held submissions are being started, or the error of a failed initialization.
+     */
+    bool hold(bool blocking, Held submission, IVSRStatus& status);
+
+    // waits until the handle is ready or its initialization failed
+    IVSRStatus wait();
+
+    // NOT_READY until the handle is ready
+    IVSRStatus status();
+
+private:
+    void finish(IVSRStatus status);
+
+    enum class State { INITIALIZING, DRAINING, READY, FAILED };
+
+    const size_t queueSize_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    State state_ = State::INITIALIZING;
+    IVSRStatus status_ = IVSRStatus::NOT_READY;
+    std::deque<Held> held_;
+    std::atomic<bool> ready_{false};
+    std::thread thread_;
+};
+
+#endif  // IVSR_ASYNC_INIT_HPP
@@ -0,0 +1,72 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_completion_queue.hpp
+ * per-handle queue of finished submissions,
+ * it backs ivsr_submit/ivsr_poll/ivsr_wait.
+ */
+
+#ifndef IVSR_COMPLETION_QUEUE_HPP
+#define IVSR_COMPLETION_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include "ivsr.h"
+
+class CompletionQueue {
+public:
+    /**
+     * @brief reserve a token for a new submission, it is pending until complete() or cancel().
+     */
+    ivsr_token_t add_pending();
+
+    /**
+     * @brief drop the token of a submission which failed to start.
+     */
+    void cancel(ivsr_token_t token);
+
+    /**
+     * @brief move a pending token to the completed events and wake up the waiters.
+     */
+    void complete(const ivsr_event_t& event);
+
+    /**
+     * @brief copy out up to max_events completed events in completion order.
+     * timeout_ms < 0 waits without limit, 0 does not wait.
+     * @return number of events, 0 on timeout.
+     */
+    size_t poll(ivsr_event_t* events, size_t max_events, int timeout_ms);
+
+    /**
+     * @brief wait for the completion of one token and remove its event from the queue.
+     * @return OK, TIMEOUT, or GENERAL_ERROR if the token is unknown or has been polled already.
+     */
+    IVSRStatus wait(ivsr_token_t token, int timeout_ms, ivsr_event_t* event);
+
+private:
+    template <typename Pred>
+    bool wait_for(std::unique_lock<std::mutex>& lock, int timeout_ms, Pred pred);
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_set<ivsr_token_t> pending_;
+    std::deque<ivsr_event_t> completed_;
+    ivsr_token_t next_token_ = 1;  // 0 is never a valid token
+};
+
+#endif  // IVSR_COMPLETION_QUEUE_HPP
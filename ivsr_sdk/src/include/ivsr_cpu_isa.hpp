@@ -0,0 +1,69 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_cpu_isa.hpp
+ * instruction set of the SDK kernels, detected once when the library is loaded.
+ * Every kernel set is a translation unit of src/kernels built for its instruction set, only the
+ * one the CPU supports is called. IVSR_CPU_ISA environment variable selects a lower one,
+ * "generic", "avx2", "avx512" or "amx", so runs on different hosts can be compared.
+ */
+
+#ifndef IVSR_CPU_ISA_HPP
+#define IVSR_CPU_ISA_HPP
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define IVSR_CPU_X86 1
+#endif
+
+// ordered, a CPU supporting one supports the ones before it
+enum class CpuIsa { GENERIC, AVX2, AVX512, AMX };
+
+// instruction set the kernels run with
+CpuIsa cpu_isa();
+// best instruction set of the CPU, whatever IVSR_CPU_ISA asks for
+CpuIsa cpu_isa_detected();
+const char* cpu_isa_name(CpuIsa isa);
+
+// destination size above which the kernels store around the caches, the data is not read again soon
+const size_t kStreamBytes = 8 << 20;
+
+/**
+ * @brief data movement kernels of one instruction set.
+ * Kernel sets are plain tables of functions, a kernel translation unit defines nothing inline which the
+ * linker could pick for the callers built for another instruction set.
+ */
+struct CpuKernels {
+    // rows of rowBytes, stream stores them non-temporal
+    void (*copy_rows)(void* dst, size_t dstStride, const void* src, size_t srcStride, size_t rowBytes, size_t rows,
+                      bool stream);
+    // dst[i] += src[i], overlapping patches are blended by adding them up
+    void (*add)(float* dst, const float* src, size_t n);
+    // dst[i] /= counts[i] * scale, the average of the blended patches
+    void (*divide)(float* dst, const int* counts, int scale, size_t n, bool stream);
+};
+
+// kernels of cpu_isa()
+const CpuKernels& cpu_kernels();
+
+// kernel sets of src/kernels, AMX hosts use the AVX-512 one: tiles do not move data faster
+extern const CpuKernels genericKernels;
+#ifdef IVSR_CPU_X86
+extern const CpuKernels avx2Kernels;
+extern const CpuKernels avx512Kernels;
+#endif
+
+#endif  // IVSR_CPU_ISA_HPP
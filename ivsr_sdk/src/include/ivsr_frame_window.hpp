@@ -0,0 +1,100 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_frame_window.hpp
+ * ring of the last input frames of a multi-frame model,
+ * every frame is copied in once and windows are passed to the inference in place.
+ */
+
+#ifndef IVSR_FRAME_WINDOW_HPP
+#define IVSR_FRAME_WINDOW_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "ivsr_memory.hpp"
+
+/**
+ * Frames are stored in consecutive slots in model input format, so the window of the
+ * last `frames` frames is one contiguous input tensor. The first frames-1 slots are
+ * mirrored after the last slot, a window crossing the end of the ring reads the mirror.
+ * A slot is not overwritten while a window referencing it is being inferred.
+ *
+ * Frames must be pushed from one thread at a time.
+ */
+class FrameWindow {
+public:
+    FrameWindow(size_t frameBytes, int frames, size_t capacity, MemoryAccount* memory);
+
+    ~FrameWindow();
+
+    FrameWindow(const FrameWindow&) = delete;
+    FrameWindow& operator=(const FrameWindow&) = delete;
+
+    // bytes of a ring of capacity slots
+    static size_t bytes(size_t frameBytes, int frames, size_t capacity) {
+        return frameBytes * (capacity + frames - 1);
+    }
+
+    /**
+     * @brief copy a frame in as the newest one, the first frame also fills the history before it.
+     * @return false if blocking is false and the slot is still referenced.
+     */
+    bool push(const char* frame, bool blocking);
+
+    /**
+     * @brief reference the window ending at the newest frame.
+     * @param first returns the id of the window for release().
+     * @return the window, frames() frames in input tensor layout.
+     */
+    char* acquire(uint64_t& first);
+
+    // the inference of the window is done
+    void release(uint64_t first);
+
+    // release the window and drop its newest frame, for a submission which failed to start
+    void cancel(uint64_t first);
+
+    int frames() const {
+        return frames_;
+    }
+
+    size_t frame_bytes() const {
+        return frameBytes_;
+    }
+
+private:
+    size_t slot(uint64_t seq) const {
+        return static_cast<size_t>(seq % capacity_);
+    }
+
+    void write(uint64_t seq, const char* frame);
+
+    size_t frameBytes_;
+    int frames_;
+    size_t capacity_;
+    std::vector<char> buffer_;
+    ScopedMemory charge_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<int> refs_;  // windows being inferred per slot
+    uint64_t next_ = 0;      // sequence number of the next frame, 0 before the first frame
+};
+
+#endif  // IVSR_FRAME_WINDOW_HPP
@@ -0,0 +1,84 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_memory.hpp
+ * accounting of the memory allocated by a handle,
+ * every handle has an account, all accounts add up to the process totals.
+ */
+
+#ifndef IVSR_MEMORY_HPP
+#define IVSR_MEMORY_HPP
+
+#include <atomic>
+#include <cstddef>
+
+#include "utils.hpp"
+
+enum class MemoryKind { MODEL = 0, INFER_REQUESTS, PATCH_STAGING, PIXEL_COUNTER, FRAME_WINDOW, COUNT };
+
+class MemoryAccount {
+public:
+    MemoryAccount() {
+        for (auto& bytes : current_)
+            bytes.store(0, std::memory_order_relaxed);
+    }
+
+    // whatever is still accounted leaves the process totals with the handle
+    ~MemoryAccount();
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    void add(MemoryKind kind, size_t bytes);
+
+    void release(MemoryKind kind, size_t bytes);
+
+    size_t total() const {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+    void snapshot(ivsr_memory_usage_t& usage) const;
+
+private:
+    std::atomic<size_t> current_[static_cast<int>(MemoryKind::COUNT)];
+    std::atomic<size_t> total_{0};
+    std::atomic<size_t> peak_{0};
+};
+
+/**
+ * @brief RAII charge of a buffer, account may be nullptr.
+ */
+class ScopedMemory {
+public:
+    ScopedMemory(MemoryAccount* account, MemoryKind kind, size_t bytes) : account_(account), kind_(kind), bytes_(bytes) {
+        if (account_)
+            account_->add(kind_, bytes_);
+    }
+
+    ~ScopedMemory() {
+        if (account_)
+            account_->release(kind_, bytes_);
+    }
+
+    ScopedMemory(const ScopedMemory&) = delete;
+    ScopedMemory& operator=(const ScopedMemory&) = delete;
+
+private:
+    MemoryAccount* account_;
+    MemoryKind kind_;
+    size_t bytes_;
+};
+
+#endif  // IVSR_MEMORY_HPP
@@ -0,0 +1,53 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_model_loader.hpp
+ * Model loading of the engine: the format of a model file is detected from its first bytes so
+ * model-guard protected IRs go to irguard directly, and decrypted models are shared by the handles
+ * of the process which load the same files.
+ */
+
+#ifndef IVSR_MODEL_LOADER_HPP
+#define IVSR_MODEL_LOADER_HPP
+
+#include <memory>
+#include <string>
+
+#include <openvino/openvino.hpp>
+
+enum class ModelFormat {
+    IR,            // OpenVINO IR xml
+    PROTECTED_IR,  // xml encrypted by model-guard
+    OTHER,         // ONNX, TensorFlow, PaddlePaddle or TensorFlow Lite, read by the frontends
+    UNKNOWN,       // not readable, or no known signature
+};
+
+/**
+ * @brief format of a model file from its extension and first bytes, the file is not parsed.
+ */
+ModelFormat detect_model_format(const std::string& path);
+
+/**
+ * @brief reads a model with the loader of its format. A protected model is decrypted once per process
+ * while a handle uses it: @p keep_alive holds the decrypted model, the returned model is a clone of it
+ * which the caller may reshape and preprocess.
+ * UNKNOWN formats keep the previous behavior, read_model first and irguard if it throws.
+ */
+std::shared_ptr<ov::Model> load_model(ov::Core& core,
+                                      const std::string& path,
+                                      const std::string& custom_lib,
+                                      std::shared_ptr<const void>& keep_alive);
+
+#endif  // IVSR_MODEL_LOADER_HPP
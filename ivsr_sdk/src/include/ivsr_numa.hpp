@@ -0,0 +1,90 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_numa.hpp
+ * NUMA placement of a handle: the topology from sysfs, CPU and memory binding of threads
+ * and buffers through the kernel interfaces, and the per-node frame counters of the process.
+ */
+
+#ifndef IVSR_NUMA_HPP
+#define IVSR_NUMA_HPP
+
+#include <sched.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ivsr.h"
+
+struct PerfStats;
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+/**
+ * @brief nodes which have CPUs, read once from /sys/devices/system/node.
+ * Without NUMA information it is a single node 0 with all CPUs of the process.
+ */
+const std::vector<NumaNode>& numa_nodes();
+
+/**
+ * @brief node of a NUMA_NODE config value, "auto" places the handles of the process round-robin.
+ * @return the node id, -1 if the value is not a node of the machine.
+ */
+int numa_parse_node(const std::string& value);
+
+/**
+ * @brief binds the calling thread to the CPUs of a node and prefers its memory for new pages.
+ * Used by the threads a handle owns, e.g. the patch executor.
+ */
+bool numa_bind_thread(int node);
+
+/**
+ * @brief the pages of [addr, addr + bytes) not touched yet are preferred on the node,
+ * whichever thread touches them first. Only whole pages inside the range are affected.
+ */
+void numa_prefer_memory(void* addr, size_t bytes, int node);
+
+/**
+ * @brief binds the calling thread to a node while it exists, e.g. while a model is compiled and its
+ * infer requests are created, then restores the CPU affinity and memory policy of the thread.
+ */
+class NumaScope {
+public:
+    explicit NumaScope(int node);
+    ~NumaScope();
+    NumaScope(const NumaScope&) = delete;
+    NumaScope& operator=(const NumaScope&) = delete;
+
+private:
+    cpu_set_t savedCpus_;
+    bool restoreCpus_ = false;
+    int savedPolicy_ = 0;
+    unsigned long savedNodes_[4] = {0};  // 256 nodes
+    bool restorePolicy_ = false;
+};
+
+/**
+ * @brief frames of the handles on a node are counted into the node totals of the process.
+ * A handle registers its stats once it is bound and unregisters when it is de-initialized.
+ */
+void numa_register(int node, const PerfStats* stats);
+void numa_unregister(int node, const PerfStats* stats);
+void numa_snapshot(int node, ivsr_numa_stats_t& stats);
+
+#endif  // IVSR_NUMA_HPP
@@ -0,0 +1,82 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_perf_stats.hpp
+ * always-on counters and latency histograms of a handle,
+ * recording is a few relaxed atomic adds, the PERF_STATS attribute takes a snapshot.
+ */
+
+#ifndef IVSR_PERF_STATS_HPP
+#define IVSR_PERF_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "utils.hpp"
+
+/**
+ * @brief log-linear histogram of microsecond latencies.
+ * Every power of two is split into 16 buckets, so a percentile is within ~6% of the recorded value.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxBits = 40;  // about 12 days in us, larger values fall into the last bucket
+    static constexpr int kBuckets = (kMaxBits - kSubBits + 1) * kSubBuckets;
+
+    LatencyHistogram() {
+        for (auto& c : counts_)
+            c.store(0, std::memory_order_relaxed);
+    }
+
+    void record(Time::time_point start, Time::time_point end) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        record_us(us > 0 ? static_cast<uint64_t>(us) : 0);
+    }
+
+    void record_us(uint64_t us);
+
+    void snapshot(ivsr_latency_stats_t& stats) const;
+
+private:
+    static int bucket_of(uint64_t us);
+    static double bucket_value(int bucket);  // middle of the bucket in us
+
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+struct PerfStats {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> patches{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> fallback{0};
+
+    LatencyHistogram endToEnd;
+    LatencyHistogram queueWait;
+    LatencyHistogram inference;
+    LatencyHistogram split;
+    LatencyHistogram merge;
+    LatencyHistogram callback;
+    LatencyHistogram reorder;
+
+    void snapshot(ivsr_perf_stats_t& stats) const;
+};
+
+#endif  // IVSR_PERF_STATS_HPP
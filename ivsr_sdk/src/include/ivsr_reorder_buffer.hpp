@@ -0,0 +1,81 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_reorder_buffer.hpp
+ * per-handle reorder buffer of FRAME_PARALLEL mode,
+ * frames finish out of order on several infer requests and are delivered in submission order.
+ */
+
+#ifndef IVSR_REORDER_BUFFER_HPP
+#define IVSR_REORDER_BUFFER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "utils.hpp"
+
+class LatencyHistogram;
+
+class ReorderBuffer {
+public:
+    using Delivery = std::function<void()>;
+
+    /**
+     * @param depth frames submitted and not delivered yet at most.
+     * @param on_space called when a delivery frees a slot of a full buffer, e.g. to signal READY_EVENT_FD.
+     * @param held records how long finished frames wait for the frames before them, can be nullptr.
+     */
+    ReorderBuffer(size_t depth, std::function<void()> on_space, LatencyHistogram* held);
+
+    /**
+     * @brief take the sequence number of the next frame.
+     * @return false if depth frames are in flight and blocking is false, otherwise waits for a slot.
+     */
+    bool reserve(bool blocking, uint64_t& seq);
+
+    /**
+     * @brief the frame seq finished, deliver is run once every earlier frame is delivered.
+     * Deliveries run one at a time in sequence order, on the thread which completes the oldest frame.
+     */
+    void complete(uint64_t seq, Delivery deliver);
+
+    /**
+     * @brief the submission of seq failed, it is skipped without a delivery.
+     */
+    void cancel(uint64_t seq) { complete(seq, nullptr); }
+
+    size_t depth() const { return depth_; }
+
+private:
+    struct Finished {
+        Delivery deliver;
+        Time::time_point time;
+    };
+
+    const size_t depth_;
+    std::function<void()> onSpace_;
+    LatencyHistogram* held_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, Finished> finished_;  // out of order, keyed by sequence number
+    uint64_t nextSeq_ = 0;      // next sequence number to reserve
+    uint64_t nextDeliver_ = 0;  // oldest frame not delivered yet
+    bool delivering_ = false;   // a thread is running deliveries
+};
+
+#endif  // IVSR_REORDER_BUFFER_HPP
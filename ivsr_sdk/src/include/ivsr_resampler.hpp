@@ -0,0 +1,80 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_resampler.hpp
+ * separable bicubic/lanczos plane resampler,
+ * it upscales the chroma planes when only luma goes through the model.
+ */
+
+#ifndef IVSR_RESAMPLER_HPP
+#define IVSR_RESAMPLER_HPP
+
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+enum class ResampleFilter { BICUBIC = 0, LANCZOS = 1 };
+
+enum class PlaneType { U8 = 0, U16 = 1, F32 = 2 };
+
+bool parse_resample_filter(const std::string& name, ResampleFilter& filter);
+
+bool parse_plane_type(const std::string& precision, PlaneType& type);
+
+size_t get_plane_type_size(PlaneType type);
+
+class PlaneResampler {
+public:
+    PlaneResampler(ResampleFilter filter, int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+
+    /**
+     * @brief resample one tightly packed plane.
+     * Source samples are clamped to [0, srcMax] and multiplied by outScale before
+     * they are stored, integer outputs are rounded to the nearest value.
+     */
+    void resample(const void* src, PlaneType srcType, void* dst, PlaneType dstType, float srcMax, float outScale) const;
+
+    int srcWidth() const {
+        return _srcWidth;
+    }
+    int srcHeight() const {
+        return _srcHeight;
+    }
+    int dstWidth() const {
+        return _dstWidth;
+    }
+    int dstHeight() const {
+        return _dstHeight;
+    }
+
+private:
+    struct FilterBank {
+        int taps = 0;
+        std::vector<int> index;     // dst * taps clamped source positions
+        std::vector<float> weight;  // dst * taps normalized weights
+    };
+
+    static FilterBank build_filter_bank(ResampleFilter filter, int srcSize, int dstSize);
+
+    int _srcWidth;
+    int _srcHeight;
+    int _dstWidth;
+    int _dstHeight;
+    FilterBank _horizontal;
+    FilterBank _vertical;
+};
+
+#endif  // IVSR_RESAMPLER_HPP
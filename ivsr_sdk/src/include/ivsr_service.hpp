@@ -0,0 +1,257 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_service.hpp
+ * protocol between ivsr_service and SERVICE_SOCKET handles, and the client side of a handle.
+ * Messages go over a SOCK_SEQPACKET Unix socket, frame buffers are memfd shared memory
+ * whose descriptors are passed once with SCM_RIGHTS.
+ */
+
+#ifndef IVSR_SERVICE_HPP
+#define IVSR_SERVICE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+
+#include "ivsr.h"
+
+namespace service {
+
+enum class MsgType : uint32_t {
+    INIT = 1,       // client: config blob, service: REPLY with InitReply
+    GET_ATTR,       // client: int32 key, service: REPLY with the attribute value
+    ADD_BUFFER,     // client: AddBufferMsg and the memfd, service: REPLY
+    REMOVE_BUFFER,  // client: uint32 buffer id, service: REPLY
+    SUBMIT,         // client: SubmitMsg, service: REPLY once submitted, then DONE with the same id
+    PUSH_FRAME,     // client: BufferRef of the frame, service: REPLY
+    DEINIT,         // client: no payload, service: REPLY once all submissions of the session are done
+    REPLY,
+    DONE            // service: DoneMsg, status is the inference status
+};
+
+struct MsgHeader {
+    MsgType type;
+    int32_t status;        // IVSRStatus of REPLY and DONE
+    uint64_t id;           // request id chosen by the client, echoed by REPLY and DONE
+    uint32_t payloadBytes;
+    uint32_t reserved;
+};
+
+// largest payload of a message, the config blob of INIT is the biggest one
+const size_t kMaxPayload = 64 * 1024;
+
+struct BufferRef {
+    uint32_t buffer;  // id of ADD_BUFFER
+    uint32_t reserved;
+    uint64_t offset;  // bytes from the start of the buffer
+};
+
+enum class SubmitKind : uint32_t { BLOCKING = 0, TRY = 1 };
+
+struct SubmitMsg {
+    BufferRef input;
+    BufferRef output;
+    SubmitKind kind;
+    uint32_t hasOption;
+    ivsr_task_option_t option;
+};
+
+struct AddBufferMsg {
+    uint32_t buffer;
+    uint32_t reserved;
+    uint64_t size;
+};
+
+struct DoneMsg {
+    double queueTime;  // milliseconds, see ivsr_event_t
+    double inferTime;
+};
+
+struct InitReply {
+    uint64_t inputBytes;   // INPUT_FRAME_BYTES and OUTPUT_FRAME_BYTES of the handle
+    uint64_t outputBytes;
+    uint32_t width;        // INPUT_RES
+    uint32_t height;
+    uint32_t dynamicShape;
+    uint32_t reserved;
+};
+
+/**
+ * @brief serialize a config list as {int32 key, uint32 bytes, value} entries.
+ * Strings keep their terminating NUL, tensor descriptors are copied as is, paths of existing
+ * files are made absolute since the service has its own working directory.
+ * READY_CALLBACK and SERVICE_SOCKET stay in the client.
+ */
+std::vector<char> serialize_config(const ivsr_config_t* configs);
+
+/**
+ * @brief rebuild a config list pointing into blob, the blob must outlive the list.
+ * @return false if the blob is malformed.
+ */
+bool deserialize_config(const std::vector<char>& blob, std::vector<ivsr_config_t>& configs);
+
+/**
+ * @brief size of the value of an attribute which is forwarded to the service, 0 if it is not.
+ */
+size_t attr_value_bytes(IVSRAttrKey key);
+
+/**
+ * @brief buffer size of a submission, resBytes at INPUT_RES or scaled to the frame size
+ * of the option for a DYNAMIC_SHAPE handle.
+ */
+size_t frame_bytes(size_t resBytes, const InitReply& info, const ivsr_task_option_t* option);
+
+/**
+ * @brief send one message, fd is attached with SCM_RIGHTS if it is not negative.
+ */
+bool send_message(int sock, const MsgHeader& header, const void* payload, int fd = -1);
+
+/**
+ * @brief receive one message, a passed descriptor is returned in fd, -1 if none.
+ * @return false on a closed connection or a malformed message.
+ */
+bool recv_message(int sock, MsgHeader& header, std::vector<char>& payload, int* fd = nullptr);
+
+// seals of a shared buffer, the service maps only buffers which can not change their size
+const int kBufferSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+
+/**
+ * @brief memfd of size bytes mapped shared, sealed with kBufferSeals.
+ * @return nullptr on error.
+ */
+void* create_shared_buffer(size_t size, int& fd);
+
+}  // namespace service
+
+/**
+ * Client side of a SERVICE_SOCKET handle.
+ * Pointers inside buffers of alloc() are passed to the service without a copy, other
+ * input and output pointers go through staging buffers shared with the service.
+ * Completions arrive on a receiver thread, a lost connection fails everything in flight.
+ */
+class ServiceClient {
+public:
+    // completion of a submission, status and times as in ivsr_event_t
+    using DoneFunction = std::function<void(IVSRStatus status, double queueTime, double inferTime)>;
+
+    ~ServiceClient();
+
+    ServiceClient(const ServiceClient&) = delete;
+    ServiceClient& operator=(const ServiceClient&) = delete;
+
+    /**
+     * @brief connect and create the handle in the service.
+     * notifier is called whenever a submission finishes, an infer request may be free then.
+     */
+    static IVSRStatus connect(const std::string& socketPath,
+                              const ivsr_config_t* configs,
+                              std::function<void()> notifier,
+                              std::unique_ptr<ServiceClient>& client);
+
+    /**
+     * @brief submit a frame, WOULD_BLOCK is only returned if blocking is false.
+     * done is called once the output is in output_data unless the submission fails.
+     */
+    IVSRStatus submit(char* input_data,
+                      char* output_data,
+                      const ivsr_task_option_t* option,
+                      bool blocking,
+                      DoneFunction done);
+
+    IVSRStatus push_frame(const char* frame);
+
+    IVSRStatus get_attr(IVSRAttrKey key, void* value);
+
+    void* alloc(size_t size);
+
+    IVSRStatus free(void* buffer);
+
+    const service::InitReply& info() const {
+        return info_;
+    }
+
+    // waits for the submissions in flight and releases the handle in the service
+    IVSRStatus close();
+
+private:
+    struct Buffer {
+        uint32_t id;
+        char* data;
+        size_t size;
+        bool staging;  // copies of user pointers, reused by later submissions
+        bool busy;
+    };
+
+    struct Pending {
+        char* output = nullptr;       // user output when the output is staged
+        Buffer* inStaging = nullptr;
+        Buffer* outStaging = nullptr;
+        size_t outputBytes = 0;
+        DoneFunction done;
+    };
+
+    struct Reply {
+        bool ready = false;
+        IVSRStatus status = IVSRStatus::OK;
+        std::vector<char> payload;
+    };
+
+    ServiceClient() = default;
+
+    IVSRStatus request(service::MsgType type,
+                       const void* payload,
+                       size_t bytes,
+                       std::vector<char>* reply = nullptr,
+                       int fd = -1);
+    // pending is registered before sending, DONE may arrive before REPLY
+    bool send_request(service::MsgType type, const void* payload, size_t bytes, int fd, Pending* pending, uint64_t& id);
+    IVSRStatus wait_reply(uint64_t id, std::vector<char>* reply);
+    void receive_loop();
+    void fail_all();
+
+    Buffer* add_buffer(size_t size, bool staging);
+    void remove_buffer(Buffer* buffer);
+    bool find_ref(const char* data, size_t bytes, service::BufferRef& ref);
+    Buffer* acquire_staging(size_t bytes);
+    void release_staging(Buffer* buffer);
+
+    int sock_ = -1;
+    service::InitReply info_{};
+    std::function<void()> notifier_;
+    std::thread receiver_;
+    bool connected_ = false;
+    bool closing_ = false;
+
+    std::mutex mutex_;  // everything below
+    std::condition_variable cv_;
+    uint64_t nextId_ = 1;
+    uint32_t nextBuffer_ = 1;
+    std::unordered_map<uint64_t, Reply> replies_;
+    std::unordered_map<uint64_t, Pending> pending_;
+    std::map<const char*, std::unique_ptr<Buffer>> buffers_;  // by start address
+    std::mutex sendMutex_;
+};
+
+#endif  // IVSR_SERVICE_HPP
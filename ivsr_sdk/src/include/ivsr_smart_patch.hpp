@@ -24,6 +24,7 @@
 #include<memory>
 #include<vector>
 
+#include "ivsr_memory.hpp"
 #include "utils.hpp"
 
 struct PatchConfig{
@@ -34,6 +35,7 @@ struct PatchConfig{
     int scale;
     int nif;
     int dims;
+    int channels = 3;
     PatchConfig(int w = 1920, int h = 1080, int pw = 1920, int ph = 1080, int b_w = 1,int b_h = 1,int s = 2,int n = 3,int d = 5)\
     :patchWidth(pw), patchHeight(ph),
     block_w(b_w), block_h(b_h), scale(s),
@@ -45,10 +47,24 @@ struct PatchConfig{
     }
 };
 
+// patch kernels, declared here for the benchmarks
+std::vector<std::vector<int>> calculatePatchCoordinateList(int oriH, int oriW, int cropSize[], int blockSize[]);
+float* fill_patch(std::vector<int> patchCorners, float* inputBuf, std::vector<int> inputDims, float* patchBuf);
+// pixelCounter holds one zeroed int per image element, it is allocated internally if nullptr
+void fill_image(std::vector<std::vector<int>> patchCorners, char* imgBuf,
+                std::vector<int> patchDims, std::vector<int> imgDims, std::vector<char*> patchList,
+                int* pixelCounter = nullptr);
+
 class SmartPatch{
 public:
     using Ptr = std::shared_ptr<SmartPatch>;
-    SmartPatch(PatchConfig config, char* inBuf, char* outBuf , std::vector<int> _inputShape,bool flag);
+    SmartPatch(PatchConfig config, char* inBuf, char* outBuf , std::vector<int> _inputShape,bool flag,
+               MemoryAccount* memory = nullptr, int numaNode = -1);
+
+    // input and output patch buffers of one frame, every patch holds a full model input/output
+    static size_t stagingBytes(const PatchConfig& config, int frameHeight, int frameWidth);
+    // overlap counters of one output frame
+    static size_t pixelCounterBytes(const PatchConfig& config, int frameHeight, int frameWidth);
  
     IBasicVSRStatus generatePatch();
     IBasicVSRStatus restoreImageFromPatches();
@@ -74,6 +90,10 @@ private:
     std::vector<int> _scores;
     PatchConfig _config;
     bool flag = false; // whether generate patch or not
+    MemoryAccount* _memory = nullptr; // charged for the patch buffers and pixel counters
+    size_t _stagingBytes = 0;
+    size_t _pixelCounterBytes = 0;
+    int _numaNode = -1; // node preferred for the patch buffers and pixel counters, -1 for first touch
 };
 
 #endif
\ No newline at end of file
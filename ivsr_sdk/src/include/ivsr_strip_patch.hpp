@@ -0,0 +1,85 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_strip_patch.hpp
+ * strip-wise patch mode: a frame is split, inferred and merged one row of patches at a time
+ * through a ring of two rows of staging, so the scratch memory does not grow with the frame.
+ */
+
+#ifndef IVSR_STRIP_PATCH_HPP
+#define IVSR_STRIP_PATCH_HPP
+
+#include <vector>
+
+#include "ivsr_memory.hpp"
+#include "ivsr_smart_patch.hpp"
+
+/**
+ * @brief staging of one frame size, reused by the frames of a handle.
+ * Patches are placed like SmartPatch places them and overlaps are averaged the same way. A pixel is covered
+ * by every row and every column of patches overlapping it, so its count is the product of two per-axis
+ * counts and no pixel counter is needed.
+ */
+class StripPatch {
+public:
+    StripPatch(const PatchConfig& config, int frameHeight, int frameWidth,
+               MemoryAccount* memory = nullptr, int numaNode = -1);
+    ~StripPatch();
+
+    StripPatch(const StripPatch&) = delete;
+    StripPatch& operator=(const StripPatch&) = delete;
+
+    // input and output patches of two rows
+    static size_t stagingBytes(const PatchConfig& config, int frameHeight, int frameWidth);
+
+    int rows() const {
+        return static_cast<int>(_rowStarts.size());
+    }
+    int columns() const {
+        return static_cast<int>(_columnStarts.size());
+    }
+
+    // patches of a row live in ring slot row % 2 until the row is merged
+    char* inputPatch(int row, int column) const;
+    char* outputPatch(int row, int column) const;
+
+    // copy the patches of a row out of the input frame
+    void split(int row, const char* input) const;
+
+    /**
+     * @brief add the inferred patches of a row into the output frame.
+     * Rows are merged in order, output rows no later patch row covers are averaged and final afterwards.
+     */
+    void merge(int row, char* output) const;
+
+private:
+    PatchConfig _config;
+    int _planes;  // nif * channels
+    int _height;
+    int _width;
+    std::vector<int> _rowStarts;  // input patch corners along each axis
+    std::vector<int> _columnStarts;
+    std::vector<int> _outRowStarts;  // output patch corners, placed on the output frame like SmartPatch does
+    std::vector<int> _outColumnStarts;
+    std::vector<int> _rowCounts;  // patches covering each output row
+    std::vector<int> _columnCounts;
+    size_t _inPatchSize;  // floats
+    size_t _outPatchSize;
+    float* _staging = nullptr;
+    size_t _stagingBytes = 0;
+    MemoryAccount* _memory = nullptr;
+};
+
+#endif  // IVSR_STRIP_PATCH_HPP
@@ -0,0 +1,95 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file ivsr_tracer.hpp
+ * runtime-enabled timeline tracer,
+ * spans are recorded into per-thread buffers and written as a Chrome trace JSON file
+ * which can be opened in chrome://tracing or Perfetto.
+ */
+
+#ifndef IVSR_TRACER_HPP
+#define IVSR_TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "utils.hpp"
+
+class Tracer {
+public:
+    /**
+     * @brief start tracing into path, tracing is shared by all handles of the process.
+     * Every successful call must be paired with release(), the file is written by the last one.
+     */
+    static bool acquire(const std::string& path);
+
+    static void release();
+
+    /**
+     * @brief write the trace of handles which are never released, called at process exit.
+     */
+    static void release_all();
+
+    static bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief record a complete span, name must be a string literal.
+     * Ids which do not apply are -1.
+     */
+    static void record(const char* name,
+                       Time::time_point start,
+                       Time::time_point end,
+                       int64_t frame = -1,
+                       int32_t patch = -1,
+                       int32_t request = -1);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief RAII span, it costs one relaxed load when tracing is disabled.
+ */
+class TraceScope {
+public:
+    TraceScope(const char* name, int64_t frame = -1, int32_t patch = -1, int32_t request = -1)
+        : name_(Tracer::enabled() ? name : nullptr),
+          frame_(frame),
+          patch_(patch),
+          request_(request) {
+        if (name_)
+            start_ = Time::now();
+    }
+
+    ~TraceScope() {
+        if (name_)
+            Tracer::record(name_, start_, Time::now(), frame_, patch_, request_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    int64_t frame_;
+    int32_t patch_;
+    int32_t request_;
+    Time::time_point start_;
+};
+
+#endif  // IVSR_TRACER_HPP
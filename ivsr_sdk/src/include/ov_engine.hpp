@@ -21,10 +21,16 @@
 #ifndef OV_ENGINE_HPP
 #define OV_ENGINE_HPP
 
+#include <atomic>
 #include <condition_variable>
 #include <queue>
+#include <set>
+#include <thread>
 
 #include "engine.hpp"
+#include "ivsr_memory.hpp"
+#include "ivsr_perf_stats.hpp"
+#include "ivsr_tracer.hpp"
 #include "openvino/core/layout.hpp"
 #include "openvino/openvino.hpp"
 #include "openvino/pass/make_stateful.hpp"
@@ -84,16 +90,58 @@ public:
     void set_callback(std::function<void(std::exception_ptr)> callback) {
         request_.set_callback(std::move(callback));
     }
+
+    void wait() {
+        request_.wait();
+    }
+
+    void reset_state() {
+        for (auto&& state : request_.query_state())
+            state.reset();
+    }
+
+    // tensors allocated for the request, replaced input/output tensors are user memory and not counted
+    size_t tensor_bytes() {
+        size_t bytes = request_.get_input_tensor().get_byte_size() + request_.get_output_tensor().get_byte_size();
+        for (auto&& state : request_.query_state())
+            bytes += state.get_state().get_byte_size();
+        return bytes;
+    }
+
+    // padded input (index 0) or output (index 1) of a dynamic shape model, grown bytes are returned in grown
+    char* staging(int index, size_t bytes, size_t& grown) {
+        auto& buffer = staging_[index];
+        grown = bytes > buffer.size() ? bytes - buffer.size() : 0;
+        if (grown)
+            buffer.resize(bytes);
+        return buffer.data();
+    }
+
     void call_back() {
         callback_(id_);
     }
 
+    size_t id() const {
+        return id_;
+    }
+
+    // state epoch of the engine the recurrent state of the request belongs to
+    uint64_t state_epoch() const {
+        return stateEpoch_;
+    }
+
+    void set_state_epoch(uint64_t epoch) {
+        stateEpoch_ = epoch;
+    }
+
 private:
     ov::InferRequest request_;
     size_t id_;
+    uint64_t stateEpoch_ = 0;
     Time::time_point startTime_;
     Time::time_point endTime_;
     CallbackFunction callback_;
+    std::vector<char> staging_[2];
 };
 
 class ov_engine : public engine<ov_engine> {
@@ -104,13 +152,15 @@ public:
               std::map<std::string, ov::AnyMap> configs,
               const std::vector<size_t>& reshape_settings,
               const tensor_desc_t input_tensor_desc,
-              const tensor_desc_t output_tensor_desc)
+              const tensor_desc_t output_tensor_desc,
+              const std::vector<size_t>& dynamic_align = {})
         : engine(this),
           device_(device),
           configs_(configs),
           reshape_settings_(reshape_settings),
           input_tensor_desc_(input_tensor_desc),
           output_tensor_desc_(output_tensor_desc),
+          dynamic_align_(dynamic_align),
           custom_lib_(custom_lib),
           model_path_(model_path) {
         // init();
@@ -118,15 +168,78 @@ public:
 
     IVSRStatus init_impl();
 
+    // An engine of the same compiled model for ivsr_clone, ready for create_infer_requests().
+    // The model and everything init() derived from it are shared, the weights stay charged to this engine.
+    ov_engine* clone() const;
+
     IVSRStatus run_impl(InferTask::Ptr task);
 
-    IVSRStatus process_impl(void* input_data, void* output_data, void* cb = nullptr);
+    IVSRStatus process_impl(InferTask::Ptr task);
+
+    // same as process_impl() but returns WOULD_BLOCK instead of waiting for a free request
+    IVSRStatus try_process_impl(InferTask::Ptr task);
+
+    // called without the pool lock every time a request goes back to the idle queue
+    PerfStats& perf_stats() {
+        return perf_stats_;
+    }
+
+    MemoryAccount& memory() {
+        return memory_;
+    }
+
+    // weights of the compiled model, known after init()
+    size_t model_bytes() const {
+        return model_bytes_;
+    }
+
+    // one input tensor in the tensor precision, known after init(). The largest one of a dynamic shape model
+    size_t input_bytes() const {
+        return ov::shape_size(input_shape_) * input_.get_element_type().size();
+    }
+
+    // one output tensor in the tensor precision, the largest one of a dynamic shape model
+    size_t output_bytes() const {
+        return ov::shape_size(output_shape_) * output_.get_element_type().size();
+    }
+
+    bool is_dynamic() const {
+        return !dynamic_align_.empty();
+    }
+
+    // tensors of one infer request, known after the first request is created
+    size_t request_bytes() const {
+        return request_bytes_;
+    }
+
+    void set_ready_notifier(std::function<void()> notifier) {
+        ready_notifier_ = std::move(notifier);
+    }
+
+    // Latency of a task submitted now: the rounds of inferences queued before it on the requests, plus its own.
+    // Based on the recent inference latency, 0 until an inference has finished.
+    double predict_latency_ms() {
+        double infer_ms = recent_infer_ms_.load(std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (idleIds_.size() > waiters_.size() || requests_.empty())
+            return infer_ms;
+        size_t rounds = (waiters_.size() - idleIds_.size()) / requests_.size() + 1;
+        return (rounds + 1) * infer_ms;
+    }
+
+    // Frames the model did not see break the hidden state of a recurrent model,
+    // every request resets its state before its next inference.
+    void reset_states() {
+        state_epoch_.fetch_add(1, std::memory_order_release);
+    }
 
     template <typename T>
     IVSRStatus get_attr_impl(const std::string& key, T& value) {
         static_assert(std::is_same<T, ov::Shape>::value || std::is_same<T, size_t>::value ||
-                          std::is_same<T, tensor_desc_t>::value,
-                      "get_attr() is only supported for 'ov::Shape' and 'size_t' types");
+                          std::is_same<T, tensor_desc_t>::value || std::is_same<T, double>::value ||
+                          std::is_same<T, ivsr_perf_stats_t>::value || std::is_same<T, ivsr_memory_usage_t>::value,
+                      "get_attr() is only supported for 'ov::Shape', 'size_t', 'tensor_desc_t', 'double', "
+                      "'ivsr_perf_stats_t' and 'ivsr_memory_usage_t' types");
 /*
         auto extend_shape = [](ov::Shape& shape, size_t dims) {
             if (shape.size() < dims)
@@ -149,7 +262,8 @@ public:
             }
 
             layout = ov::layout::get_layout(node).to_string();
-            shape = node.get_shape();
+            // the upper bounds of a dynamic shape model
+            shape = key == "model_inputs" ? input_shape_ : output_shape_;
             element_type = node.get_element_type().get_type_name();
             memcpy((char*)value.precision, element_type.c_str(), element_type.size());
             memcpy((char*)value.layout, layout.c_str(), layout.size());
@@ -159,8 +273,34 @@ public:
             }
         } else if constexpr (std::is_same<T, size_t>::value) {
             if (key == "input_dims" || key == "output_dims") {
-                const auto& shape = (key == "input_dims") ? input_.get_shape() : output_.get_shape();
+                const auto& shape = (key == "input_dims") ? input_shape_ : output_shape_;
                 value = shape.size() < 5 ? 5 : shape.size();
+            } else if (key == "deadline_missed") {
+                value = deadline_missed_.load();
+            } else {
+                return UNSUPPORTED_KEY;
+            }
+        } else if constexpr (std::is_same<T, double>::value) {
+            if (key == "warmup_duration") {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] {
+                    return !warmup_running_;
+                });
+                value = warmup_duration_ms_;
+                // a failed background warmup is reported here, ivsr_init returned before it finished
+                return warmup_status_;
+            } else {
+                return UNSUPPORTED_KEY;
+            }
+        } else if constexpr (std::is_same<T, ivsr_perf_stats_t>::value) {
+            if (key == "perf_stats") {
+                perf_stats_.snapshot(value);
+            } else {
+                return UNSUPPORTED_KEY;
+            }
+        } else if constexpr (std::is_same<T, ivsr_memory_usage_t>::value) {
+            if (key == "memory_usage") {
+                memory_.snapshot(value);
             } else {
                 return UNSUPPORTED_KEY;
             }
@@ -169,28 +309,56 @@ public:
         return OK;
     }
 
-    inferReqWrap::Ptr get_idle_request() {
+    // A free request goes to the waiting task that is scheduled first, not to the first thread woken up.
+    inferReqWrap::Ptr get_idle_request(const InferTask& task) {
+        TraceScope trace("wait_for_request", task.frameId_, task.patchId_);
         std::unique_lock<std::mutex> lock(mutex_);
 #ifdef ENABLE_LOG
         std::cout << "[Trace]: "
-                  << "idleIds size: " << idleIds_.size() << std::endl;
+                  << "idleIds size: " << idleIds_.size() << " waiters: " << waiters_.size() << std::endl;
 #endif
-        cv_.wait(lock, [this] {
-            return idleIds_.size() > 0;
+        auto waiter = waiters_.insert(&task).first;
+        cv_.wait(lock, [&] {
+            return idleIds_.size() > 0 && waiters_.begin() == waiter;
         });
+        waiters_.erase(waiter);
         auto request = requests_.at(idleIds_.front());
         idleIds_.pop();
+        if (!idleIds_.empty() && !waiters_.empty())
+            cv_.notify_all();
         return request;
     }
 
-    void put_idle_request(size_t id) {
+    // Blocked waiters keep their turn, a try-submit only gets a request nobody is waiting for.
+    inferReqWrap::Ptr try_get_idle_request() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (idleIds_.empty() || !waiters_.empty())
+            return nullptr;
+        auto request = requests_.at(idleIds_.front());
+        idleIds_.pop();
+        return request;
+    }
+
+    // requests a try-submit could take now, counting the new ones of a pool grown to pool_size
+    size_t available_requests(size_t pool_size) {
         std::unique_lock<std::mutex> lock(mutex_);
-        idleIds_.push(id);
+        if (!waiters_.empty())
+            return 0;
+        return idleIds_.size() + (pool_size > requests_.size() ? pool_size - requests_.size() : 0);
+    }
+
+    void put_idle_request(size_t id) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idleIds_.push(id);
 #ifdef ENABLE_LOG
-        std::cout << "[Trace]: "
-                  << "put_idle_request: idleIds size: " << idleIds_.size() << std::endl;
+            std::cout << "[Trace]: "
+                      << "put_idle_request: idleIds size: " << idleIds_.size() << std::endl;
 #endif
-        cv_.notify_one();
+            cv_.notify_all();
+        }
+        if (ready_notifier_)
+            ready_notifier_();
     }
 
     void wait_all_impl() {
@@ -207,15 +375,23 @@ public:
 
     IVSRStatus create_infer_requests_impl(size_t requests_num);
 
+    IVSRStatus warmup_impl(size_t iterations, bool background);
+
     const size_t get_infer_requests_size_impl() {
+        std::unique_lock<std::mutex> lock(mutex_);
         return requests_.size();
     }
 
     ~ov_engine() {
+        if (warmup_thread_.joinable())
+            warmup_thread_.join();
         requests_.clear();
     }
 
 private:
+    struct CloneTag {};
+    ov_engine(const ov_engine& source, CloneTag);
+
     std::string device_;
     std::queue<size_t> idleIds_;
     std::vector<inferReqWrap::Ptr> requests_;
@@ -228,12 +404,60 @@ private:
     std::vector<size_t> reshape_settings_;
     tensor_desc_t input_tensor_desc_;
     tensor_desc_t output_tensor_desc_;
+    std::vector<size_t> dynamic_align_;  // {height, width} alignment of a dynamic shape model, empty if static
 
     std::string custom_lib_;
     std::string model_path_;
+    std::shared_ptr<const void> source_model_;  // decrypted protected model shared with other handles
 
     ov::Output<ov::Node> input_;
     ov::Output<ov::Node> output_;
+    ov::Shape input_shape_;   // static shape, or upper bounds of a dynamic shape model
+    ov::Shape output_shape_;
+    size_t input_h_idx_ = 0;  // height and width dims of the dynamic shape
+    size_t input_w_idx_ = 0;
+    size_t output_h_idx_ = 0;
+    size_t output_w_idx_ = 0;
+
+    struct WaiterOrder {
+        bool operator()(const InferTask* a, const InferTask* b) const {
+            return a->scheduled_before(*b);
+        }
+    };
+    std::set<const InferTask*, WaiterOrder> waiters_;  // tasks blocked in get_idle_request()
+    std::atomic<size_t> deadline_missed_{0};
+    std::atomic<double> recent_infer_ms_{0.0};  // moving average of the inference latency
+    std::atomic<uint64_t> state_epoch_{0};
+
+    PerfStats perf_stats_;
+    MemoryAccount memory_;
+    size_t model_bytes_ = 0;
+    size_t request_bytes_ = 0;
+
+    void on_task_done(const InferTask& task) {
+        if (task.deadline_missed())
+            ++deadline_missed_;
+        perf_stats_.queueWait.record(task.submitTime_, task._startTime);
+        perf_stats_.inference.record(task._startTime, task._endTime);
+        if (task.status_ == OK) {
+            double infer_ms = std::chrono::duration<double, std::milli>(task._endTime - task._startTime).count();
+            double recent = recent_infer_ms_.load(std::memory_order_relaxed);
+            recent_infer_ms_.store(recent > 0.0 ? recent + (infer_ms - recent) / 8 : infer_ms,
+                                   std::memory_order_relaxed);
+        }
+        if (task.patchId_ >= 0)
+            perf_stats_.patches.fetch_add(1, std::memory_order_relaxed);
+        if (task.status_ != OK)
+            perf_stats_.failed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::function<void()> ready_notifier_;
+    IVSRStatus submit_request(inferReqWrap::Ptr inferReq, InferTask::Ptr task);
+
+    std::thread warmup_thread_;
+    bool warmup_running_ = false;
+    double warmup_duration_ms_ = 0.0;
+    IVSRStatus warmup_status_ = OK;  // of the last warmup
 };
 
 #endif  // OV_ENGINE_HPP
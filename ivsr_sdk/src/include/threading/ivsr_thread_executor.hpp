@@ -36,8 +36,10 @@ using Task = InferTask::Ptr;
 struct Config {
     std::string _name;
     int _threads = 5;  //!< Number of threads.
+    int _numaNode = -1;  //!< NUMA node the threads run on, -1 for any CPU.
 
-    Config(std::string name = "IVSRThreadsExecutor", int threads = 1) : _name(name), _threads(threads){};
+    Config(std::string name = "IVSRThreadsExecutor", int threads = 1, int numaNode = -1)
+        : _name(name), _threads(threads), _numaNode(numaNode){};
 };
 
 /**
@@ -81,8 +83,9 @@ public:
 
     /**
      * @brief interface to sync all the tasks
+     * @return the first failure of the tasks, OK if all of them succeeded
      */
-    void wait_all(int patchSize);
+    IVSRStatus wait_all(int patchSize);
 
     /**
      * @brief interface to get total duration
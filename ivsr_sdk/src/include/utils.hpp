@@ -75,7 +75,8 @@ inline void ivsr_status_log(IVSRStatus status, const char* log) {
         {IVSRStatus::UNSUPPORTED_CONFIG, "[Error] Unsupported configs"},
         {IVSRStatus::UNKNOWN_ERROR, "[Unknown Error] Process failed"},
         {IVSRStatus::EXCEPTION_ERROR, "[Exception] Exception occurred"},
-        {IVSRStatus::UNSUPPORTED_SHAPE, "[Error] Unsupported input shape"}
+        {IVSRStatus::UNSUPPORTED_SHAPE, "[Error] Unsupported input shape"},
+        {IVSRStatus::OUT_OF_MEMORY_BUDGET, "[Error] Out of memory budget"}
     };
 
     auto it = status_messages.find(status);
@@ -89,6 +90,8 @@ inline void ivsr_status_log(IVSRStatus status, const char* log) {
             std::cout << ", please check the input configs.";
         } else if (status == IVSRStatus::UNSUPPORTED_SHAPE) {
             std::cout << ", please check the input frame's size.";
+        } else if (status == IVSRStatus::OUT_OF_MEMORY_BUDGET) {
+            std::cout << ", please raise MAX_MEMORY or use a smaller model.";
         }
 
         std::cout << "." << std::endl;
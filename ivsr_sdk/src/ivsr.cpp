@@ -20,12 +20,29 @@
 #include "ov_engine.hpp"
 #include "InferTask.hpp"
 #include "ivsr_smart_patch.hpp"
+#include "ivsr_strip_patch.hpp"
+#include "ivsr_cpu_isa.hpp"
+#include "ivsr_resampler.hpp"
+#include "ivsr_completion_queue.hpp"
+#include "ivsr_frame_window.hpp"
+#include "ivsr_numa.hpp"
+#include "ivsr_reorder_buffer.hpp"
+#include "ivsr_async_init.hpp"
+#include "ivsr_perf_stats.hpp"
+#include "ivsr_tracer.hpp"
+#include "ivsr_service.hpp"
 #include "threading/ivsr_thread_executor.hpp"
 #include "utils.hpp"
 #include <mutex>
 #include <sstream>
 #include <cctype>
 #include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <unordered_set>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 std::vector<std::string> parse_devices(const std::string& device_string) {
     std::string comma_separated_devices = device_string;
@@ -45,10 +62,62 @@ std::vector<std::string> parse_devices(const std::string& device_string) {
     return result;
 }
 
+bool parse_priority(const std::string& name, IVSRPriority& priority) {
+    if (name == "HIGH") {
+        priority = IVSR_PRIORITY_HIGH;
+    } else if (name == "MEDIUM") {
+        priority = IVSR_PRIORITY_MEDIUM;
+    } else if (name == "LOW") {
+        priority = IVSR_PRIORITY_LOW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// "<bytes>" with an optional "K", "M" or "G" suffix, in multiples of 1024
+bool parse_memory_size(const std::string& value, size_t& bytes) {
+    size_t pos = 0;
+    unsigned long long number = 0;
+    try {
+        number = std::stoull(value, &pos);
+    } catch (const std::exception& e) {
+        return false;
+    }
+    std::string suffix = value.substr(pos);
+    int shift = 0;
+    if (suffix.empty())
+        shift = 0;
+    else if (suffix == "K" || suffix == "k")
+        shift = 10;
+    else if (suffix == "M" || suffix == "m")
+        shift = 20;
+    else if (suffix == "G" || suffix == "g")
+        shift = 30;
+    else
+        return false;
+    bytes = static_cast<size_t>(number) << shift;
+    return bytes > 0;
+}
+
+ov::hint::Priority to_model_priority(IVSRPriority priority) {
+    switch (priority) {
+    case IVSR_PRIORITY_HIGH:
+        return ov::hint::Priority::HIGH;
+    case IVSR_PRIORITY_LOW:
+        return ov::hint::Priority::LOW;
+    default:
+        return ov::hint::Priority::MEDIUM;
+    }
+}
+
 void parse_engine_config(std::map<std::string, ov::AnyMap>& config,
                          const std::string& device,
                          const std::string& infer_precision,
-                         const std::string& cldnn_config) {
+                         const std::string& cldnn_config,
+                         const std::string& model_priority) {
+    IVSRPriority priority = IVSR_PRIORITY_MEDIUM;
+    parse_priority(model_priority, priority);
     auto getDeviceTypeFromName = [](std::string device) -> std::string {
         return device.substr(0, device.find_first_of(".("));
     };
@@ -98,6 +167,9 @@ void parse_engine_config(std::map<std::string, ov::AnyMap>& config,
         try {
             // set throughput streams and infer precision for hardwares
             if (d == "MULTI" || d == "AUTO") {
+                // AUTO/MULTI and GPU arbitrate device time between compiled models by model priority
+                if (!model_priority.empty())
+                    device_config.emplace(ov::hint::model_priority(to_model_priority(priority)));
                 for (auto& hd : hardware_devices) {
                     auto& property = device_config[hd].as<ov::AnyMap>();
                     property.emplace(ov::device::properties(hd, ov::num_streams(nstream)));
@@ -106,6 +178,8 @@ void parse_engine_config(std::map<std::string, ov::AnyMap>& config,
                 }
             } else if (d.find("GPU") != std::string::npos) {  // GPU
                 device_config.emplace(ov::num_streams(nstream));
+                if (!model_priority.empty())
+                    device_config.emplace(ov::hint::model_priority(to_model_priority(priority)));
                 if (!infer_precision.empty())
                     device_config.emplace(ov::hint::inference_precision(infer_precision));
             } else {  // CPU
@@ -188,38 +262,375 @@ std::vector<size_t> convert_string_to_vector(const std::string& input) {
     return result;
 }
 
+// Luma-only mode: the Y plane goes through the model, U/V planes are resampled by the SDK.
+// Buffers are planar YUV 4:2:0, Y plane first, so the model tensors alias the Y planes directly.
+struct LumaOnlyConfig {
+    std::unique_ptr<PlaneResampler> resampler;
+    PlaneType inType = PlaneType::U8;
+    PlaneType outType = PlaneType::U8;
+    float maxValue = 255.0f;  // clamp range of the input samples
+    float outScale = 1.0f;    // 1 / normalize factor when the model outputs float
+    size_t inLumaBytes = 0;
+    size_t inChromaBytes = 0;
+    size_t outLumaBytes = 0;
+    size_t outChromaBytes = 0;
+};
+
+static std::unique_ptr<LumaOnlyConfig> create_luma_only_config(ResampleFilter filter,
+                                                               const tensor_desc_t& model_input,
+                                                               const tensor_desc_t& model_output,
+                                                               float input_scale,
+                                                               size_t frame_width,
+                                                               size_t frame_height,
+                                                               int scale) {
+    auto is_single_channel = [](const tensor_desc_t& desc) {
+        ov::Layout layout(desc.layout);
+        return desc.dimension == 4 && ov::layout::has_channels(layout) &&
+               desc.shape[ov::layout::channels_idx(layout)] == 1;
+    };
+    if (!is_single_channel(model_input) || !is_single_channel(model_output)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LUMA_ONLY requires a 4D model with Y input and Y output");
+        return nullptr;
+    }
+
+    std::unique_ptr<LumaOnlyConfig> cfg(new LumaOnlyConfig());
+    if (!parse_plane_type(model_input.precision, cfg->inType) || cfg->inType == PlaneType::F32 ||
+        !parse_plane_type(model_output.precision, cfg->outType)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LUMA_ONLY supports u8/u16 input and u8/u16/f32 output");
+        return nullptr;
+    }
+
+    if (input_scale > 1.0f) {
+        cfg->maxValue = input_scale;
+        cfg->outScale = cfg->outType == PlaneType::F32 ? 1.0f / input_scale : 1.0f;
+    } else {
+        cfg->maxValue = cfg->inType == PlaneType::U8 ? 255.0f : 65535.0f;
+    }
+
+    size_t out_width = frame_width * scale, out_height = frame_height * scale;
+    int chroma_width = static_cast<int>((frame_width + 1) / 2), chroma_height = static_cast<int>((frame_height + 1) / 2);
+    int out_chroma_width = static_cast<int>((out_width + 1) / 2), out_chroma_height = static_cast<int>((out_height + 1) / 2);
+    cfg->inLumaBytes = frame_width * frame_height * get_plane_type_size(cfg->inType);
+    cfg->inChromaBytes = static_cast<size_t>(chroma_width) * chroma_height * get_plane_type_size(cfg->inType);
+    cfg->outLumaBytes = out_width * out_height * get_plane_type_size(cfg->outType);
+    cfg->outChromaBytes = static_cast<size_t>(out_chroma_width) * out_chroma_height * get_plane_type_size(cfg->outType);
+    cfg->resampler.reset(new PlaneResampler(filter, chroma_width, chroma_height, out_chroma_width, out_chroma_height));
+    return cfg;
+}
+
+// Resample U and V planes of one frame, the Y plane is written by the inference.
+static void upscale_chroma_planes(const LumaOnlyConfig& cfg, const char* input_data, char* output_data, int64_t frame) {
+    TraceScope trace("chroma_resample", frame);
+    for (int plane = 0; plane < 2; ++plane) {
+        const char* src = input_data + cfg.inLumaBytes + plane * cfg.inChromaBytes;
+        char* dst = output_data + cfg.outLumaBytes + plane * cfg.outChromaBytes;
+        cfg.resampler->resample(src, cfg.inType, dst, cfg.outType, cfg.maxValue, cfg.outScale);
+    }
+}
+
+// Latency budget: a frame predicted to finish later than the budget is upscaled by the SDK instead of the model.
+// Buffers are planar, each channel of the model tensors (the Y plane in LUMA_ONLY mode) is resampled on its own.
+struct FallbackConfig {
+    double budgetMs = 0.0;
+    std::unique_ptr<PlaneResampler> resampler;
+    PlaneType inType = PlaneType::U8;
+    PlaneType outType = PlaneType::U8;
+    float maxValue = 255.0f;  // clamp range of the input samples
+    float outScale = 1.0f;    // 1 / normalize factor when the model outputs float
+    size_t planes = 0;
+    size_t inPlaneBytes = 0;
+    size_t outPlaneBytes = 0;
+};
+
+static std::unique_ptr<FallbackConfig> create_fallback_config(ResampleFilter filter,
+                                                              double budget_ms,
+                                                              const tensor_desc_t& model_input,
+                                                              const tensor_desc_t& model_output,
+                                                              const tensor_desc_t& input_desc) {
+    // the tensor is the frame: one batch of channel planes
+    auto is_planar = [](const tensor_desc_t& desc) {
+        ov::Layout layout(desc.layout);
+        return desc.dimension == 4 && ov::layout::has_channels(layout) && ov::layout::has_height(layout) &&
+               ov::layout::has_width(layout) && ov::layout::channels_idx(layout) == 1 &&
+               ov::layout::height_idx(layout) == 2 && ov::layout::width_idx(layout) == 3 && desc.shape[0] == 1;
+    };
+    if (!is_planar(model_input) || !is_planar(model_output) || model_input.shape[1] != model_output.shape[1]) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LATENCY_BUDGET requires a 4D NCHW model with as many output as input channels");
+        return nullptr;
+    }
+    // the fallback can not reproduce a color conversion of the model
+    if (input_desc.tensor_color_format[0] != '\0' && input_desc.model_color_format[0] != '\0' &&
+        std::string(input_desc.tensor_color_format) != std::string(input_desc.model_color_format)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LATENCY_BUDGET can not be used with a color conversion");
+        return nullptr;
+    }
+
+    std::unique_ptr<FallbackConfig> cfg(new FallbackConfig());
+    if (!parse_plane_type(model_input.precision, cfg->inType) || !parse_plane_type(model_output.precision, cfg->outType) ||
+        (cfg->inType == PlaneType::F32 && cfg->outType != PlaneType::F32)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LATENCY_BUDGET supports u8/u16 input, or f32 input with f32 output");
+        return nullptr;
+    }
+
+    if (input_desc.scale > 1.0f) {
+        cfg->maxValue = input_desc.scale;
+        cfg->outScale = cfg->outType == PlaneType::F32 ? 1.0f / input_desc.scale : 1.0f;
+    } else if (cfg->inType == PlaneType::F32) {
+        cfg->maxValue = std::numeric_limits<float>::max();  // the range of float samples is the model's
+    } else {
+        cfg->maxValue = cfg->inType == PlaneType::U8 ? 255.0f : 65535.0f;
+    }
+
+    int width = static_cast<int>(model_input.shape[3]), height = static_cast<int>(model_input.shape[2]);
+    int out_width = static_cast<int>(model_output.shape[3]), out_height = static_cast<int>(model_output.shape[2]);
+    cfg->budgetMs = budget_ms;
+    cfg->planes = model_input.shape[1];
+    cfg->inPlaneBytes = static_cast<size_t>(width) * height * get_plane_type_size(cfg->inType);
+    cfg->outPlaneBytes = static_cast<size_t>(out_width) * out_height * get_plane_type_size(cfg->outType);
+    cfg->resampler.reset(new PlaneResampler(filter, width, height, out_width, out_height));
+    return cfg;
+}
+
 struct ivsr {
     engine<ov_engine>* inferEngine;
-    IVSRThread::IVSRThreadExecutor* threadExecutor;
+    IVSRThread::IVSRThreadExecutor* threadExecutor;  // created at the first ivsr_process of a clone
+    std::once_flag executorOnce;
     std::unordered_map<std::string, std::string> vsr_config;
     PatchConfig patchConfig;
     bool patchSolution;
+    bool stripPatches = false;  // PATCH_MODE strip
+    std::mutex stripMutex;
+    std::vector<std::unique_ptr<StripPatch>> stripStaging;  // idle staging rings of PATCH_MODE strip
     std::vector<size_t> input_data_shape;  // shape of input data
+    std::shared_ptr<const LumaOnlyConfig> lumaOnly;  // nullptr if LUMA_ONLY is not set, shared with clones
+    std::shared_ptr<const FallbackConfig> fallback;  // nullptr if LATENCY_BUDGET is not set, shared with clones
+    std::unique_ptr<FrameWindow> frameWindow;  // nullptr if TEMPORAL_WINDOW is not set
+    std::unique_ptr<ReorderBuffer> reorderBuffer;  // nullptr if FRAME_PARALLEL is not set
+    int numaNode = -1;  // NUMA_NODE of the handle, -1 if it is not set
+    bool dynamicShape = false;  // frame size may change per submission up to the patch size
+    IVSRPriority priority = IVSR_PRIORITY_MEDIUM;  // used when a submission has no task option
+    int readyEventFd = -1;  // signaled by the engine whenever an infer request becomes free
+    CompletionQueue completionQueue;  // events of ivsr_submit
+    std::atomic<int64_t> frameCounter{0};  // frame id of trace spans
+    bool tracing = false;
+    std::unique_ptr<ServiceClient> service;  // set for a SERVICE_SOCKET handle, which has no engine
+    std::mutex bufferMutex;
+    std::unordered_set<void*> buffers;  // ivsr_buffer_alloc of a local handle
+    // set by ivsr_init_async, the members above are written by its thread until it is ready
+    std::unique_ptr<AsyncInit> asyncInit;
 
     ivsr()
-        : threadExecutor(nullptr),
+        : inferEngine(nullptr),
+          threadExecutor(nullptr),
           patchSolution(false) {}
-
-    // Define a constructor to initialize engine and other members if needed
-    ivsr(engine<ov_engine>* engine,
-         IVSRThread::IVSRThreadExecutor* executor,
-         const std::unordered_map<std::string, std::string>& config,
-         const PatchConfig& patch,
-         std::vector<size_t> shape,
-         bool sol = false)
-        : inferEngine(engine),
-          threadExecutor(executor),
-          vsr_config(config),
-          patchConfig(patch),
-          patchSolution(sol),
-          input_data_shape(std::move(shape)) {}
 };
 
-IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
-    if (configs == nullptr || handle == nullptr) {
-        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_init");
-        return IVSRStatus::GENERAL_ERROR;
+static PatchConfig build_patch_config(ov_engine* engine) {
+    tensor_desc_t input_tensor = {
+        .precision = {0},
+        .layout = {0},
+        .tensor_color_format = {0},
+        .model_color_format = {0},
+        .scale = 0.0,
+        .dimension = 0,
+        .shape = {0}};
+    engine->get_attr("model_inputs", input_tensor);
+
+    tensor_desc_t output_tensor = {
+        .precision = {0},
+        .layout = {0},
+        .tensor_color_format = {0},
+        .model_color_format = {0},
+        .scale = 0.0,
+        .dimension = 0,
+        .shape = {0}};
+    engine->get_attr("model_outputs", output_tensor);
+
+    PatchConfig patchConfig;
+    int m_input_width = input_tensor.shape[ov::layout::width_idx(ov::Layout(input_tensor.layout))];;
+    int m_input_height = input_tensor.shape[ov::layout::height_idx(ov::Layout(input_tensor.layout))];
+    // hard code
+    int nif = input_tensor.dimension == 5 ? input_tensor.shape[1] : 1;
+    int m_output_width = output_tensor.shape[ov::layout::width_idx(ov::Layout(output_tensor.layout))];
+    patchConfig.scale = m_output_width / m_input_width;
+    patchConfig.patchHeight = m_input_height;
+    patchConfig.patchWidth = m_input_width;
+    patchConfig.dims = input_tensor.dimension;
+    patchConfig.nif = nif;
+    patchConfig.channels = input_tensor.shape[ov::layout::channels_idx(ov::Layout(input_tensor.layout))];
+    return patchConfig;
+}
+
+// Smallest patch side MAX_MEMORY may shrink a reshapeable model to.
+static const size_t kMinBudgetPatchSize = 64;
+
+// Fits the handle into max_memory: fewer infer requests first, then halved patches if RESHAPE_SETTINGS is set.
+// Patch staging is a frame of patches, or two rows of them with strip_patches, and the infer requests of a
+// patched frame are counted as the pool grows at runtime.
+// The engine is re-created with the new patch size, the first infer request of the result is created already.
+// A temporal window of window_frames frames keeps one more frame per infer request.
+static IVSRStatus fit_memory_budget(ov_engine*& engine,
+                                    const std::function<ov_engine*()>& create_engine,
+                                    size_t max_memory,
+                                    int frame_width,
+                                    int frame_height,
+                                    int window_frames,
+                                    bool strip_patches,
+                                    std::vector<size_t>& reshape_settings,
+                                    size_t& infer_request_num) {
+    while (true) {
+        // the first request tells the size of every request
+        if (engine->create_infer_requests(1) != IVSRStatus::OK)
+            return IVSRStatus::GENERAL_ERROR;
+
+        PatchConfig patch = build_patch_config(engine);
+        const bool patched = patch.patchHeight < frame_height || patch.patchWidth < frame_width;
+        size_t staging = 0;
+        if (patched && strip_patches)
+            staging = StripPatch::stagingBytes(patch, frame_height, frame_width);
+        else if (patched)
+            staging = SmartPatch::stagingBytes(patch, frame_height, frame_width) +
+                      SmartPatch::pixelCounterBytes(patch, frame_height, frame_width);
+        // patched frames grow the pool to a request per patch, or per patch of a row with strip_patches,
+        // smaller patches do not need fewer request bytes
+        size_t min_requests = 1;
+        if (patched) {
+            size_t rows = (frame_height + patch.patchHeight - 1) / patch.patchHeight;
+            size_t columns = (frame_width + patch.patchWidth - 1) / patch.patchWidth;
+            min_requests = strip_patches ? columns : rows * columns;
+        }
+        size_t fixed = engine->model_bytes() + staging;
+        size_t per_request = engine->request_bytes();
+        if (window_frames > 0) {
+            size_t frame_bytes = engine->input_bytes() / window_frames;
+            fixed += FrameWindow::bytes(frame_bytes, window_frames, window_frames);
+            per_request += frame_bytes;
+        }
+
+        if (fixed + per_request * min_requests <= max_memory) {
+            size_t fit = per_request ? (max_memory - fixed) / per_request : infer_request_num;
+            if (fit < infer_request_num) {
+                std::cout << "[WARNING]: " << "infer requests reduced from " << infer_request_num << " to " << fit
+                          << " to fit MAX_MEMORY.\n";
+                infer_request_num = fit;
+            }
+            std::cout << "[INFO] " << "Memory estimate: "
+                      << fixed + per_request * std::max(infer_request_num, min_requests) << " of " << max_memory
+                      << " bytes" << std::endl;
+            return IVSRStatus::OK;
+        }
+
+        // only a reshapeable model can take smaller patches, RESHAPE_SETTINGS is NHW
+        size_t height = reshape_settings.empty() ? 0 : reshape_settings[1] / 2 / 2 * 2;
+        size_t width = reshape_settings.empty() ? 0 : reshape_settings[2] / 2 / 2 * 2;
+        if (height < kMinBudgetPatchSize || width < kMinBudgetPatchSize) {
+            std::string log = "MAX_MEMORY=" + std::to_string(max_memory) + ", at least " +
+                              std::to_string(fixed + per_request * min_requests) + " bytes are needed";
+            ivsr_status_log(IVSRStatus::OUT_OF_MEMORY_BUDGET, log.c_str());
+            return IVSRStatus::OUT_OF_MEMORY_BUDGET;
+        }
+        std::cout << "[WARNING]: " << "patch size reduced from " << reshape_settings[2] << "x" << reshape_settings[1]
+                  << " to " << width << "x" << height << " to fit MAX_MEMORY.\n";
+        reshape_settings[1] = height;
+        reshape_settings[2] = width;
+
+        delete engine;
+        engine = create_engine();
+        if (engine == nullptr)
+            return IVSRStatus::UNSUPPORTED_SHAPE;
     }
+}
+
+// Strip patches are copied as the f32 planes of one frame: a 4D NCHW or 5D NFCHW tensor of one batch.
+static bool strip_tensor_supported(const tensor_desc_t& desc) {
+    ov::Layout layout(desc.layout);
+    const int64_t dims = desc.dimension;
+    if (std::string(desc.precision) != "f32" || (dims != 4 && dims != 5) || desc.shape[0] != 1 ||
+        !ov::layout::has_channels(layout) || !ov::layout::has_height(layout) || !ov::layout::has_width(layout))
+        return false;
+    return static_cast<int64_t>(ov::layout::channels_idx(layout)) == dims - 3 &&
+           static_cast<int64_t>(ov::layout::height_idx(layout)) == dims - 2 &&
+           static_cast<int64_t>(ov::layout::width_idx(layout)) == dims - 1;
+}
+
+// The window frames are stacked along F of a 5D NFCHW input or along C of a 4D input, e.g. TSENet.
+static IVSRStatus check_temporal_window(int window_frames,
+                                        const tensor_desc_t& model_input,
+                                        const PatchConfig& patch,
+                                        size_t frame_width,
+                                        size_t frame_height,
+                                        bool luma_only) {
+    bool stacked = model_input.dimension == 5 ? patch.nif == window_frames
+                                              : model_input.dimension == 4 && patch.channels % window_frames == 0;
+    if (!stacked) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "TEMPORAL_WINDOW does not match the model input frames");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    if (luma_only) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "TEMPORAL_WINDOW can not be used with LUMA_ONLY");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    if (patch.patchHeight < static_cast<int>(frame_height) || patch.patchWidth < static_cast<int>(frame_width)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "TEMPORAL_WINDOW requires INPUT_RES within the model input");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    return IVSRStatus::OK;
+}
+
+// Readiness notification for non-blocking submission, READY_EVENT_FD and READY_CALLBACK of a handle.
+static int create_ready_event_fd() {
+    int ready_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ready_event_fd < 0)
+        std::cout << "[WARNING]: " << "failed to create the ready eventfd, READY_EVENT_FD is not available.\n";
+    return ready_event_fd;
+}
+
+static std::function<void()> make_ready_notifier(int ready_event_fd, ivsr_cb_t ready_cb) {
+    return [ready_event_fd, ready_cb]() {
+        if (ready_event_fd >= 0) {
+            uint64_t one = 1;
+            ssize_t ret = write(ready_event_fd, &one, sizeof(one));
+            (void)ret;  // EAGAIN means the counter is already signaled
+        }
+        if (ready_cb.ivsr_cb)
+            ready_cb.ivsr_cb(ready_cb.args);
+    };
+}
+
+// The model and infer requests live in ivsr_service, the handle forwards every call to it.
+static IVSRStatus init_service_handle(const ivsr_config_t* configs, const std::string& socket_path, ivsr_handle handle) {
+    ivsr_cb_t ready_cb = {nullptr, nullptr};
+    for (auto config = configs; config != nullptr; config = config->next) {
+        if (config->key == IVSRConfigKey::READY_CALLBACK && config->value != nullptr)
+            ready_cb = *static_cast<const ivsr_cb_t*>(config->value);
+    }
+
+    int ready_event_fd = create_ready_event_fd();
+    std::unique_ptr<ServiceClient> client;
+    IVSRStatus status = ServiceClient::connect(socket_path, configs, make_ready_notifier(ready_event_fd, ready_cb), client);
+    if (status != IVSRStatus::OK) {
+        if (ready_event_fd >= 0)
+            close(ready_event_fd);
+        return status;
+    }
+
+    handle->input_data_shape = {client->info().height, client->info().width};
+    handle->dynamicShape = client->info().dynamicShape != 0;
+    handle->readyEventFd = ready_event_fd;
+    handle->service = std::move(client);
+    return IVSRStatus::OK;
+}
+
+// Initializes an allocated handle, on the caller thread for ivsr_init and in background for ivsr_init_async.
+static IVSRStatus init_handle(ivsr_config_t* configs, ivsr_handle handle) {
+    // SERVICE_SOCKET config takes precedence over the environment, an empty path keeps the handle local
+    const char* service_socket = getenv("IVSR_SERVICE_SOCKET");
+    for (auto config = configs; config != nullptr; config = config->next) {
+        if (config->key == IVSRConfigKey::SERVICE_SOCKET && config->value != nullptr)
+            service_socket = static_cast<const char*>(config->value);
+    }
+    if (service_socket != nullptr && service_socket[0] != '\0')
+        return init_service_handle(configs, service_socket, handle);
 
     // Configuration variables
     std::string model, device, batch, infer_precision;
@@ -231,6 +642,22 @@ IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
     size_t infer_request_num = 1;  // default infer_request_num set to 1
     const tensor_desc_t *input_tensor_desc = nullptr;
     const tensor_desc_t *output_tensor_desc = nullptr;
+    std::string luma_only_filter;
+    ResampleFilter chroma_filter = ResampleFilter::BICUBIC;
+    size_t warmup_iterations = 0;
+    bool warmup_in_background = false;
+    std::string model_priority;
+    IVSRPriority priority = IVSR_PRIORITY_MEDIUM;
+    ivsr_cb_t ready_cb = {nullptr, nullptr};
+    std::string trace_file;
+    size_t max_memory = 0;  // no budget
+    int window_frames = 0;  // no temporal window
+    std::vector<size_t> dynamic_align;  // {height, width}, empty for a static model
+    int frame_parallel = -1;  // frames in flight, 0 for twice the infer requests, <0 keeps completions unordered
+    int numa_node = -1;  // no binding
+    double latency_budget = 0.0;  // no fallback
+    bool strip_patches = false;  // PATCH_MODE frame
+    ResampleFilter fallback_filter = ResampleFilter::BICUBIC;
 
     // Parse input config
     while (configs != nullptr) {
@@ -317,6 +744,112 @@ IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
             case IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING:
                 output_tensor_desc = static_cast<const tensor_desc_t *>(configs->value);
                 break;
+            case IVSRConfigKey::LUMA_ONLY:
+                luma_only_filter = static_cast<const char*>(configs->value);
+                if (!parse_resample_filter(luma_only_filter, chroma_filter)) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for LUMA_ONLY=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                std::cout << "[INFO] " << "Luma only, chroma filter:" << luma_only_filter << std::endl;
+                break;
+            case IVSRConfigKey::WARMUP_ITERATIONS:
+                try {
+                    warmup_iterations = std::stoul(static_cast<const char*>(configs->value));
+                } catch (const std::exception& e) {
+                    unsupported_status = IVSRStatus::UNSUPPORTED_CONFIG;
+                    unsupported_output = "WARMUP_ITERATIONS=" + std::string(static_cast<const char*>(configs->value));
+                }
+                break;
+            case IVSRConfigKey::WARMUP_IN_BACKGROUND:
+                warmup_in_background = std::string(static_cast<const char*>(configs->value)) == "1";
+                break;
+            case IVSRConfigKey::PRIORITY:
+                model_priority = static_cast<const char*>(configs->value);
+                if (!parse_priority(model_priority, priority)) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for PRIORITY=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::TRACE_FILE:
+                trace_file = static_cast<const char*>(configs->value);
+                break;
+            case IVSRConfigKey::MAX_MEMORY:
+                if (!parse_memory_size(static_cast<const char*>(configs->value), max_memory)) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for MAX_MEMORY=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::TEMPORAL_WINDOW:
+                try {
+                    window_frames = std::stoi(static_cast<const char*>(configs->value));
+                } catch (const std::exception& e) {
+                    window_frames = 0;
+                }
+                if (window_frames < 1) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for TEMPORAL_WINDOW=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::FRAME_PARALLEL:
+                try {
+                    frame_parallel = std::stoi(static_cast<const char*>(configs->value));
+                } catch (const std::exception& e) {
+                    frame_parallel = -1;
+                }
+                if (frame_parallel < 0) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for FRAME_PARALLEL=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::NUMA_NODE:
+                numa_node = numa_parse_node(static_cast<const char*>(configs->value));
+                if (numa_node < 0) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for NUMA_NODE=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::DYNAMIC_SHAPE:
+                dynamic_align = convert_string_to_vector(static_cast<const char*>(configs->value));
+                if (dynamic_align.size() == 1)
+                    dynamic_align.push_back(dynamic_align[0]);
+                if (dynamic_align.size() != 2 || dynamic_align[0] == 0 || dynamic_align[1] == 0) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for DYNAMIC_SHAPE=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::READY_CALLBACK:
+                if (configs->value != nullptr)
+                    ready_cb = *static_cast<const ivsr_cb_t*>(configs->value);
+                break;
+            case IVSRConfigKey::LATENCY_BUDGET:
+                try {
+                    latency_budget = std::stod(static_cast<const char*>(configs->value));
+                } catch (const std::exception& e) {
+                    latency_budget = 0.0;
+                }
+                if (latency_budget <= 0.0) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for LATENCY_BUDGET=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::PATCH_MODE: {
+                std::string patch_mode = static_cast<const char*>(configs->value);
+                if (patch_mode != "frame" && patch_mode != "strip") {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for PATCH_MODE=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                strip_patches = patch_mode == "strip";
+                break;
+            }
+            case IVSRConfigKey::FALLBACK_FILTER:
+                if (!parse_resample_filter(static_cast<const char*>(configs->value), fallback_filter)) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for FALLBACK_FILTER=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::SERVICE_SOCKET:
+            case IVSRConfigKey::INIT_QUEUE_SIZE:
+                break;
             default:
                 unsupported_status = IVSRStatus::UNSUPPORTED_KEY;
                 unsupported_output = std::to_string(configs->key);
@@ -336,34 +869,124 @@ IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
         return IVSRStatus::UNSUPPORTED_CONFIG;
     }
 
+    if (latency_budget > 0.0 && (window_frames > 0 || !dynamic_align.empty())) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "LATENCY_BUDGET can not be used with TEMPORAL_WINDOW or DYNAMIC_SHAPE");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    if (!dynamic_align.empty()) {
+        if (!luma_only_filter.empty() || window_frames > 0) {
+            ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "DYNAMIC_SHAPE can not be used with LUMA_ONLY or TEMPORAL_WINDOW");
+            return IVSRStatus::UNSUPPORTED_CONFIG;
+        }
+        // RESHAPE_SETTINGS or INPUT_RES are the upper bounds, rounded up to the alignment
+        if (reshape_settings.empty())
+            reshape_settings = {1, frame_height, frame_width};
+        reshape_settings[1] = (reshape_settings[1] + dynamic_align[0] - 1) / dynamic_align[0] * dynamic_align[0];
+        reshape_settings[2] = (reshape_settings[2] + dynamic_align[1] - 1) / dynamic_align[1] * dynamic_align[1];
+        if (reshape_settings[1] < frame_height || reshape_settings[2] < frame_width) {
+            ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "DYNAMIC_SHAPE requires INPUT_RES within RESHAPE_SETTINGS");
+            return IVSRStatus::UNSUPPORTED_CONFIG;
+        }
+    }
+
     // Parse config for the inference engine
     std::map<std::string, ov::AnyMap> engine_configs;
-    parse_engine_config(engine_configs, device, infer_precision, cldnn_config);
+    parse_engine_config(engine_configs, device, infer_precision, cldnn_config, model_priority);
+
+    // The CPU plugin creates its inference threads from the CPUs the compiling thread may run on,
+    // the whole init runs bound to the node so the weights and infer request tensors are local too.
+    std::unique_ptr<NumaScope> numa_scope;
+    if (numa_node >= 0) {
+        numa_scope.reset(new NumaScope(numa_node));
+        auto cpu_config = engine_configs.find("CPU");
+        if (cpu_config != engine_configs.end()) {
+            size_t cpus = 0;
+            for (auto& node : numa_nodes())
+                cpus = node.id == numa_node ? node.cpus.size() : cpus;
+            cpu_config->second.emplace(ov::inference_num_threads(static_cast<int32_t>(cpus)));
+#if OPENVINO_VERSION_MAJOR >= 2023
+            cpu_config->second.emplace(ov::hint::enable_cpu_pinning(true));
+#endif
+        }
+        std::cout << "[INFO] " << "NUMA node: " << numa_node << std::endl;
+    }
+    std::cout << "[INFO] " << "CPU ISA: " << cpu_isa_name(cpu_isa()) << ", detected "
+              << cpu_isa_name(cpu_isa_detected()) << std::endl;
 
     // Initialize inference engine
-    auto ovEng = new ov_engine(device,
-                               model,
-                               custom_lib,
-                               engine_configs,
-                               reshape_settings,
-                               *input_tensor_desc,
-                               *output_tensor_desc);
-
-    IVSRStatus status = ovEng->init();
-    if (status != IVSRStatus::OK) {
-        ivsr_status_log(status, "in ivsr_init");
+    auto create_engine = [&]() -> ov_engine* {
+        auto engine = new ov_engine(device,
+                                    model,
+                                    custom_lib,
+                                    engine_configs,
+                                    reshape_settings,
+                                    *input_tensor_desc,
+                                    *output_tensor_desc,
+                                    dynamic_align);
+        IVSRStatus status = engine->init();
+        if (status != IVSRStatus::OK) {
+            ivsr_status_log(status, "in ivsr_init");
+            delete engine;
+            return nullptr;
+        }
+        return engine;
+    };
+    auto ovEng = create_engine();
+    if (ovEng == nullptr)
         return IVSRStatus::UNSUPPORTED_SHAPE;
+
+    IVSRStatus status = IVSRStatus::OK;
+    if (max_memory > 0) {
+        // the bounds of a dynamic shape model are not shrunk, frames up to INPUT_RES must still fit
+        std::vector<size_t> no_reshape;
+        status = fit_memory_budget(ovEng,
+                                   create_engine,
+                                   max_memory,
+                                   frame_width,
+                                   frame_height,
+                                   window_frames,
+                                   strip_patches,
+                                   dynamic_align.empty() ? reshape_settings : no_reshape,
+                                   infer_request_num);
+        if (status != IVSRStatus::OK) {
+            delete ovEng;
+            return status;
+        }
     }
 
     auto res = ovEng->create_infer_requests(infer_request_num);
     if (res < 0) {
         std::cout << "[ERROR]: Failed to create infer requests!\n";
+        delete ovEng;
         return IVSRStatus::GENERAL_ERROR;
     }
 
+    // Readiness notification for non-blocking submission, set before a background warmup can release requests
+    int ready_event_fd = create_ready_event_fd();
+    auto ready_notifier = make_ready_notifier(ready_event_fd, ready_cb);
+    ovEng->set_ready_notifier(ready_notifier);
+
+    // Pay kernel JIT, allocation and first-touch costs before the first real frame
+    status = ovEng->warmup(warmup_iterations, warmup_in_background);
+    if (status != IVSRStatus::OK) {
+        ivsr_status_log(status, "in warmup");
+        if (ready_event_fd >= 0)
+            close(ready_event_fd);
+        delete ovEng;
+        return status;
+    }
+
     // Construct IVSRThreadExecutor object
-    IVSRThread::Config executorConfig{"ivsr_thread_executor", 8};
+    IVSRThread::Config executorConfig{"ivsr_thread_executor", 8, numa_node};
     auto executor = new IVSRThread::IVSRThreadExecutor(executorConfig, ovEng);
+    // for the errors below, the engine joins a background warmup before its ready notifier's fd is closed
+    auto release = [&]() {
+        delete executor;
+        delete ovEng;
+        if (ready_event_fd >= 0)
+            close(ready_event_fd);
+    };
 
     // Construct patch config
     tensor_desc_t input_tensor = {
@@ -386,33 +1009,543 @@ IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
         .shape = {0}};
     ovEng->get_attr("model_outputs", output_tensor);
 
-    PatchConfig patchConfig;
-    int m_input_width = input_tensor.shape[ov::layout::width_idx(ov::Layout(input_tensor.layout))];;
-    int m_input_height = input_tensor.shape[ov::layout::height_idx(ov::Layout(input_tensor.layout))];
-    // hard code
-    int nif = input_tensor.dimension == 5 ? input_tensor.shape[1] : 1;
-    int m_output_width = output_tensor.shape[ov::layout::width_idx(ov::Layout(output_tensor.layout))];
-    patchConfig.scale = m_output_width / m_input_width;
-    patchConfig.patchHeight = m_input_height;
-    patchConfig.patchWidth = m_input_width;
-    patchConfig.dims = input_tensor.dimension;
-    patchConfig.nif = nif;
+    PatchConfig patchConfig = build_patch_config(ovEng);
 
 #ifdef ENABLE_LOG
     std::cout << "[Trace]: " << patchConfig << std::endl;
 #endif
 
+    // strips are rows of whole patches, a frame smaller than the patch along one axis can not be split
+    if (strip_patches && (patchConfig.patchHeight < static_cast<int>(frame_height) ||
+                          patchConfig.patchWidth < static_cast<int>(frame_width)) &&
+        (patchConfig.patchHeight > static_cast<int>(frame_height) ||
+         patchConfig.patchWidth > static_cast<int>(frame_width))) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "PATCH_MODE strip requires INPUT_RES of at least the patch size");
+        release();
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    // split and merge read and write the user buffers as f32 planes, other types or a YUV frame would overrun them
+    if (strip_patches && (!strip_tensor_supported(input_tensor) || !strip_tensor_supported(output_tensor) ||
+                          !luma_only_filter.empty())) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG,
+                        "PATCH_MODE strip requires f32 NCHW or NFCHW input and output tensors without LUMA_ONLY");
+        release();
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    // the Y planes are inferred in place, a model of another size would read and write past them or be patched
+    if (!luma_only_filter.empty() && (patchConfig.patchHeight != static_cast<int>(frame_height) ||
+                                      patchConfig.patchWidth != static_cast<int>(frame_width))) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_SHAPE, "LUMA_ONLY requires a model input of INPUT_RES");
+        release();
+        return IVSRStatus::UNSUPPORTED_SHAPE;
+    }
+
+    std::unique_ptr<LumaOnlyConfig> lumaOnly;
+    if (!luma_only_filter.empty()) {
+        lumaOnly = create_luma_only_config(chroma_filter,
+                                           input_tensor,
+                                           output_tensor,
+                                           input_tensor_desc->scale,
+                                           frame_width,
+                                           frame_height,
+                                           patchConfig.scale);
+        if (!lumaOnly) {
+            release();
+            return IVSRStatus::UNSUPPORTED_CONFIG;
+        }
+    }
+
+    std::unique_ptr<FallbackConfig> fallback;
+    if (latency_budget > 0.0) {
+        fallback = create_fallback_config(fallback_filter, latency_budget, input_tensor, output_tensor, *input_tensor_desc);
+        if (!fallback) {
+            release();
+            return IVSRStatus::UNSUPPORTED_CONFIG;
+        }
+        std::cout << "[INFO] " << "Latency budget: " << latency_budget << "ms" << std::endl;
+    }
+
+    std::unique_ptr<FrameWindow> frameWindow;
+    if (window_frames > 0) {
+        IVSRStatus window_status = check_temporal_window(window_frames,
+                                                         input_tensor,
+                                                         patchConfig,
+                                                         frame_width,
+                                                         frame_height,
+                                                         lumaOnly != nullptr);
+        if (window_status != IVSRStatus::OK) {
+            release();
+            return window_status;
+        }
+        // every infer request can hold a window while the next frame is copied in
+        frameWindow.reset(new FrameWindow(ovEng->input_bytes() / window_frames,
+                                          window_frames,
+                                          window_frames + infer_request_num,
+                                          &ovEng->memory()));
+        std::cout << "[INFO] " << "Temporal window: " << window_frames << " frames" << std::endl;
+    }
+
     // Generate input data shape
     std::vector<size_t> input_res;
     input_res.push_back(frame_height);
     input_res.push_back(frame_width);
 
-    // Use the parameterized constructor
-    *handle = new ivsr(ovEng, executor, config_map, patchConfig, std::move(input_res));
+    handle->inferEngine = ovEng;
+    handle->threadExecutor = executor;
+    handle->vsr_config = config_map;
+    handle->patchConfig = patchConfig;
+    handle->stripPatches = strip_patches;
+    handle->input_data_shape = std::move(input_res);
+    handle->lumaOnly = std::move(lumaOnly);
+    handle->fallback = std::move(fallback);
+    handle->frameWindow = std::move(frameWindow);
+    handle->dynamicShape = !dynamic_align.empty();
+    handle->priority = priority;
+    handle->readyEventFd = ready_event_fd;
+    handle->numaNode = numa_node;
+    if (numa_node >= 0)
+        numa_register(numa_node, &ovEng->perf_stats());
+    if (frame_parallel >= 0) {
+        // a full reorder buffer also blocks submissions, so it signals readiness when a slot is freed
+        size_t depth = frame_parallel > 0 ? frame_parallel : 2 * infer_request_num;
+        handle->reorderBuffer.reset(new ReorderBuffer(depth, ready_notifier, &ovEng->perf_stats().reorder));
+        std::cout << "[INFO] " << "Frame parallel: " << depth << " frames in flight" << std::endl;
+    }
+
+    // TRACE_FILE config takes precedence over the environment
+    if (trace_file.empty() && getenv("IVSR_TRACE_FILE"))
+        trace_file = getenv("IVSR_TRACE_FILE");
+    if (!trace_file.empty())
+        handle->tracing = Tracer::acquire(trace_file);
+    return IVSRStatus::OK;
+}
+
+IVSRStatus ivsr_init(ivsr_config_t *configs, ivsr_handle *handle) {
+    if (configs == nullptr || handle == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_init");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    auto created = new ivsr();
+    IVSRStatus status = init_handle(configs, created);
+    if (status != IVSRStatus::OK) {
+        delete created;
+        return status;
+    }
+    *handle = created;
+    return IVSRStatus::OK;
+}
+
+// Configs of a background initialization, the caller may free its list once ivsr_init_async returns.
+struct ConfigCopy {
+    std::vector<char> blob;  // strings and tensor descriptors
+    std::string serviceSocket;
+    bool hasServiceSocket = false;
+    ivsr_cb_t readyCb = {nullptr, nullptr};
+    bool hasReadyCb = false;
+    std::vector<ivsr_config_t> list;
+
+    explicit ConfigCopy(const ivsr_config_t* configs) : blob(service::serialize_config(configs)) {
+        for (auto config = configs; config != nullptr; config = config->next) {
+            if (config->key == IVSRConfigKey::SERVICE_SOCKET && config->value != nullptr) {
+                serviceSocket = static_cast<const char*>(config->value);
+                hasServiceSocket = true;
+            } else if (config->key == IVSRConfigKey::READY_CALLBACK && config->value != nullptr) {
+                readyCb = *static_cast<const ivsr_cb_t*>(config->value);
+                hasReadyCb = true;
+            }
+        }
+        service::deserialize_config(blob, list);
+        if (hasServiceSocket)
+            list.push_back({IVSRConfigKey::SERVICE_SOCKET, serviceSocket.c_str(), nullptr});
+        if (hasReadyCb)
+            list.push_back({IVSRConfigKey::READY_CALLBACK, &readyCb, nullptr});
+        for (size_t i = 0; i + 1 < list.size(); ++i)
+            list[i].next = &list[i + 1];
+    }
+};
+
+IVSRStatus ivsr_init_async(ivsr_config_t *configs, ivsr_handle *handle, ivsr_cb_t *init_cb) {
+    if (configs == nullptr || handle == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_init_async");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    size_t queue_size = 0;
+    for (auto config = configs; config != nullptr; config = config->next) {
+        if (config->key != IVSRConfigKey::INIT_QUEUE_SIZE || config->value == nullptr)
+            continue;
+        try {
+            queue_size = std::stoul(static_cast<const char*>(config->value));
+        } catch (const std::exception& e) {
+            ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for INIT_QUEUE_SIZE=");
+            return IVSRStatus::UNSUPPORTED_CONFIG;
+        }
+    }
+
+    auto copy = std::make_shared<ConfigCopy>(configs);
+    if (copy->list.empty()) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "in ivsr_init_async");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    auto created = new ivsr();
+    created->asyncInit.reset(new AsyncInit(queue_size));
+    ivsr_cb_t done = init_cb ? *init_cb : ivsr_cb_t{nullptr, nullptr};
+    created->asyncInit->start([copy, created]() {
+        return init_handle(copy->list.data(), created);
+    }, [done]() {
+        if (done.ivsr_cb)
+            done.ivsr_cb(done.args);
+    });
+    *handle = created;
+    return IVSRStatus::OK;
+}
+
+// Calls which need the engine wait until an ivsr_init_async handle is initialized.
+static IVSRStatus wait_initialized(ivsr_handle handle) {
+    return handle->asyncInit ? handle->asyncInit->wait() : IVSRStatus::OK;
+}
+
+// A clone shares the compiled model, the patch plan and the luma-only resampler of its source handle.
+// Infer requests with their recurrent state, the temporal window, the reorder buffer, the counters and
+// the notifications are its own, so only the configs of those can be overridden.
+IVSRStatus ivsr_clone(ivsr_handle handle, ivsr_handle* new_handle, ivsr_config_t* overrides) {
+    if (handle == nullptr || new_handle == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_clone");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    IVSRStatus status = wait_initialized(handle);
+    if (status != IVSRStatus::OK)
+        return status;
+    if (handle->service) {
+        // handles of identical configs share the model in the service already
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "ivsr_clone of a SERVICE_SOCKET handle, use ivsr_init");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    size_t infer_request_num = handle->inferEngine->get_infer_requests_size();
+    IVSRPriority priority = handle->priority;
+    ivsr_cb_t ready_cb = {nullptr, nullptr};
+    std::string trace_file;
+    size_t warmup_iterations = 0;
+    int frame_parallel = handle->reorderBuffer ? static_cast<int>(handle->reorderBuffer->depth()) : -1;
+
+    for (auto config = overrides; config != nullptr; config = config->next) {
+        std::string value = config->key == IVSRConfigKey::READY_CALLBACK || config->value == nullptr
+                                ? "" : static_cast<const char*>(config->value);
+        switch (config->key) {
+            case IVSRConfigKey::INFER_REQ_NUMBER:
+                try {
+                    infer_request_num = std::max<size_t>(1, std::stoul(value));
+                } catch (const std::exception& e) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for INFER_REQ_NUMBER=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::PRIORITY:
+                if (!parse_priority(value, priority)) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for PRIORITY=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::READY_CALLBACK:
+                if (config->value != nullptr)
+                    ready_cb = *static_cast<const ivsr_cb_t*>(config->value);
+                break;
+            case IVSRConfigKey::TRACE_FILE:
+                trace_file = value;
+                break;
+            case IVSRConfigKey::WARMUP_ITERATIONS:
+                try {
+                    warmup_iterations = std::stoul(value);
+                } catch (const std::exception& e) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for WARMUP_ITERATIONS=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                break;
+            case IVSRConfigKey::FRAME_PARALLEL:
+                try {
+                    frame_parallel = std::stoi(value);
+                } catch (const std::exception& e) {
+                    frame_parallel = -1;
+                }
+                if (frame_parallel < 0) {
+                    ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for FRAME_PARALLEL=");
+                    return IVSRStatus::UNSUPPORTED_CONFIG;
+                }
+                if (frame_parallel == 0)
+                    frame_parallel = static_cast<int>(2 * infer_request_num);
+                break;
+            default: {
+                // the other configs change the compiled model or the patch plan
+                std::string log = std::to_string(config->key) + " can not be overridden by ivsr_clone";
+                ivsr_status_log(IVSRStatus::UNSUPPORTED_KEY, log.c_str());
+                return IVSRStatus::UNSUPPORTED_KEY;
+            }
+        }
+    }
+
+    auto ovEng = handle->inferEngine->get_impl()->clone();
+    {
+        std::unique_ptr<NumaScope> numa_scope;
+        if (handle->numaNode >= 0)
+            numa_scope.reset(new NumaScope(handle->numaNode));
+        if (ovEng->create_infer_requests(infer_request_num) < 0) {
+            std::cout << "[ERROR]: Failed to create infer requests!\n";
+            delete ovEng;
+            return IVSRStatus::GENERAL_ERROR;
+        }
+    }
+
+    int ready_event_fd = create_ready_event_fd();
+    auto ready_notifier = make_ready_notifier(ready_event_fd, ready_cb);
+    ovEng->set_ready_notifier(ready_notifier);
+
+    status = ovEng->warmup(warmup_iterations, false);
+    if (status != IVSRStatus::OK) {
+        ivsr_status_log(status, "in warmup");
+        if (ready_event_fd >= 0)
+            close(ready_event_fd);
+        delete ovEng;
+        return status;
+    }
+
+    auto cloned = new ivsr();
+    cloned->inferEngine = ovEng;
+    cloned->vsr_config = handle->vsr_config;
+    cloned->patchConfig = handle->patchConfig;
+    cloned->stripPatches = handle->stripPatches;
+    cloned->patchSolution = handle->patchSolution;
+    cloned->input_data_shape = handle->input_data_shape;
+    cloned->lumaOnly = handle->lumaOnly;
+    cloned->fallback = handle->fallback;
+    cloned->dynamicShape = handle->dynamicShape;
+    cloned->priority = priority;
+    cloned->readyEventFd = ready_event_fd;
+    cloned->numaNode = handle->numaNode;
+    if (handle->frameWindow) {
+        int window_frames = handle->frameWindow->frames();
+        cloned->frameWindow.reset(new FrameWindow(ovEng->input_bytes() / window_frames,
+                                                  window_frames,
+                                                  window_frames + infer_request_num,
+                                                  &ovEng->memory()));
+    }
+    if (cloned->numaNode >= 0)
+        numa_register(cloned->numaNode, &ovEng->perf_stats());
+    if (frame_parallel >= 0)
+        cloned->reorderBuffer.reset(new ReorderBuffer(frame_parallel, ready_notifier, &ovEng->perf_stats().reorder));
+
+    // TRACE_FILE config takes precedence over the environment
+    if (trace_file.empty() && getenv("IVSR_TRACE_FILE"))
+        trace_file = getenv("IVSR_TRACE_FILE");
+    if (!trace_file.empty())
+        cloned->tracing = Tracer::acquire(trace_file);
+
+    *new_handle = cloned;
     return IVSRStatus::OK;
 }
 
 IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data, ivsr_cb_t* cb) {
+    return ivsr_process_ex(handle, input_data, output_data, cb, nullptr);
+}
+
+static PerfStats& perf_stats(ivsr_handle handle) {
+    return handle->inferEngine->get_impl()->perf_stats();
+}
+
+static MemoryAccount& memory_account(ivsr_handle handle) {
+    return handle->inferEngine->get_impl()->memory();
+}
+
+// Submissions to an ivsr_init_async handle before it is ready have no engine to count them,
+// held ones are counted once they are started by the initializing thread.
+static IVSRStatus count_result(ivsr_handle handle, IVSRStatus status, bool initialized = false) {
+    if (!initialized && handle->asyncInit && !handle->asyncInit->ready())
+        return status;
+    if (handle->service)
+        return status;  // counted by the service
+    if (status == IVSRStatus::WOULD_BLOCK)
+        perf_stats(handle).dropped.fetch_add(1, std::memory_order_relaxed);
+    else if (status < 0)
+        perf_stats(handle).failed.fetch_add(1, std::memory_order_relaxed);
+    return status;
+}
+
+// Frame size of a DYNAMIC_SHAPE submission: INPUT_RES unless the task option sets it.
+static IVSRStatus set_frame_size(ivsr_handle handle, InferTask& task, const ivsr_task_option_t* option) {
+    if (!handle->dynamicShape)
+        return IVSRStatus::OK;
+
+    size_t height = option && option->height ? option->height : handle->input_data_shape[0];
+    size_t width = option && option->width ? option->width : handle->input_data_shape[1];
+    if (height > static_cast<size_t>(handle->patchConfig.patchHeight) ||
+        width > static_cast<size_t>(handle->patchConfig.patchWidth)) {
+        std::string log = "frame size " + std::to_string(width) + "x" + std::to_string(height) +
+                          " exceeds the bounds of DYNAMIC_SHAPE";
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_SHAPE, log.c_str());
+        return IVSRStatus::UNSUPPORTED_SHAPE;
+    }
+    task.height_ = height;
+    task.width_ = width;
+    return IVSRStatus::OK;
+}
+
+// Clones of short sessions may never call ivsr_process, their executor threads are started on demand.
+static IVSRThread::IVSRThreadExecutor* patch_executor(ivsr_handle handle) {
+    std::call_once(handle->executorOnce, [handle]() {
+        if (handle->threadExecutor == nullptr) {
+            IVSRThread::Config executorConfig{"ivsr_thread_executor", 8, handle->numaNode};
+            handle->threadExecutor = new IVSRThread::IVSRThreadExecutor(executorConfig, handle->inferEngine);
+        }
+    });
+    return handle->threadExecutor;
+}
+
+// Completion of the patches of a PATCH_MODE strip frame, a row is merged once all its patches are inferred.
+struct StripRows {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> pending;  // patches of each row not inferred yet
+    IVSRStatus status = IVSRStatus::OK;
+};
+
+// Strip-wise patches: row n + 1 is split while row n is inferred, and inferred while row n is merged.
+// The staging is a ring of two rows, kept by the handle for the next frames.
+// Frames are f32 planes, init_handle rejects LUMA_ONLY in strip mode.
+static IVSRStatus process_strips(ivsr_handle handle,
+                                 char* input_data,
+                                 char* output_data,
+                                 ivsr_cb_t* cb,
+                                 const ivsr_task_option_t* option,
+                                 Time::time_point submitTime) {
+    std::unique_ptr<StripPatch> strips;
+    {
+        std::lock_guard<std::mutex> lock(handle->stripMutex);
+        if (!handle->stripStaging.empty()) {
+            strips = std::move(handle->stripStaging.back());
+            handle->stripStaging.pop_back();
+        }
+    }
+    if (!strips) {
+        strips.reset(new StripPatch(handle->patchConfig,
+                                    static_cast<int>(handle->input_data_shape[0]),
+                                    static_cast<int>(handle->input_data_shape[1]),
+                                    &memory_account(handle),
+                                    handle->numaNode));
+    }
+
+    const int64_t frame = handle->frameCounter++;
+    const int rows = strips->rows(), columns = strips->columns();
+    // one row is inferred at a time, a request per patch of the row
+    if (static_cast<size_t>(columns) > handle->inferEngine->get_infer_requests_size() &&
+        handle->inferEngine->create_infer_requests(columns) < 0) {
+        std::cout << "[ERROR]: Failed to create infer requests!\n";
+        std::lock_guard<std::mutex> lock(handle->stripMutex);
+        handle->stripStaging.push_back(std::move(strips));
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    auto state = std::make_shared<StripRows>();
+    state->pending.assign(rows, columns);
+    auto submit_row = [&](int row) -> IVSRStatus {
+        for (int column = 0; column < columns; ++column) {
+            auto row_done = [state, row](InferTask::Ptr task) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (task->status_ != IVSRStatus::OK)
+                    state->status = task->status_;
+                if (--state->pending[row] == 0)
+                    state->cv.notify_all();
+            };
+            auto task = std::make_shared<InferTask>(strips->inputPatch(row, column),
+                                                    strips->outputPatch(row, column),
+                                                    row_done,
+                                                    InferFlag::AUTO,
+                                                    nullptr);
+            task->set_option(option, handle->priority);
+            task->frameId_ = frame;
+            task->patchId_ = row * columns + column;
+            IVSRStatus status = handle->inferEngine->proc(task);
+            if (status != IVSRStatus::OK) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->pending[row] -= columns - column;
+                return status;
+            }
+        }
+        return IVSRStatus::OK;
+    };
+    auto wait_row = [&state](int row) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&] {
+            return state->pending[row] == 0;
+        });
+        return state->status;
+    };
+
+    uint64_t split_us = 0, merge_us = 0;
+    auto timed = [](uint64_t& us, const std::function<void()>& work) {
+        auto start = Time::now();
+        work();
+        us += std::chrono::duration_cast<std::chrono::microseconds>(Time::now() - start).count();
+    };
+
+    IVSRStatus status = IVSRStatus::OK;
+    timed(split_us, [&] {
+        TraceScope trace("patch_split", frame);
+        strips->split(0, input_data);
+    });
+    // rows with patches in flight, a failed row only counts the patches it submitted
+    int submitted = 1;
+    status = submit_row(0);
+
+    for (int row = 0; row < rows && status == IVSRStatus::OK; ++row) {
+        if (row + 1 < rows) {
+            timed(split_us, [&] {
+                TraceScope trace("patch_split", frame);
+                strips->split(row + 1, input_data);
+            });
+        }
+        status = wait_row(row);
+        if (status == IVSRStatus::OK && row + 1 < rows) {
+            submitted = row + 2;
+            status = submit_row(row + 1);
+        }
+        if (status != IVSRStatus::OK)
+            break;
+        timed(merge_us, [&] {
+            TraceScope trace("patch_merge", frame);
+            strips->merge(row, output_data);
+        });
+    }
+    // patches still in flight after a failure write to the staging, it is reused once they are done
+    for (int row = 0; row < submitted; ++row)
+        wait_row(row);
+    {
+        std::lock_guard<std::mutex> lock(handle->stripMutex);
+        handle->stripStaging.push_back(std::move(strips));
+    }
+    perf_stats(handle).split.record_us(split_us);
+    perf_stats(handle).merge.record_us(merge_us);
+    if (status != IVSRStatus::OK) {
+        ivsr_status_log(status, "in PATCH_MODE strip");
+        return status;
+    }
+
+    // Notify user
+    perf_stats(handle).frames.fetch_add(1, std::memory_order_relaxed);
+    perf_stats(handle).endToEnd.record(submitTime, Time::now());
+    if (cb && cb->ivsr_cb)
+        cb->ivsr_cb(cb->args);
+    return IVSRStatus::OK;
+}
+
+static IVSRStatus process_patches(ivsr_handle handle,
+                                  char* input_data,
+                                  char* output_data,
+                                  ivsr_cb_t* cb,
+                                  const ivsr_task_option_t* option) {
+    auto submitTime = Time::now();
     if (input_data == nullptr) {
         ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_process - input_data is nullptr");
         return IVSRStatus::GENERAL_ERROR;
@@ -434,13 +1567,25 @@ IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data,
             handle->patchSolution = true;
         }
 
+        if (handle->patchSolution && handle->stripPatches)
+            return process_strips(handle, input_data, output_data, cb, option, submitTime);
+
         // Smart patch inference using a smart pointer for automatic memory management
         std::unique_ptr<SmartPatch> smartPatch(
-            new SmartPatch(handle->patchConfig, input_data, output_data, int_shape, handle->patchSolution)
+            new SmartPatch(handle->patchConfig, input_data, output_data, int_shape, handle->patchSolution,
+                           &memory_account(handle), handle->numaNode)
         );
 
+        const int64_t frame = handle->frameCounter++;
+
         // Prepare data
-        int res = smartPatch->generatePatch();
+        int res;
+        {
+            TraceScope trace("patch_split", frame);
+            auto splitStart = Time::now();
+            res = smartPatch->generatePatch();
+            perf_stats(handle).split.record(splitStart, Time::now());
+        }
         if (res == -1) {
             ivsr_status_log(IVSRStatus::UNKNOWN_ERROR, "in SmartPatch::generatePatch");
             return IVSRStatus::UNKNOWN_ERROR;
@@ -464,17 +1609,35 @@ IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data,
         }
 
         // Get data into infer task
+        auto executor = patch_executor(handle);
         for (auto idx = 0u; idx < patchList.size(); ++idx) {
 #ifdef ENABLE_LOG
             std::cout << "[Trace]: ivsr_process on patch: " << idx << std::endl;
 #endif
-            std::shared_ptr<InferTask> task = handle->threadExecutor->CreateTask(
+            std::shared_ptr<InferTask> task = executor->CreateTask(
                 patchList[idx], outputPatchList[idx], InferFlag::AUTO);
-            handle->threadExecutor->Enqueue(task);
+            task->set_option(option, handle->priority);
+            task->frameId_ = frame;
+            task->patchId_ = static_cast<int32_t>(idx);
+            IVSRStatus status = set_frame_size(handle, *task, option);
+            if (status != IVSRStatus::OK) {
+                // the patches already enqueued still write to the buffers of the frame
+                executor->wait_all(idx);
+                return status;
+            }
+            executor->Enqueue(task);
         }
 
-        // Wait for all tasks to finish
-        handle->threadExecutor->wait_all(required_infer_requests);
+        // U/V planes are resampled on the calling thread while the Y plane is being inferred
+        if (handle->lumaOnly)
+            upscale_chroma_planes(*handle->lumaOnly, input_data, output_data, frame);
+
+        // Wait for all tasks to finish, a frame with a failed patch is not merged
+        IVSRStatus status = executor->wait_all(required_infer_requests);
+        if (status != IVSRStatus::OK) {
+            ivsr_status_log(status, "in patch inference");
+            return status;
+        }
 
 #ifdef ENABLE_PERF
         double duration = get_duration_ms_till_now(totalStartTime);
@@ -485,14 +1648,22 @@ IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data,
 #endif
 
         // Restore output patches to images
-        res = smartPatch->restoreImageFromPatches();
+        {
+            TraceScope trace("patch_merge", frame);
+            auto mergeStart = Time::now();
+            res = smartPatch->restoreImageFromPatches();
+            perf_stats(handle).merge.record(mergeStart, Time::now());
+        }
         if (res == -1) {
             ivsr_status_log(IVSRStatus::UNKNOWN_ERROR, "in SmartPatch::restoreImageFromPatches");
             return IVSRStatus::UNKNOWN_ERROR;
         }
 
         // Notify user
-        cb->ivsr_cb(cb->args);
+        perf_stats(handle).frames.fetch_add(1, std::memory_order_relaxed);
+        perf_stats(handle).endToEnd.record(submitTime, Time::now());
+        if (cb && cb->ivsr_cb)
+            cb->ivsr_cb(cb->args);
 
     } catch (const std::exception& e) {
         std::cout << "Error in ivsr_process: " << e.what() << std::endl;
@@ -503,10 +1674,210 @@ IVSRStatus ivsr_process(ivsr_handle handle, char* input_data, char* output_data,
     return IVSRStatus::OK;
 }
 
-IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output_data, ivsr_cb_t* cb) {
-    if (input_data == nullptr) {
-        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_process - input_data is nullptr");
-        return IVSRStatus::GENERAL_ERROR;
+// Temporal window: the frame is copied into the window once, the window is inferred in place.
+static IVSRStatus process_window_async(ivsr_handle handle,
+                                       char* input_data,
+                                       char* output_data,
+                                       ivsr_cb_t* cb,
+                                       const ivsr_task_option_t* option,
+                                       bool blocking,
+                                       InferTask::QueueCallbackFunction done) {
+    auto submitTime = Time::now();
+    FrameWindow* window = handle->frameWindow.get();
+    const int64_t frame = handle->frameCounter++;
+    {
+        TraceScope trace("window_copy", frame);
+        if (!window->push(input_data, blocking))
+            return IVSRStatus::WOULD_BLOCK;
+    }
+
+    uint64_t first = 0;
+    char* window_data = window->acquire(first);
+    auto task = std::make_shared<InferTask>(window_data, output_data, nullptr, InferFlag::AUTO, cb);
+    task->set_option(option, handle->priority);
+    task->submitTime_ = submitTime;
+    task->frameId_ = frame;
+    task->endsFrame_ = true;
+    // the window is free for new frames before the user is notified
+    task->_callbackFunction = [window, first, done](InferTask::Ptr finished) {
+        window->release(first);
+        if (done)
+            done(finished);
+        else if (finished->cb && finished->cb->ivsr_cb)
+            finished->cb->ivsr_cb(finished->cb->args);
+    };
+
+    IVSRStatus status = blocking ? handle->inferEngine->proc(task) : handle->inferEngine->try_proc(task);
+    if (status != IVSRStatus::OK)
+        window->cancel(first);
+    return status;
+}
+
+IVSRStatus ivsr_process_ex(ivsr_handle handle,
+                           char* input_data,
+                           char* output_data,
+                           ivsr_cb_t* cb,
+                           const ivsr_task_option_t* option) {
+    IVSRStatus init_status = wait_initialized(handle);
+    if (init_status != IVSRStatus::OK)
+        return init_status;
+    if (handle->service) {
+        std::promise<IVSRStatus> finished;
+        auto result = finished.get_future();
+        IVSRStatus status = handle->service->submit(input_data, output_data, option, true,
+                                                    [&finished, cb](IVSRStatus done, double, double) {
+            if (done == IVSRStatus::OK && cb && cb->ivsr_cb)
+                cb->ivsr_cb(cb->args);
+            finished.set_value(done);
+        });
+        return status == IVSRStatus::OK ? result.get() : status;
+    }
+    if (handle->frameWindow && input_data != nullptr) {
+        std::promise<IVSRStatus> finished;
+        auto done = [&finished, cb](InferTask::Ptr task) {
+            if (cb && cb->ivsr_cb)
+                cb->ivsr_cb(cb->args);
+            finished.set_value(task->status_);
+        };
+        auto result = finished.get_future();
+        IVSRStatus status = count_result(handle, process_window_async(handle, input_data, output_data, nullptr,
+                                                                      option, true, done));
+        // a failed inference is counted by the engine
+        return status == IVSRStatus::OK ? result.get() : status;
+    }
+    return count_result(handle, process_patches(handle, input_data, output_data, cb, option));
+}
+
+static bool over_latency_budget(ivsr_handle handle) {
+    return handle->fallback && handle->inferEngine->get_impl()->predict_latency_ms() > handle->fallback->budgetMs;
+}
+
+// Upscale a frame over the latency budget on the submitting thread and complete it like an inference.
+// The model misses the frame, so a recurrent model restarts its hidden state at the next inferred one.
+static void run_fallback(ivsr_handle handle, InferTask::Ptr task) {
+    const FallbackConfig& cfg = *handle->fallback;
+    task->_startTime = Time::now();
+    {
+        TraceScope trace("fallback_resample", task->frameId_);
+        for (size_t plane = 0; plane < cfg.planes; ++plane) {
+            cfg.resampler->resample(task->inputPtr_ + plane * cfg.inPlaneBytes,
+                                    cfg.inType,
+                                    task->outputPtr_ + plane * cfg.outPlaneBytes,
+                                    cfg.outType,
+                                    cfg.maxValue,
+                                    cfg.outScale);
+        }
+    }
+    task->_endTime = Time::now();
+    task->status_ = IVSRStatus::OK;
+    handle->inferEngine->get_impl()->reset_states();
+    perf_stats(handle).fallback.fetch_add(1, std::memory_order_relaxed);
+
+    if (task->_callbackFunction) {
+        task->_callbackFunction(task);
+    } else if (task->cb && task->cb->ivsr_cb) {
+        task->cb->ivsr_cb(task->cb->args);
+    }
+    if (task->endsFrame_) {
+        perf_stats(handle).frames.fetch_add(1, std::memory_order_relaxed);
+        perf_stats(handle).endToEnd.record(task->submitTime_, Time::now());
+    }
+}
+
+// The user callback of a luma-only frame fires once both the inference and the chroma resampling are done.
+struct LumaOnlyJob {
+    std::atomic<int> pending{2};
+    ivsr_cb_t userCb = {nullptr, nullptr};
+    ivsr_cb_t innerCb = {nullptr, nullptr};
+    InferTask::Ptr task;
+    InferTask::QueueCallbackFunction done;  // completion queue of ivsr_submit
+    PerfStats* stats = nullptr;
+};
+
+static void luma_only_job_done(void* args) {
+    auto job = static_cast<LumaOnlyJob*>(args);
+    if (job->pending.fetch_sub(1) != 1)
+        return;
+    if (job->userCb.ivsr_cb)
+        job->userCb.ivsr_cb(job->userCb.args);
+    if (job->done)
+        job->done(job->task);
+    job->stats->frames.fetch_add(1, std::memory_order_relaxed);
+    job->stats->endToEnd.record(job->task->submitTime_, Time::now());
+    delete job;
+}
+
+static IVSRStatus process_luma_only_async(ivsr_handle handle,
+                                          char* input_data,
+                                          char* output_data,
+                                          ivsr_cb_t* cb,
+                                          const ivsr_task_option_t* option,
+                                          bool blocking,
+                                          InferTask::QueueCallbackFunction done) {
+    auto job = new LumaOnlyJob();
+    if (cb)
+        job->userCb = *cb;
+    job->innerCb.ivsr_cb = luma_only_job_done;
+    job->innerCb.args = job;
+
+    auto task = std::make_shared<InferTask>(input_data, output_data, nullptr, InferFlag::AUTO, &job->innerCb);
+    task->set_option(option, handle->priority);
+    task->frameId_ = handle->frameCounter++;
+    job->task = task;
+    job->done = std::move(done);
+    job->stats = &perf_stats(handle);
+    if (over_latency_budget(handle)) {
+        run_fallback(handle, task);
+    } else {
+        IVSRStatus status = blocking ? handle->inferEngine->proc(task) : handle->inferEngine->try_proc(task);
+        if (status != IVSRStatus::OK) {
+            delete job;
+            return status;
+        }
+    }
+
+    upscale_chroma_planes(*handle->lumaOnly, input_data, output_data, task->frameId_);
+    luma_only_job_done(job);
+    return IVSRStatus::OK;
+}
+
+// requests a patched frame holds at the same time: every patch, or the patches of a row in strip mode
+static size_t patch_requests(ivsr_handle handle) {
+    const size_t height = handle->input_data_shape[handle->input_data_shape.size() - 2];
+    const size_t width = handle->input_data_shape[handle->input_data_shape.size() - 1];
+    const size_t rows = (height + handle->patchConfig.patchHeight - 1) / handle->patchConfig.patchHeight;
+    const size_t columns = (width + handle->patchConfig.patchWidth - 1) / handle->patchConfig.patchWidth;
+    return handle->stripPatches ? columns : rows * columns;
+}
+
+static IVSRStatus submit_frame(ivsr_handle handle,
+                               char* input_data,
+                               char* output_data,
+                               ivsr_cb_t* cb,
+                               const ivsr_task_option_t* option,
+                               bool blocking,
+                               InferTask::QueueCallbackFunction done) {
+    if (handle->service) {
+        ivsr_cb_t user_cb = cb ? *cb : ivsr_cb_t{nullptr, nullptr};
+        auto submitTime = Time::now();
+        return handle->service->submit(input_data, output_data, option, blocking,
+                                       [user_cb, submitTime, done, input_data, output_data](IVSRStatus status,
+                                                                                            double queue_ms,
+                                                                                            double infer_ms) {
+            if (user_cb.ivsr_cb)
+                user_cb.ivsr_cb(user_cb.args);
+            if (!done)
+                return;
+            // times measured by the service, the total is measured here and includes the transport
+            auto record = std::make_shared<InferTask>(input_data, output_data, nullptr, InferFlag::AUTO, nullptr);
+            record->status_ = status;
+            record->submitTime_ = submitTime;
+            record->_startTime = submitTime + std::chrono::duration_cast<Time::duration>(
+                                                  std::chrono::duration<double, std::milli>(queue_ms));
+            record->_endTime = record->_startTime + std::chrono::duration_cast<Time::duration>(
+                                                        std::chrono::duration<double, std::milli>(infer_ms));
+            done(record);
+        });
     }
 
     try {
@@ -525,9 +1896,21 @@ IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output
             handle->patchSolution = true;
         }
 
-        // TODO: Now fallback to ivsr_process api when patch solution is needed
+        // patched frames are processed on the calling thread, a try-submit only starts one whose patches
+        // all get a request without waiting
         if (handle->patchSolution) {
-            return ivsr_process(handle, input_data, output_data, cb);
+            const size_t requests = patch_requests(handle);
+            if (!blocking && handle->inferEngine->get_impl()->available_requests(requests) < requests)
+                return IVSRStatus::WOULD_BLOCK;
+            auto submitTime = Time::now();
+            IVSRStatus status = process_patches(handle, input_data, output_data, cb, option);
+            if (status == IVSRStatus::OK && done) {
+                auto record = std::make_shared<InferTask>(input_data, output_data, nullptr, InferFlag::AUTO, nullptr);
+                record->submitTime_ = record->_startTime = submitTime;
+                record->_endTime = Time::now();
+                done(record);
+            }
+            return status;
         }
 
         /* Uncomment: to use thread loop and internal task to process */
@@ -535,7 +1918,28 @@ IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output
         //   handle->threadExecutor->CreateTask(input_data, output_data, InferFlag::AUTO, cb);
         // handle->threadExecutor->Enqueue(task);
 
-        handle->inferEngine->proc(input_data, output_data, cb);
+        if (handle->lumaOnly)
+            return process_luma_only_async(handle, input_data, output_data, cb, option, blocking, std::move(done));
+
+        if (handle->frameWindow)
+            return process_window_async(handle, input_data, output_data, cb, option, blocking, std::move(done));
+
+        auto task = std::make_shared<InferTask>(input_data, output_data, std::move(done), InferFlag::AUTO, cb);
+        task->set_option(option, handle->priority);
+        task->frameId_ = handle->frameCounter++;
+        task->endsFrame_ = true;
+        IVSRStatus status = set_frame_size(handle, *task, option);
+        if (status != IVSRStatus::OK)
+            return status;
+        if (over_latency_budget(handle)) {
+            run_fallback(handle, task);
+            return IVSRStatus::OK;
+        }
+        if (!blocking)
+            return handle->inferEngine->try_proc(task);
+        status = handle->inferEngine->proc(task);
+        if (status != IVSRStatus::OK)
+            return status;
 
     } catch (const std::exception& e) {
         std::cout << "Error in ivsr_process: " << e.what() << std::endl;
@@ -546,11 +1950,186 @@ IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output
     return IVSRStatus::OK;
 }
 
+// Frame parallel: frames finish out of order on the infer requests, the user callback or completion
+// event of each frame is held in the reorder buffer until the frames submitted before it are delivered.
+static IVSRStatus submit_in_order(ivsr_handle handle,
+                                  char* input_data,
+                                  char* output_data,
+                                  ivsr_cb_t* cb,
+                                  const ivsr_task_option_t* option,
+                                  bool blocking,
+                                  InferTask::QueueCallbackFunction done) {
+    ReorderBuffer* reorder = handle->reorderBuffer.get();
+    if (reorder == nullptr)
+        return submit_frame(handle, input_data, output_data, cb, option, blocking, std::move(done));
+
+    uint64_t seq = 0;
+    if (!reorder->reserve(blocking, seq))
+        return IVSRStatus::WOULD_BLOCK;
+
+    // every path calls the queue callback exactly when the submission succeeded, the user callback is
+    // called from it so both are delivered in order
+    ivsr_cb_t user_cb = cb ? *cb : ivsr_cb_t{nullptr, nullptr};
+    auto in_order = [reorder, seq, user_cb, done](InferTask::Ptr task) {
+        reorder->complete(seq, [user_cb, done, task]() {
+            if (user_cb.ivsr_cb)
+                user_cb.ivsr_cb(user_cb.args);
+            if (done)
+                done(task);
+        });
+    };
+    IVSRStatus status = submit_frame(handle, input_data, output_data, nullptr, option, blocking, in_order);
+    if (status != IVSRStatus::OK)
+        reorder->cancel(seq);
+    return status;
+}
+
+// A submission held by an ivsr_init_async handle already returned OK, if it can not be started
+// its callback and completion event still come, with the error.
+static void fail_held(char* input_data, char* output_data, ivsr_cb_t* cb, IVSRStatus status, InferTask::QueueCallbackFunction done) {
+    if (done) {
+        auto record = std::make_shared<InferTask>(input_data, output_data, nullptr, InferFlag::AUTO, nullptr);
+        record->status_ = status;
+        record->submitTime_ = record->_startTime = record->_endTime = Time::now();
+        done(record);
+    }
+    if (cb && cb->ivsr_cb)
+        cb->ivsr_cb(cb->args);
+}
+
+static IVSRStatus submit_async(ivsr_handle handle,
+                               char* input_data,
+                               char* output_data,
+                               ivsr_cb_t* cb,
+                               const ivsr_task_option_t* option,
+                               bool blocking,
+                               InferTask::QueueCallbackFunction done = nullptr) {
+    if (input_data == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_process - input_data is nullptr");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    if (handle->asyncInit && !handle->asyncInit->ready()) {
+        // the task option is copied, the callback must stay valid until it is called as for any submission
+        bool has_option = option != nullptr;
+        ivsr_task_option_t held_option = has_option ? *option : ivsr_task_option_t{};
+        auto start = [handle, input_data, output_data, cb, has_option, held_option, done](IVSRStatus init_status) {
+            IVSRStatus status = init_status;
+            if (status == IVSRStatus::OK)
+                status = count_result(handle, submit_in_order(handle, input_data, output_data, cb,
+                                                              has_option ? &held_option : nullptr, true, done), true);
+            if (status != IVSRStatus::OK)
+                fail_held(input_data, output_data, cb, status, done);
+        };
+        IVSRStatus status = IVSRStatus::OK;
+        if (handle->asyncInit->hold(blocking, start, status))
+            return status;
+    }
+    return submit_in_order(handle, input_data, output_data, cb, option, blocking, std::move(done));
+}
+
+IVSRStatus ivsr_process_async(ivsr_handle handle, char* input_data, char* output_data, ivsr_cb_t* cb) {
+    return ivsr_process_async_ex(handle, input_data, output_data, cb, nullptr);
+}
+
+IVSRStatus ivsr_process_async_ex(ivsr_handle handle,
+                                 char* input_data,
+                                 char* output_data,
+                                 ivsr_cb_t* cb,
+                                 const ivsr_task_option_t* option) {
+    return count_result(handle, submit_async(handle, input_data, output_data, cb, option, true));
+}
+
+IVSRStatus ivsr_try_process_async(ivsr_handle handle,
+                                  char* input_data,
+                                  char* output_data,
+                                  ivsr_cb_t* cb,
+                                  const ivsr_task_option_t* option) {
+    return count_result(handle, submit_async(handle, input_data, output_data, cb, option, false));
+}
+
+IVSRStatus ivsr_submit(ivsr_handle handle,
+                       char* input_data,
+                       char* output_data,
+                       const ivsr_task_option_t* option,
+                       ivsr_token_t* token) {
+    if (handle == nullptr || token == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_submit");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    auto to_ms = [](Time::time_point start, Time::time_point end) -> double {
+        return std::chrono::duration_cast<ns>(end - start).count() * 0.000001;
+    };
+
+    ivsr_token_t submitted = handle->completionQueue.add_pending();
+    auto done = [handle, submitted, to_ms](InferTask::Ptr task) {
+        ivsr_event_t event;
+        event.token = submitted;
+        event.status = task->status_;
+        event.queue_time = to_ms(task->submitTime_, task->_startTime);
+        event.infer_time = to_ms(task->_startTime, task->_endTime);
+        event.total_time = to_ms(task->submitTime_, Time::now());
+        handle->completionQueue.complete(event);
+    };
+
+    IVSRStatus status = count_result(handle, submit_async(handle, input_data, output_data, nullptr, option, true, done));
+    if (status != IVSRStatus::OK) {
+        handle->completionQueue.cancel(submitted);
+        return status;
+    }
+
+    *token = submitted;
+    return IVSRStatus::OK;
+}
+
+IVSRStatus ivsr_poll(ivsr_handle handle, ivsr_event_t* events, size_t max_events, int timeout_ms, size_t* num_events) {
+    if (handle == nullptr || events == nullptr || num_events == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_poll");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    *num_events = handle->completionQueue.poll(events, max_events, timeout_ms);
+    return *num_events > 0 ? IVSRStatus::OK : IVSRStatus::TIMEOUT;
+}
+
+IVSRStatus ivsr_wait(ivsr_handle handle, ivsr_token_t token, int timeout_ms, ivsr_event_t* event) {
+    if (handle == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_wait");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    return handle->completionQueue.wait(token, timeout_ms, event);
+}
+
+IVSRStatus ivsr_push_frame(ivsr_handle handle, const char* frame) {
+    if (handle == nullptr || frame == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_push_frame");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    IVSRStatus init_status = wait_initialized(handle);
+    if (init_status != IVSRStatus::OK)
+        return init_status;
+    if (handle->service)
+        return handle->service->push_frame(frame);
+    if (!handle->frameWindow) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "ivsr_push_frame requires TEMPORAL_WINDOW");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+
+    TraceScope trace("window_copy", handle->frameCounter++);
+    handle->frameWindow->push(frame, true);
+    return IVSRStatus::OK;
+}
+
 IVSRStatus ivsr_reconfig(ivsr_handle handle, ivsr_config_t* configs){
     if(configs == nullptr){
         ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_reconfig");
         return IVSRStatus::GENERAL_ERROR;
     }
+    IVSRStatus init_status = wait_initialized(handle);
+    if (init_status != IVSRStatus::OK)
+        return init_status;
 
     try{
         // reset config in container
@@ -591,7 +2170,47 @@ IVSRStatus ivsr_reconfig(ivsr_handle handle, ivsr_config_t* configs){
     return IVSRStatus::OK;
 }
 
+// Buffer sizes of a submission at INPUT_RES, in the layout each mode reads and writes.
+static void frame_buffer_bytes(ivsr_handle handle, size_t& input_bytes, size_t& output_bytes) {
+    ov_engine* engine = handle->inferEngine->get_impl();
+    const PatchConfig& patch = handle->patchConfig;
+    size_t height = handle->input_data_shape[0], width = handle->input_data_shape[1];
+    if (handle->lumaOnly) {
+        input_bytes = handle->lumaOnly->inLumaBytes + 2 * handle->lumaOnly->inChromaBytes;
+        output_bytes = handle->lumaOnly->outLumaBytes + 2 * handle->lumaOnly->outChromaBytes;
+    } else if (handle->frameWindow) {
+        input_bytes = handle->frameWindow->frame_bytes();
+        output_bytes = engine->output_bytes();
+    } else if (height > static_cast<size_t>(patch.patchHeight) || width > static_cast<size_t>(patch.patchWidth)) {
+        // frames split into patches are float
+        input_bytes = sizeof(float) * patch.nif * patch.channels * height * width;
+        output_bytes = input_bytes * patch.scale * patch.scale;
+    } else if (handle->dynamicShape) {
+        // tensors are tightly packed at the frame size, the engine sizes are at the upper bounds
+        size_t bound = static_cast<size_t>(patch.patchHeight) * patch.patchWidth;
+        input_bytes = engine->input_bytes() / bound * height * width;
+        output_bytes = engine->output_bytes() / bound * height * width;
+    } else {
+        input_bytes = engine->input_bytes();
+        output_bytes = engine->output_bytes();
+    }
+}
+
 IVSRStatus ivsr_get_attr(ivsr_handle handle, IVSRAttrKey key, void* value){
+    if (key == IVSRAttrKey::INIT_STATUS) {
+        *((IVSRStatus *)value) = handle->asyncInit ? handle->asyncInit->status() : IVSRStatus::OK;
+        return IVSRStatus::OK;
+    }
+    if (key == IVSRAttrKey::CPU_ISA) {
+        *((const char **)value) = cpu_isa_name(cpu_isa());
+        return IVSRStatus::OK;
+    }
+    if (handle->asyncInit && !handle->asyncInit->ready())
+        return handle->asyncInit->status();
+
+    if (handle->service && key != IVSRAttrKey::IVSR_VERSION && key != IVSRAttrKey::READY_EVENT_FD)
+        return handle->service->get_attr(key, value);
+
     switch (key)
     {
         case IVSRAttrKey::IVSR_VERSION:
@@ -612,7 +2231,7 @@ IVSRStatus ivsr_get_attr(ivsr_handle handle, IVSRAttrKey key, void* value){
         case IVSRAttrKey::NUM_INPUT_FRAMES:
         {
             int* nif = (int*) value;
-            *nif = handle->patchConfig.nif;
+            *nif = handle->frameWindow ? handle->frameWindow->frames() : handle->patchConfig.nif;
             break;
         }
         case IVSRAttrKey::INPUT_DIMS:
@@ -629,6 +2248,52 @@ IVSRStatus ivsr_get_attr(ivsr_handle handle, IVSRAttrKey key, void* value){
             *((size_t *)value) = dims;
             break;
         }
+        case IVSRAttrKey::WARMUP_DURATION:
+        {
+            double duration = 0.0;
+            IVSRStatus warmup_status = handle->inferEngine->get_attr("warmup_duration", duration);
+            *((double *)value) = duration;
+            if (warmup_status != IVSRStatus::OK) {
+                ivsr_status_log(warmup_status, "in warmup");
+                return warmup_status;
+            }
+            break;
+        }
+        case IVSRAttrKey::DEADLINE_MISSED_NUM:
+        {
+            size_t missed = 0;
+            handle->inferEngine->get_attr("deadline_missed", missed);
+            *((size_t *)value) = missed;
+            break;
+        }
+        case IVSRAttrKey::PERF_STATS:
+        {
+            handle->inferEngine->get_attr("perf_stats", *(static_cast<ivsr_perf_stats_t *>(value)));
+            break;
+        }
+        case IVSRAttrKey::MEMORY_USAGE:
+        {
+            handle->inferEngine->get_attr("memory_usage", *(static_cast<ivsr_memory_usage_t *>(value)));
+            break;
+        }
+        case IVSRAttrKey::NUMA_STATS:
+        {
+            numa_snapshot(handle->numaNode, *(static_cast<ivsr_numa_stats_t *>(value)));
+            break;
+        }
+        case IVSRAttrKey::READY_EVENT_FD:
+        {
+            *((int *)value) = handle->readyEventFd;
+            break;
+        }
+        case IVSRAttrKey::INPUT_FRAME_BYTES:
+        case IVSRAttrKey::OUTPUT_FRAME_BYTES:
+        {
+            size_t input_bytes = 0, output_bytes = 0;
+            frame_buffer_bytes(handle, input_bytes, output_bytes);
+            *((size_t *)value) = key == IVSRAttrKey::INPUT_FRAME_BYTES ? input_bytes : output_bytes;
+            break;
+        }
         default:
         {
             ivsr_status_log(IVSRStatus::UNSUPPORTED_KEY,(char*)key);
@@ -638,13 +2303,87 @@ IVSRStatus ivsr_get_attr(ivsr_handle handle, IVSRAttrKey key, void* value){
     return IVSRStatus::OK;
 }
 
+void* ivsr_buffer_alloc(ivsr_handle handle, size_t size) {
+    if (handle == nullptr || size == 0) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_buffer_alloc");
+        return nullptr;
+    }
+    if (wait_initialized(handle) != IVSRStatus::OK)
+        return nullptr;
+    if (handle->service)
+        return handle->service->alloc(size);
+
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, 4096, size) != 0) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_buffer_alloc");
+        return nullptr;
+    }
+    numa_prefer_memory(buffer, size, handle->numaNode);
+    std::lock_guard<std::mutex> lock(handle->bufferMutex);
+    handle->buffers.insert(buffer);
+    return buffer;
+}
+
+IVSRStatus ivsr_buffer_free(ivsr_handle handle, void* buffer) {
+    if (handle == nullptr || buffer == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_buffer_free");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    IVSRStatus init_status = wait_initialized(handle);
+    if (init_status != IVSRStatus::OK)
+        return init_status;
+    if (handle->service)
+        return handle->service->free(buffer);
+
+    {
+        std::lock_guard<std::mutex> lock(handle->bufferMutex);
+        if (handle->buffers.erase(buffer) == 0) {
+            ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_buffer_free - not a buffer of the handle");
+            return IVSRStatus::GENERAL_ERROR;
+        }
+    }
+    free(buffer);
+    return IVSRStatus::OK;
+}
+
 IVSRStatus ivsr_deinit(ivsr_handle handle) {
     if (handle == nullptr) {
         ivsr_status_log(IVSRStatus::GENERAL_ERROR, "Invalid handle");
         return IVSRStatus::GENERAL_ERROR;
     }
 
+    // a background initialization runs to its end, a failed one leaves nothing to release
+    if (handle->asyncInit) {
+        IVSRStatus init_status = handle->asyncInit->wait();
+        handle->asyncInit.reset();
+        if (init_status != IVSRStatus::OK) {
+            delete handle;
+            return IVSRStatus::OK;
+        }
+    }
+
+    if (handle->service) {
+        IVSRStatus status = handle->service->close();
+        if (handle->readyEventFd >= 0)
+            close(handle->readyEventFd);
+        delete handle;
+        return status;
+    }
+
     try {
+        // frames still in flight are counted to the node before the stats go away with the engine
+        if (handle->numaNode >= 0) {
+            handle->inferEngine->wait_all();
+            numa_unregister(handle->numaNode, &perf_stats(handle));
+        }
+
+        // windows being inferred are released by the engine callbacks, the window is charged to the engine
+        if (handle->frameWindow) {
+            handle->inferEngine->wait_all();
+            handle->frameWindow.reset();
+        }
+        handle->stripStaging.clear();
+
         auto p = handle->inferEngine->get_impl();
         if (p != nullptr)
             delete p;
@@ -653,6 +2392,20 @@ IVSRStatus ivsr_deinit(ivsr_handle handle) {
             delete handle->threadExecutor;
             handle->threadExecutor = nullptr;
         }
+
+        if (handle->readyEventFd >= 0) {
+            close(handle->readyEventFd);
+            handle->readyEventFd = -1;
+        }
+
+        if (handle->tracing) {
+            Tracer::release();
+            handle->tracing = false;
+        }
+
+        for (void* buffer : handle->buffers)
+            free(buffer);
+        handle->buffers.clear();
     } catch (const std::exception& e) {
         ivsr_status_log(IVSRStatus::EXCEPTION_ERROR, e.what());
         return IVSRStatus::UNKNOWN_ERROR;
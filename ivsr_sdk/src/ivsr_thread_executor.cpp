@@ -14,6 +14,8 @@
 
 #include "threading/ivsr_thread_executor.hpp"
 #include "ov_engine.hpp"
+#include "ivsr_tracer.hpp"
+#include "ivsr_numa.hpp"
 
 #include <atomic>
 #include <cassert>
@@ -63,6 +65,9 @@ struct IVSRThreadExecutor::Impl {
           _engine(engine) {
         for (auto streamId = 0; streamId < _config._threads; ++streamId) {
             _threads.emplace_back([this, streamId] {
+                // patch buffers are first touched by these threads, keep them next to the handle's memory
+                if (_config._numaNode >= 0)
+                    numa_bind_thread(_config._numaNode);
                 for (bool stopped = false; !stopped;) {
                     Task task;
                     {
@@ -71,7 +76,7 @@ struct IVSRThreadExecutor::Impl {
                             return !_taskQueue.empty() || (stopped = _isStopped);
                         });
                         if (!_taskQueue.empty()) {
-                            task = _taskQueue.front();
+                            task = _taskQueue.top();
                             _taskQueue.pop();
                         }
                     }
@@ -88,6 +93,7 @@ struct IVSRThreadExecutor::Impl {
     }
 
     void Enqueue(Task task) {
+        TraceScope trace("enqueue", task->frameId_, task->patchId_);
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _taskQueue.emplace(task);
@@ -101,7 +107,12 @@ struct IVSRThreadExecutor::Impl {
     }
 
     void Execute(const Task& task, Stream& stream) {
-        _engine->run(task);
+        // a task which is not started never calls back, complete it here so wait_all() does not wait for it
+        IVSRStatus status = _engine->run(task);
+        if (status != IVSRStatus::OK) {
+            task->status_ = status;
+            competition_call_back(task);
+        }
     }
 
     Task CreateTask(char* inBuf, char* outBuf, InferFlag flag, ivsr_cb_t* cb) {
@@ -130,21 +141,25 @@ struct IVSRThreadExecutor::Impl {
         }
     }
 
-    void sync(int size) {
+    IVSRStatus sync(int size) {
         std::unique_lock<std::mutex> lock(_mutex);
         _taskCondVar.wait(lock, [&] {
             return (_cb_counter == size);
         });
+        return _status;
     }
 
     void reset() {
         std::unique_lock<std::mutex> lock(_mutex);
         _cb_counter = 0;
+        _status = IVSRStatus::OK;
     }
 
     void competition_call_back(Task task) {
         std::unique_lock<std::mutex> lock(_mutex);
         _cb_counter++;
+        if (task->status_ != IVSRStatus::OK && _status == IVSRStatus::OK)
+            _status = task->status_;
         _endTime = std::max(Time::now(), _endTime);
         if (task->cb) {
             task->cb->ivsr_cb(task->cb->args);
@@ -156,6 +171,13 @@ struct IVSRThreadExecutor::Impl {
         return std::chrono::duration_cast<ns>(_endTime - _startTime).count() * 0.000001;
     }
 
+    // std::priority_queue pops the largest element, so the task scheduled first must compare greatest
+    struct TaskOrder {
+        bool operator()(const Task& a, const Task& b) const {
+            return b->scheduled_before(*a);
+        }
+    };
+
     Config _config;
     std::mutex _streamIdMutex;
     int _streamId = 0;
@@ -165,7 +187,8 @@ struct IVSRThreadExecutor::Impl {
     std::condition_variable _queueCondVar;
     std::condition_variable _taskCondVar;
     int _cb_counter = 0;
-    std::queue<Task> _taskQueue;
+    IVSRStatus _status = IVSRStatus::OK;  // first failure of the tasks counted by _cb_counter
+    std::priority_queue<Task, std::vector<Task>, TaskOrder> _taskQueue;
     bool _isStopped = false;
     ThreadLocal<std::shared_ptr<Stream>> _streams;
     engine<ov_engine>* _engine;
@@ -206,9 +229,10 @@ Task IVSRThreadExecutor::CreateTask(char* inBuf, char* outBuf, InferFlag flag, i
     return task;
 }
 
-void IVSRThreadExecutor::wait_all(int patchSize) {
-    _impl->sync(patchSize);
+IVSRStatus IVSRThreadExecutor::wait_all(int patchSize) {
+    IVSRStatus status = _impl->sync(patchSize);
     _impl->reset();
+    return status;
 }
 
 double IVSRThreadExecutor::get_duration_in_milliseconds() {
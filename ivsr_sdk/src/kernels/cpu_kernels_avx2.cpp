@@ -0,0 +1,95 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file cpu_kernels_avx2.cpp
+ * kernels built with -mavx2 -mfma -mf16c, see src/CMakeLists.txt. Results are bit exact with the generic set.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "ivsr_cpu_isa.hpp"
+
+#ifdef __AVX2__
+#    include <immintrin.h>
+
+namespace {
+
+const size_t kVector = 32;  // bytes
+
+bool aligned(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) % kVector == 0;
+}
+
+// the bytes before the first aligned vector and after the last one go through the caches
+void stream_row(char* dst, const char* src, size_t bytes) {
+    size_t head = (kVector - reinterpret_cast<uintptr_t>(dst) % kVector) % kVector;
+    if (head > bytes)
+        head = bytes;
+    memcpy(dst, src, head);
+    size_t i = head;
+    for (; i + kVector <= bytes; i += kVector)
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    memcpy(dst + i, src + i, bytes - i);
+}
+
+void copy_rows(void* dst, size_t dstStride, const void* src, size_t srcStride, size_t rowBytes, size_t rows,
+               bool stream) {
+    char* d = static_cast<char*>(dst);
+    const char* s = static_cast<const char*>(src);
+    for (size_t r = 0; r < rows; ++r) {
+        if (stream)
+            stream_row(d + r * dstStride, s + r * srcStride, rowBytes);
+        else
+            memcpy(d + r * dstStride, s + r * srcStride, rowBytes);
+    }
+    if (stream)
+        _mm_sfence();
+}
+
+void add(float* dst, const float* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+    for (; i < n; ++i)
+        dst[i] += src[i];
+}
+
+void divide(float* dst, const int* counts, int scale, size_t n, bool stream) {
+    size_t i = 0;
+    if (stream) {
+        for (; i < n && !aligned(dst + i); ++i)
+            dst[i] /= counts[i] * scale;
+    }
+    const __m256i vscale = _mm256_set1_epi32(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256i c = _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts + i)), vscale);
+        __m256 v = _mm256_div_ps(_mm256_loadu_ps(dst + i), _mm256_cvtepi32_ps(c));
+        if (stream)
+            _mm256_stream_ps(dst + i, v);
+        else
+            _mm256_storeu_ps(dst + i, v);
+    }
+    for (; i < n; ++i)
+        dst[i] /= counts[i] * scale;
+    if (stream)
+        _mm_sfence();
+}
+
+}  // namespace
+
+const CpuKernels avx2Kernels = {copy_rows, add, divide};
+#endif
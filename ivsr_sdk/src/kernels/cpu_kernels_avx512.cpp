@@ -0,0 +1,116 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file cpu_kernels_avx512.cpp
+ * kernels built with -mavx512f -mavx512bw -mavx512vl -mavx512dq, see src/CMakeLists.txt.
+ * Tails are masked instead of looped, results are bit exact with the generic set.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "ivsr_cpu_isa.hpp"
+
+#ifdef __AVX512F__
+#    include <immintrin.h>
+
+namespace {
+
+const size_t kVector = 64;  // bytes
+
+__mmask16 tail_mask(size_t n) {
+    return static_cast<__mmask16>((1u << n) - 1);
+}
+
+__mmask64 tail_mask_bytes(size_t n) {
+    return n >= 64 ? ~0ull : (1ull << n) - 1;
+}
+
+// the bytes before the first aligned vector and after the last one go through the caches
+void stream_row(char* dst, const char* src, size_t bytes) {
+    size_t head = (kVector - reinterpret_cast<uintptr_t>(dst) % kVector) % kVector;
+    if (head > bytes)
+        head = bytes;
+    __mmask64 m = tail_mask_bytes(head);
+    _mm512_mask_storeu_epi8(dst, m, _mm512_maskz_loadu_epi8(m, src));
+    size_t i = head;
+    for (; i + kVector <= bytes; i += kVector)
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + i), _mm512_loadu_si512(src + i));
+    m = tail_mask_bytes(bytes - i);
+    _mm512_mask_storeu_epi8(dst + i, m, _mm512_maskz_loadu_epi8(m, src + i));
+}
+
+void copy_rows(void* dst, size_t dstStride, const void* src, size_t srcStride, size_t rowBytes, size_t rows,
+               bool stream) {
+    char* d = static_cast<char*>(dst);
+    const char* s = static_cast<const char*>(src);
+    for (size_t r = 0; r < rows; ++r) {
+        if (stream)
+            stream_row(d + r * dstStride, s + r * srcStride, rowBytes);
+        else
+            memcpy(d + r * dstStride, s + r * srcStride, rowBytes);
+    }
+    if (stream)
+        _mm_sfence();
+}
+
+void add(float* dst, const float* src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(dst + i, _mm512_add_ps(_mm512_loadu_ps(dst + i), _mm512_loadu_ps(src + i)));
+    if (i < n) {
+        __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(dst + i, m,
+                              _mm512_add_ps(_mm512_maskz_loadu_ps(m, dst + i), _mm512_maskz_loadu_ps(m, src + i)));
+    }
+}
+
+// lanes outside m are neither divided nor stored
+__m512 divide_vector(const float* dst, const int* counts, __m512i vscale, __mmask16 m) {
+    __m512i c = _mm512_mullo_epi32(_mm512_maskz_loadu_epi32(m, counts), vscale);
+    __m512 v = _mm512_maskz_loadu_ps(m, dst);
+    return _mm512_mask_div_ps(v, m, v, _mm512_maskz_cvtepi32_ps(m, c));
+}
+
+void divide(float* dst, const int* counts, int scale, size_t n, bool stream) {
+    const __m512i vscale = _mm512_set1_epi32(scale);
+    size_t i = 0;
+    if (stream) {
+        size_t head = (kVector - reinterpret_cast<uintptr_t>(dst) % kVector) % kVector / sizeof(float);
+        if (head > n)
+            head = n;
+        __mmask16 m = tail_mask(head);
+        _mm512_mask_storeu_ps(dst, m, divide_vector(dst, counts, vscale, m));
+        i = head;
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = divide_vector(dst + i, counts + i, vscale, 0xffff);
+        if (stream)
+            _mm512_stream_ps(dst + i, v);
+        else
+            _mm512_storeu_ps(dst + i, v);
+    }
+    if (i < n) {
+        __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(dst + i, m, divide_vector(dst + i, counts + i, vscale, m));
+    }
+    if (stream)
+        _mm_sfence();
+}
+
+}  // namespace
+
+const CpuKernels avx512Kernels = {copy_rows, add, divide};
+#endif
@@ -0,0 +1,46 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+/**
+ * @file cpu_kernels_generic.cpp
+ * kernels built with the flags of the library, the reference of the other sets.
+ */
+
+#include <cstring>
+
+#include "ivsr_cpu_isa.hpp"
+
+namespace {
+
+void copy_rows(void* dst, size_t dstStride, const void* src, size_t srcStride, size_t rowBytes, size_t rows,
+               bool /*stream*/) {
+    char* d = static_cast<char*>(dst);
+    const char* s = static_cast<const char*>(src);
+    for (size_t r = 0; r < rows; ++r)
+        memcpy(d + r * dstStride, s + r * srcStride, rowBytes);
+}
+
+void add(float* dst, const float* src, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        dst[i] += src[i];
+}
+
+void divide(float* dst, const int* counts, int scale, size_t n, bool /*stream*/) {
+    for (size_t i = 0; i < n; ++i)
+        dst[i] /= counts[i] * scale;
+}
+
+}  // namespace
+
+const CpuKernels genericKernels = {copy_rows, add, divide};
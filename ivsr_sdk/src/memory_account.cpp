@@ -0,0 +1,55 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_memory.hpp"
+
+namespace {
+
+std::atomic<size_t> g_process_total{0};
+std::atomic<size_t> g_process_peak{0};
+
+void update_peak(std::atomic<size_t>& peak, size_t value) {
+    size_t prev = peak.load(std::memory_order_relaxed);
+    while (value > prev && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+MemoryAccount::~MemoryAccount() {
+    g_process_total.fetch_sub(total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryAccount::add(MemoryKind kind, size_t bytes) {
+    current_[static_cast<int>(kind)].fetch_add(bytes, std::memory_order_relaxed);
+    update_peak(peak_, total_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    update_peak(g_process_peak, g_process_total.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryAccount::release(MemoryKind kind, size_t bytes) {
+    current_[static_cast<int>(kind)].fetch_sub(bytes, std::memory_order_relaxed);
+    total_.fetch_sub(bytes, std::memory_order_relaxed);
+    g_process_total.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void MemoryAccount::snapshot(ivsr_memory_usage_t& usage) const {
+    usage.model = current_[static_cast<int>(MemoryKind::MODEL)].load(std::memory_order_relaxed);
+    usage.infer_requests = current_[static_cast<int>(MemoryKind::INFER_REQUESTS)].load(std::memory_order_relaxed);
+    usage.patch_staging = current_[static_cast<int>(MemoryKind::PATCH_STAGING)].load(std::memory_order_relaxed);
+    usage.pixel_counter = current_[static_cast<int>(MemoryKind::PIXEL_COUNTER)].load(std::memory_order_relaxed);
+    usage.frame_window = current_[static_cast<int>(MemoryKind::FRAME_WINDOW)].load(std::memory_order_relaxed);
+    usage.total = total_.load(std::memory_order_relaxed);
+    usage.peak = peak_.load(std::memory_order_relaxed);
+    usage.process_total = g_process_total.load(std::memory_order_relaxed);
+    usage.process_peak = g_process_peak.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,184 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_model_loader.hpp"
+
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <irguard.hpp>
+
+namespace {
+
+std::string lower_extension(const std::string& path) {
+    auto slash = path.find_last_of('/');
+    auto dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return "";
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+// identity of a file: a rewritten or replaced file is a different model
+struct FileId {
+    dev_t dev = 0;
+    ino_t ino = 0;
+    off_t size = 0;
+    int64_t mtime = 0;  // ns
+
+    bool operator<(const FileId& o) const {
+        return std::tie(dev, ino, size, mtime) < std::tie(o.dev, o.ino, o.size, o.mtime);
+    }
+};
+
+bool file_id(const std::string& path, FileId& id) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    id.dev = st.st_dev;
+    id.ino = st.st_ino;
+    id.size = st.st_size;
+    id.mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+struct CacheKey {
+    FileId xml;
+    FileId bin;  // weights next to the xml, zero if there are none
+    std::string customLib;
+
+    bool operator<(const CacheKey& o) const {
+        return std::tie(xml, bin, customLib) < std::tie(o.xml, o.bin, o.customLib);
+    }
+};
+
+// A decrypted model, alive while a handle uses it. Operations of an extension library are
+// implemented by it, so the library is held as well in case the core which loaded it is gone.
+struct DecryptedModel {
+    std::shared_ptr<ov::Model> model;
+    void* lib = nullptr;
+
+    ~DecryptedModel() {
+        model.reset();
+        if (lib)
+            dlclose(lib);
+    }
+};
+
+struct CacheEntry {
+    std::mutex loading;  // concurrent first loads of a model decrypt it once
+    std::weak_ptr<DecryptedModel> model;
+};
+
+std::mutex cacheMutex;
+std::map<CacheKey, std::shared_ptr<CacheEntry>> cache;
+
+std::shared_ptr<CacheEntry> cache_entry(const CacheKey& key) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // entries of models no handle uses any more
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.use_count() == 1 && it->second->model.expired())
+            it = cache.erase(it);
+        else
+            ++it;
+    }
+    auto& entry = cache[key];
+    if (!entry)
+        entry = std::make_shared<CacheEntry>();
+    return entry;
+}
+
+std::shared_ptr<ov::Model> load_protected(ov::Core& core,
+                                          const std::string& path,
+                                          const std::string& custom_lib,
+                                          std::shared_ptr<const void>& keep_alive) {
+    CacheKey key;
+    if (!file_id(path, key.xml))
+        return irguard::load_model(core, path);
+    auto dot = path.find_last_of('.');
+    file_id(path.substr(0, dot) + ".bin", key.bin);
+    key.customLib = custom_lib;
+
+    auto entry = cache_entry(key);
+    std::lock_guard<std::mutex> lock(entry->loading);
+    auto decrypted = entry->model.lock();
+    if (!decrypted) {
+        decrypted = std::make_shared<DecryptedModel>();
+        decrypted->model = irguard::load_model(core, path);
+        if (!custom_lib.empty())
+            decrypted->lib = dlopen(custom_lib.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+        entry->model = decrypted;
+#ifdef ENABLE_LOG
+        std::cout << "[INFO]: " << "decrypted protected model " << path << std::endl;
+    } else {
+        std::cout << "[INFO]: " << "protected model " << path << " is shared with another handle" << std::endl;
+#endif
+    }
+    keep_alive = decrypted;
+    // handles reshape and preprocess their model, the decrypted one stays as read
+    return decrypted->model->clone();
+}
+
+}  // namespace
+
+ModelFormat detect_model_format(const std::string& path) {
+    const std::string ext = lower_extension(path);
+    if (ext == "onnx" || ext == "pb" || ext == "pbtxt" || ext == "pdmodel" || ext == "tflite")
+        return ModelFormat::OTHER;
+
+    std::ifstream file(path, std::ios::binary);
+    char head[64];
+    file.read(head, sizeof(head));
+    const size_t n = file ? sizeof(head) : static_cast<size_t>(file.gcount());
+    if (n == 0)
+        return ModelFormat::UNKNOWN;
+
+    size_t i = 0;
+    if (n >= 3 && head[0] == '\xEF' && head[1] == '\xBB' && head[2] == '\xBF')  // UTF-8 BOM
+        i = 3;
+    while (i < n && std::isspace(static_cast<unsigned char>(head[i])))
+        ++i;
+    if (ext != "xml" || i == n)
+        return ModelFormat::UNKNOWN;
+    // an IR starts with the xml declaration or the <net> element, the protected one is ciphertext
+    return head[i] == '<' ? ModelFormat::IR : ModelFormat::PROTECTED_IR;
+}
+
+std::shared_ptr<ov::Model> load_model(ov::Core& core,
+                                      const std::string& path,
+                                      const std::string& custom_lib,
+                                      std::shared_ptr<const void>& keep_alive) {
+    keep_alive.reset();
+    switch (detect_model_format(path)) {
+    case ModelFormat::IR:
+    case ModelFormat::OTHER:
+        return core.read_model(path);
+    case ModelFormat::PROTECTED_IR:
+        return load_protected(core, path, custom_lib, keep_alive);
+    default:
+        break;
+    }
+    try {
+        return core.read_model(path);
+    } catch (const std::exception& e) {
+        return irguard::load_model(core, path);
+    }
+}
@@ -0,0 +1,241 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_numa.hpp"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "ivsr_perf_stats.hpp"
+#include "utils.hpp"
+
+namespace {
+
+const unsigned long kMaxNodes = 256;
+const size_t kMaskWords = kMaxNodes / (8 * sizeof(unsigned long));
+
+// "0-3,8-11" as in the cpulist files of sysfs
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    for (auto& range : split(list, ',')) {
+        if (range.empty())
+            continue;
+        try {
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+std::vector<NumaNode> read_topology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        CPU_ZERO(&allowed);
+
+    std::vector<NumaNode> nodes;
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name(entry->d_name);
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+            std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+            std::string list;
+            std::getline(file, list);
+            NumaNode node{std::stoi(name.substr(4)), {}};
+            // only the CPUs this process may run on
+            for (int cpu : parse_cpu_list(list)) {
+                if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                    node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty() && node.id < static_cast<int>(kMaxNodes))
+                nodes.push_back(std::move(node));
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) {
+        return a.id < b.id;
+    });
+
+    if (nodes.empty()) {
+        NumaNode node{0, {}};
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed))
+                node.cpus.push_back(cpu);
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+const NumaNode* find_node(int id) {
+    for (auto& node : numa_nodes()) {
+        if (node.id == id)
+            return &node;
+    }
+    return nullptr;
+}
+
+void node_mask(int node, unsigned long (&mask)[kMaskWords]) {
+    std::fill(std::begin(mask), std::end(mask), 0UL);
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+}
+
+bool set_affinity(const NumaNode& node) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : node.cpus)
+        CPU_SET(cpu, &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+// kernels without NUMA support or sandboxes return ENOSYS/EPERM, placement is then left to the kernel
+bool set_preferred(int node) {
+    unsigned long mask[kMaskWords];
+    node_mask(node, mask);
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, kMaxNodes) == 0)
+        return true;
+    static std::once_flag warned;
+    std::call_once(warned, [] {
+        std::cout << "[WARNING]: " << "memory policy is not available, NUMA_NODE binds CPUs only" << std::endl;
+    });
+    return false;
+}
+
+struct NodeCounters {
+    std::set<const PerfStats*> handles;
+    uint64_t retired = 0;  // frames of de-initialized handles
+    Time::time_point start;
+    bool started = false;
+};
+
+std::mutex g_counters_mutex;
+std::map<int, NodeCounters> g_counters;
+std::atomic<size_t> g_next_auto{0};
+
+}  // namespace
+
+const std::vector<NumaNode>& numa_nodes() {
+    static const std::vector<NumaNode> nodes = read_topology();
+    return nodes;
+}
+
+int numa_parse_node(const std::string& value) {
+    const auto& nodes = numa_nodes();
+    if (value == "auto")
+        return nodes[g_next_auto.fetch_add(1) % nodes.size()].id;
+    try {
+        size_t pos = 0;
+        int node = std::stoi(value, &pos);
+        return pos == value.size() && find_node(node) ? node : -1;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+bool numa_bind_thread(int node) {
+    const NumaNode* found = find_node(node);
+    if (found == nullptr || !set_affinity(*found))
+        return false;
+    set_preferred(node);
+    return true;
+}
+
+void numa_prefer_memory(void* addr, size_t bytes, int node) {
+    if (node < 0 || addr == nullptr)
+        return;
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + page - 1) / page * page;
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes) / page * page;
+    if (end <= begin)
+        return;
+    unsigned long mask[kMaskWords];
+    node_mask(node, mask);
+    // pages already touched stay where they are, the ranges are fresh allocations
+    syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED, mask, kMaxNodes, 0);
+}
+
+NumaScope::NumaScope(int node) {
+    const NumaNode* found = find_node(node);
+    if (found == nullptr)
+        return;
+    if (sched_getaffinity(0, sizeof(savedCpus_), &savedCpus_) == 0)
+        restoreCpus_ = set_affinity(*found);
+    if (syscall(SYS_get_mempolicy, &savedPolicy_, savedNodes_, kMaxNodes, nullptr, 0) == 0)
+        restorePolicy_ = set_preferred(node);
+}
+
+NumaScope::~NumaScope() {
+    if (restoreCpus_)
+        sched_setaffinity(0, sizeof(savedCpus_), &savedCpus_);
+    if (restorePolicy_)
+        syscall(SYS_set_mempolicy, savedPolicy_, savedPolicy_ == MPOL_DEFAULT ? nullptr : savedNodes_, kMaxNodes);
+}
+
+void numa_register(int node, const PerfStats* stats) {
+    std::lock_guard<std::mutex> lock(g_counters_mutex);
+    auto& counters = g_counters[node];
+    if (!counters.started) {
+        counters.start = Time::now();
+        counters.started = true;
+    }
+    counters.handles.insert(stats);
+}
+
+void numa_unregister(int node, const PerfStats* stats) {
+    std::lock_guard<std::mutex> lock(g_counters_mutex);
+    auto& counters = g_counters[node];
+    if (counters.handles.erase(stats))
+        counters.retired += stats->frames.load(std::memory_order_relaxed);
+}
+
+void numa_snapshot(int node, ivsr_numa_stats_t& stats) {
+    const auto& nodes = numa_nodes();
+    stats = {};
+    stats.node = node;
+    stats.num_nodes = static_cast<int>(std::min<size_t>(nodes.size(), IVSR_MAX_NUMA_NODES));
+
+    auto now = Time::now();
+    std::lock_guard<std::mutex> lock(g_counters_mutex);
+    for (int i = 0; i < stats.num_nodes; ++i) {
+        stats.node_ids[i] = nodes[i].id;
+        stats.cpus[i] = static_cast<uint32_t>(nodes[i].cpus.size());
+        auto it = g_counters.find(nodes[i].id);
+        if (it == g_counters.end())
+            continue;
+        uint64_t frames = it->second.retired;
+        for (auto handle : it->second.handles)
+            frames += handle->frames.load(std::memory_order_relaxed);
+        stats.frames[i] = frames;
+        double seconds = std::chrono::duration<double>(now - it->second.start).count();
+        stats.fps[i] = seconds > 0.0 ? frames / seconds : 0.0;
+    }
+}
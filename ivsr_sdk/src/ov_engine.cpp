@@ -23,8 +23,8 @@
 
 #include <cassert>
 #include <cstring>
-#include <irguard.hpp>
 
+#include "ivsr_model_loader.hpp"
 #include "omp.h"
 #include "utils.hpp"
 
@@ -79,11 +79,7 @@ IVSRStatus ov_engine::init_impl() {
     }
     // read model
     std::shared_ptr<ov::Model> model;
-    try {
-        model = instance_.read_model(model_path_);
-    } catch (const std::exception& e) {
-        model = irguard::load_model(instance_, model_path_);
-    }
+    model = load_model(instance_, model_path_, custom_lib_, source_model_);
 
     bool multiple_inputs = false;
     if (model->inputs().size() == 5 && model->outputs().size() == 5)
@@ -111,37 +107,53 @@ IVSRStatus ov_engine::init_impl() {
 
         // Assume the input reshape_settings_'s layout is NHW.
         // update input layer tensor batch/width/height with the value from reshape_settings_;
+        size_t reshape_w = reshape_settings_[ov::layout::width_idx(ov::Layout("NHW"))];
+        size_t reshape_h = reshape_settings_[ov::layout::height_idx(ov::Layout("NHW"))];
         input_shape[batch_index] = reshape_settings_[ov::layout::batch_idx(ov::Layout("NHW"))];
-        input_shape[w_index] = reshape_settings_[ov::layout::width_idx(ov::Layout("NHW"))];
-        input_shape[h_index] = reshape_settings_[ov::layout::height_idx(ov::Layout("NHW"))];
-        //input_shape should be static now.
-        assert(input_shape.is_static());
-
-        //TODO: is this check for BasicVSR? Is it required anymore??
-        if (input_shape.size() == 5) {
-            if (input_shape[w_index].get_length() % 32 != 0) {
-                std::cout << "[Error]: " << "Current model requires input widths to be divisible by 32" << std::endl;
-                return UNSUPPORTED_SHAPE;
+        if (is_dynamic()) {
+            // bounded height and width, every inference takes the frame padded to the alignment only
+            input_shape[w_index] = ov::Dimension(1, reshape_w);
+            input_shape[h_index] = ov::Dimension(1, reshape_h);
+        } else {
+            input_shape[w_index] = reshape_w;
+            input_shape[h_index] = reshape_h;
+            //input_shape should be static now.
+            assert(input_shape.is_static());
+
+            //TODO: is this check for BasicVSR? Is it required anymore??
+            if (input_shape.size() == 5) {
+                if (input_shape[w_index].get_length() % 32 != 0) {
+                    std::cout << "[Error]: " << "Current model requires input widths to be divisible by 32, "
+                              << "or set DYNAMIC_SHAPE with the alignment" << std::endl;
+                    return UNSUPPORTED_SHAPE;
+                }
             }
         }
 
 #ifdef ENABLE_LOG
-        std::cout << "Reshape network to size = [" << input_shape[w_index].get_length()
-			      << "x" << input_shape[h_index].get_length() << "] " << std::endl;
+        std::cout << "Reshape network to size = [" << input_shape[w_index]
+			      << "x" << input_shape[h_index] << "] " << std::endl;
 #endif
-        // reshape the model with "static" shape.
-        model->reshape({{model->inputs()[0].get_any_name(), input_shape.to_shape()}});
+        // reshape the model with "static" shape, or the upper bounds of a dynamic shape.
+        model->reshape({{model->inputs()[0].get_any_name(), input_shape}});
 
         if (multiple_inputs) {
-            ov::Shape hidden_tensor_shape = input_shape.to_shape();
-            hidden_tensor_shape[batch_index] = input_shape[batch_index].get_length();
+            ov::PartialShape hidden_tensor_shape = input_shape;
             hidden_tensor_shape[channels_index] = 64;
-            hidden_tensor_shape[h_index] = input_shape[h_index].get_length() / 4;
-            hidden_tensor_shape[w_index] = input_shape[w_index].get_length() / 4;
+            if (is_dynamic()) {
+                hidden_tensor_shape[h_index] = ov::Dimension(1, reshape_h / 4);
+                hidden_tensor_shape[w_index] = ov::Dimension(1, reshape_w / 4);
+            } else {
+                hidden_tensor_shape[h_index] = reshape_h / 4;
+                hidden_tensor_shape[w_index] = reshape_w / 4;
+            }
 
             for (auto i = 1u; i < model->inputs().size(); ++i)
                 model->reshape({{model->inputs()[i].get_any_name(), hidden_tensor_shape}});
         }
+    } else if (is_dynamic()) {
+        std::cout << "[Error]: " << "DYNAMIC_SHAPE requires the upper bounds in RESHAPE_SETTINGS" << std::endl;
+        return UNSUPPORTED_SHAPE;
     }
 
     // build stateful model
@@ -224,9 +236,32 @@ IVSRStatus ov_engine::init_impl() {
 
     input_ = model->inputs()[0];
     output_ = model->outputs()[0];
+    input_shape_ = input_.get_partial_shape().get_max_shape();
+    output_shape_ = output_.get_partial_shape().get_max_shape();
+    if (is_dynamic()) {
+        ov::Layout input_layout = ov::layout::get_layout(input_);
+        ov::Layout output_layout = ov::layout::get_layout(output_);
+        input_h_idx_ = ov::layout::height_idx(input_layout);
+        input_w_idx_ = ov::layout::width_idx(input_layout);
+        output_h_idx_ = ov::layout::height_idx(output_layout);
+        output_w_idx_ = ov::layout::width_idx(output_layout);
+        if (output_.get_partial_shape()[output_h_idx_].get_max_length() < 0 ||
+            output_.get_partial_shape()[output_w_idx_].get_max_length() < 0) {
+            std::cout << "[Error]: " << "the output size of the dynamic shape model is unbounded" << std::endl;
+            return UNSUPPORTED_SHAPE;
+        }
+    }
     // compile model
     compiled_model_ = instance_.compile_model(model, device_);
 
+    // the plugin keeps its own copy of the weights
+    model_bytes_ = 0;
+    for (auto&& op : model->get_ordered_ops()) {
+        if (auto constant = std::dynamic_pointer_cast<ov::op::v0::Constant>(op))
+            model_bytes_ += constant->get_byte_size();
+    }
+    memory_.add(MemoryKind::MODEL, model_bytes_);
+
 #ifdef ENABLE_LOG
     std::cout << "[Trace]: " << "ov_engine init successfully" << std::endl;
 #endif
@@ -234,6 +269,33 @@ IVSRStatus ov_engine::init_impl() {
     return OK;
 }
 
+ov_engine::ov_engine(const ov_engine& source, CloneTag)
+    : engine(this),
+      device_(source.device_),
+      configs_(source.configs_),
+      instance_(source.instance_),
+      compiled_model_(source.compiled_model_),
+      reshape_settings_(source.reshape_settings_),
+      input_tensor_desc_(source.input_tensor_desc_),
+      output_tensor_desc_(source.output_tensor_desc_),
+      dynamic_align_(source.dynamic_align_),
+      custom_lib_(source.custom_lib_),
+      model_path_(source.model_path_),
+      source_model_(source.source_model_),
+      input_(source.input_),
+      output_(source.output_),
+      input_shape_(source.input_shape_),
+      output_shape_(source.output_shape_),
+      input_h_idx_(source.input_h_idx_),
+      input_w_idx_(source.input_w_idx_),
+      output_h_idx_(source.output_h_idx_),
+      output_w_idx_(source.output_w_idx_),
+      model_bytes_(source.model_bytes_) {}
+
+ov_engine* ov_engine::clone() const {
+    return new ov_engine(*this, CloneTag{});
+}
+
 IVSRStatus ov_engine::run_impl(InferTask::Ptr task) {
     // construct the input tensor
     if (task->inputPtr_ == nullptr || task->outputPtr_ == nullptr) {
@@ -241,69 +303,121 @@ IVSRStatus ov_engine::run_impl(InferTask::Ptr task) {
                   << "invalid input buffer pointer" << std::endl;
         return GENERAL_ERROR;
     }
-    auto inferReq = get_idle_request();
-
-    inferReq->set_callback([wp = std::weak_ptr<inferReqWrap>(inferReq), task](std::exception_ptr ex) {
-        auto request = wp.lock();
-#ifdef ENABLE_PERF
-        request->end_time();
-        auto latency = request->get_execution_time_in_milliseconds();
-        std::cout << "[PERF] Inference Latency: " << latency << "ms" << std::endl;
-#endif
+    auto inferReq = get_idle_request(*task);
+    return submit_request(inferReq, task);
+}
 
-        if (ex) {
-#ifdef ENABLE_LOG
-            std::cout << "[Trace]: "
-                      << "Exception in infer request callback " << std::endl;
-#endif
-            try {
-                // std::rethrow_exception(ex);
-                throw ex;
-            } catch (const std::exception& e) {
-                std::cout << "Caught exception \"" << e.what() << "\"\n";
-            }
-        }
-        auto cbTask = task;
+IVSRStatus ov_engine::process_impl(InferTask::Ptr task) {
+    // Check for valid input and output data pointers
+    if (task->inputPtr_ == nullptr || task->outputPtr_ == nullptr) {
+        std::cout << "[Error]: invalid input or output buffer pointer" << std::endl;
+        return GENERAL_ERROR;
+    }
 
-        request->call_back();
-        // call application callback function
-        cbTask->_callbackFunction(cbTask);
-    });
+    auto inferReq = get_idle_request(*task);
+    return submit_request(inferReq, task);
+}
 
-#ifdef ENABLE_LOG
-    std::cout << "[Trace]: "
-              << "input: " << input_.get_element_type().get_type_name() << " " << input_.get_shape() << std::endl;
-    std::cout << "[Trace]: "
-              << "output: " << output_.get_element_type().get_type_name() << " " << output_.get_shape() << std::endl;
-#endif
+IVSRStatus ov_engine::try_process_impl(InferTask::Ptr task) {
+    if (task->inputPtr_ == nullptr || task->outputPtr_ == nullptr) {
+        std::cout << "[Error]: invalid input or output buffer pointer" << std::endl;
+        return GENERAL_ERROR;
+    }
 
-    ov::Tensor input_tensor(input_.get_element_type(), input_.get_shape(), task->inputPtr_);
-    inferReq->set_input_tensor(input_tensor);
+    auto inferReq = try_get_idle_request();
+    if (!inferReq)
+        return WOULD_BLOCK;
 
-    ov::Tensor output_tensor(output_.get_element_type(), output_.get_shape(), task->outputPtr_);
-    inferReq->set_output_tensor(output_tensor);
-    inferReq->start_async();
+    return submit_request(inferReq, task);
+}
 
-#ifdef ENABLE_LOG
-    std::cout << "[Trace]: "
-              << "ov_engine run: start task inference" << std::endl;
-#endif
+// Copies a dense tensor of shape `from` into the leading box of a dense tensor of shape `to`,
+// the rest of `to` is zero-filled.
+static void pad_box(const char* src, const ov::Shape& from, char* dst, const ov::Shape& to, size_t dim, size_t elem) {
+    size_t src_stride = elem, dst_stride = elem;
+    for (size_t d = dim + 1; d < from.size(); ++d) {
+        src_stride *= from[d];
+        dst_stride *= to[d];
+    }
+    if (src_stride == dst_stride) {
+        std::memcpy(dst, src, from[dim] * src_stride);
+    } else {
+        for (size_t i = 0; i < from[dim]; ++i)
+            pad_box(src + i * src_stride, from, dst + i * dst_stride, to, dim + 1, elem);
+    }
+    std::memset(dst + from[dim] * dst_stride, 0, (to[dim] - from[dim]) * dst_stride);
+}
 
-    return OK;
+// Copies the leading box of shape `to` out of a dense tensor of shape `from`.
+static void crop_box(const char* src, const ov::Shape& from, char* dst, const ov::Shape& to, size_t dim, size_t elem) {
+    size_t src_stride = elem, dst_stride = elem;
+    for (size_t d = dim + 1; d < from.size(); ++d) {
+        src_stride *= from[d];
+        dst_stride *= to[d];
+    }
+    if (src_stride == dst_stride) {
+        std::memcpy(dst, src, to[dim] * dst_stride);
+        return;
+    }
+    for (size_t i = 0; i < to[dim]; ++i)
+        crop_box(src + i * src_stride, from, dst + i * dst_stride, to, dim + 1, elem);
 }
 
-IVSRStatus ov_engine::process_impl(void* input_data, void* output_data, void* cb) {
-    // Check for valid input and output data pointers
-    if (input_data == nullptr || output_data == nullptr) {
-        std::cout << "[Error]: invalid input or output buffer pointer" << std::endl;
-        return GENERAL_ERROR;
+IVSRStatus ov_engine::submit_request(inferReqWrap::Ptr inferReq, InferTask::Ptr task) {
+    uint64_t state_epoch = state_epoch_.load(std::memory_order_acquire);
+    if (inferReq->state_epoch() != state_epoch) {
+        TraceScope trace("reset_state", task->frameId_, task->patchId_, inferReq->id());
+        inferReq->reset_state();
+        inferReq->set_state_epoch(state_epoch);
     }
 
-    auto inferReq = get_idle_request();
+    // A dynamic shape model infers the frame size rounded up to the alignment,
+    // only a frame which is not aligned goes through the padded staging buffers of the request.
+    ov::Shape input_shape = input_shape_, output_shape = output_shape_;
+    ov::Shape frame_output_shape;  // set if the output is cropped from the staging buffer
+    char* input_data = task->inputPtr_;
+    char* output_data = task->outputPtr_;
+    if (is_dynamic() && task->height_ > 0) {
+        auto align_up = [](size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        };
+        size_t scale_h = output_shape_[output_h_idx_] / input_shape_[input_h_idx_];
+        size_t scale_w = output_shape_[output_w_idx_] / input_shape_[input_w_idx_];
+        size_t height = align_up(task->height_, dynamic_align_[0]);
+        size_t width = align_up(task->width_, dynamic_align_[1]);
+        input_shape[input_h_idx_] = height;
+        input_shape[input_w_idx_] = width;
+        output_shape[output_h_idx_] = height * scale_h;
+        output_shape[output_w_idx_] = width * scale_w;
+
+        if (height != task->height_ || width != task->width_) {
+            TraceScope trace("pad_input", task->frameId_, task->patchId_, inferReq->id());
+            ov::Shape frame_input_shape = input_shape;
+            frame_input_shape[input_h_idx_] = task->height_;
+            frame_input_shape[input_w_idx_] = task->width_;
+            frame_output_shape = output_shape;
+            frame_output_shape[output_h_idx_] = task->height_ * scale_h;
+            frame_output_shape[output_w_idx_] = task->width_ * scale_w;
+
+            size_t grown = 0;
+            input_data = inferReq->staging(0, input_bytes(), grown);
+            memory_.add(MemoryKind::INFER_REQUESTS, grown);
+            output_data = inferReq->staging(1, ov::shape_size(output_shape_) * output_.get_element_type().size(), grown);
+            memory_.add(MemoryKind::INFER_REQUESTS, grown);
+            pad_box(task->inputPtr_, frame_input_shape, input_data, input_shape, 0, input_.get_element_type().size());
+        }
+    }
 
     // Set callback for inference request
-    inferReq->set_callback([wp = std::weak_ptr<inferReqWrap>(inferReq), cb](std::exception_ptr ex) {
+    inferReq->set_callback([this, wp = std::weak_ptr<inferReqWrap>(inferReq), task, output_data, output_shape,
+                            frame_output_shape](std::exception_ptr ex) {
         auto request = wp.lock();
+        task->_endTime = Time::now();
+        if (!frame_output_shape.empty() && !ex) {
+            TraceScope trace("crop_output", task->frameId_, task->patchId_, request->id());
+            crop_box(output_data, output_shape, task->outputPtr_, frame_output_shape, 0,
+                     output_.get_element_type().size());
+        }
 #ifdef ENABLE_PERF
         request->end_time();
         auto latency = request->get_execution_time_in_milliseconds();
@@ -311,6 +425,7 @@ IVSRStatus ov_engine::process_impl(void* input_data, void* output_data, void* cb
 #endif
 
         if (ex) {
+            task->status_ = GENERAL_ERROR;
 #ifdef ENABLE_LOG
             std::cout << "[Trace]: Exception in infer request callback " << std::endl;
 #endif
@@ -322,30 +437,44 @@ IVSRStatus ov_engine::process_impl(void* input_data, void* output_data, void* cb
             }
         }
 
+        Tracer::record("infer", task->_startTime, task->_endTime, task->frameId_, task->patchId_, request->id());
+        on_task_done(*task);
         request->call_back();
 
-        // Check if the callback structure and function are valid, then call the function
-        if (cb) {
-            ivsr_cb_t* ivsr_cb = static_cast<ivsr_cb_t*>(cb);
-            if (ivsr_cb->ivsr_cb) {
-                ivsr_cb->ivsr_cb(ivsr_cb->args);
-            }
+        TraceScope trace("callback", task->frameId_, task->patchId_, request->id());
+        auto callbackStart = Time::now();
+        // the queue callback (executor or completion queue) owns the user callback if it is set
+        if (task->_callbackFunction) {
+            task->_callbackFunction(task);
+        } else if (task->cb && task->cb->ivsr_cb) {
+            task->cb->ivsr_cb(task->cb->args);
+        }
+        auto callbackEnd = Time::now();
+        perf_stats_.callback.record(callbackStart, callbackEnd);
+        if (task->endsFrame_) {
+            perf_stats_.frames.fetch_add(1, std::memory_order_relaxed);
+            perf_stats_.endToEnd.record(task->submitTime_, callbackEnd);
         }
     });
 
 #ifdef ENABLE_LOG
-    std::cout << "[Trace]: input: " << input_.get_element_type().get_type_name() << " " << input_.get_shape() << std::endl;
-    std::cout << "[Trace]: output: " << output_.get_element_type().get_type_name() << " " << output_.get_shape() << std::endl;
+    std::cout << "[Trace]: input: " << input_.get_element_type().get_type_name() << " " << input_shape << std::endl;
+    std::cout << "[Trace]: output: " << output_.get_element_type().get_type_name() << " " << output_shape << std::endl;
 #endif
 
     // Construct input and output tensors
-    ov::Tensor input_tensor(input_.get_element_type(), input_.get_shape(), input_data);
-    inferReq->set_input_tensor(input_tensor);
+    {
+        TraceScope trace("set_tensors", task->frameId_, task->patchId_, inferReq->id());
+        ov::Tensor input_tensor(input_.get_element_type(), input_shape, input_data);
+        inferReq->set_input_tensor(input_tensor);
 
-    ov::Tensor output_tensor(output_.get_element_type(), output_.get_shape(), output_data);
-    inferReq->set_output_tensor(output_tensor);
+        ov::Tensor output_tensor(output_.get_element_type(), output_shape, output_data);
+        inferReq->set_output_tensor(output_tensor);
+    }
 
     // Start asynchronous inference
+    TraceScope trace("start_async", task->frameId_, task->patchId_, inferReq->id());
+    task->_startTime = Time::now();
     inferReq->start_async();
 
 #ifdef ENABLE_LOG
@@ -356,6 +485,8 @@ IVSRStatus ov_engine::process_impl(void* input_data, void* output_data, void* cb
 }
 
 IVSRStatus ov_engine::create_infer_requests_impl(size_t requests_num) {
+    // patched frames grow the pool at runtime while other threads take and return requests
+    std::unique_lock<std::mutex> lock(mutex_);
     if (requests_num < requests_.size()) {
         std::cout << "[ERROR]: "
                   << "please pass correct requests num.\n";
@@ -368,7 +499,89 @@ IVSRStatus ov_engine::create_infer_requests_impl(size_t requests_num) {
                                            id,
                                            std::bind(&ov_engine::put_idle_request, this, std::placeholders::_1)));
         idleIds_.push(id);
+        if (request_bytes_ == 0)
+            request_bytes_ = requests_.back()->tensor_bytes();
+        memory_.add(MemoryKind::INFER_REQUESTS, request_bytes_);
     }
+    cv_.notify_all();
 
     return OK;
 }
+
+IVSRStatus ov_engine::warmup_impl(size_t iterations, bool background) {
+    if (iterations == 0)
+        return OK;
+
+    // Take every request out of the idle queue, submissions block in get_idle_request() until warmup is done.
+    std::vector<inferReqWrap::Ptr> warmup_requests;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (warmup_running_) {
+            std::cout << "[ERROR]: " << "warmup is already running.\n";
+            return GENERAL_ERROR;
+        }
+        cv_.wait(lock, [this] {
+            return idleIds_.size() == requests_.size();
+        });
+        while (!idleIds_.empty()) {
+            warmup_requests.push_back(requests_.at(idleIds_.front()));
+            idleIds_.pop();
+        }
+        warmup_running_ = true;
+    }
+
+    auto run = [this, warmup_requests, iterations]() {
+        auto startTime = Time::now();
+        IVSRStatus status = OK;
+        try {
+            for (auto& request : warmup_requests) {
+                request->set_callback([](std::exception_ptr) {});
+                // a dynamic shape model is warmed up at its largest shape
+                if (is_dynamic())
+                    request->set_input_tensor(ov::Tensor(input_.get_element_type(), input_shape_));
+                ov::Tensor input_tensor = request->get_input_tensor();
+                std::memset(input_tensor.data(), 0, input_tensor.get_byte_size());
+            }
+            // all requests run concurrently so that every stream/queue of the device gets initialized
+            for (size_t i = 0; i < iterations; ++i) {
+                for (auto& request : warmup_requests)
+                    request->start_async();
+                for (auto& request : warmup_requests)
+                    request->wait();
+            }
+        } catch (const std::exception&) {
+            status = GENERAL_ERROR;
+        }
+        // synthetic frames must not leak into the hidden states of recurrent models, also after a failure
+        for (auto& request : warmup_requests) {
+            try {
+                request->reset_state();
+            } catch (const std::exception&) {
+                status = GENERAL_ERROR;
+            }
+        }
+        double duration = get_duration_ms_till_now(startTime);
+        if (status == OK)
+            std::cout << "[INFO] " << "Warmup " << iterations << " iteration(s) on " << warmup_requests.size()
+                      << " infer request(s): " << double_to_string(duration) << "ms" << std::endl;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (auto& request : warmup_requests)
+                idleIds_.push(request->id());
+            warmup_duration_ms_ = duration;
+            warmup_status_ = status;
+            warmup_running_ = false;
+            cv_.notify_all();
+        }
+        if (ready_notifier_)
+            ready_notifier_();
+        return status;
+    };
+
+    if (background) {
+        warmup_thread_ = std::thread(run);
+        return OK;
+    }
+    return run();
+}
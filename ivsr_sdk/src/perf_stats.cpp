@@ -0,0 +1,90 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_perf_stats.hpp"
+
+#include <algorithm>
+
+int LatencyHistogram::bucket_of(uint64_t us) {
+    if (us < static_cast<uint64_t>(kSubBuckets))
+        return static_cast<int>(us);
+    int msb = 63 - __builtin_clzll(us);
+    if (msb >= kMaxBits)
+        return kBuckets - 1;
+    int shift = msb - kSubBits;
+    return (shift + 1) * kSubBuckets + static_cast<int>((us >> shift) - kSubBuckets);
+}
+
+double LatencyHistogram::bucket_value(int bucket) {
+    if (bucket < kSubBuckets)
+        return bucket;
+    int shift = bucket / kSubBuckets - 1;
+    uint64_t low = static_cast<uint64_t>(bucket % kSubBuckets + kSubBuckets) << shift;
+    return low + ((1ull << shift) - 1) * 0.5;
+}
+
+void LatencyHistogram::record_us(uint64_t us) {
+    counts_[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while (us > prev && !max_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::snapshot(ivsr_latency_stats_t& stats) const {
+    // buckets are read one by one while other threads keep recording, so the total comes from the buckets
+    uint64_t counts[kBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    const double max_us = static_cast<double>(max_.load(std::memory_order_relaxed));
+    auto percentile = [&](double p) -> double {
+        if (total == 0)
+            return 0.0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * total + 0.5));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::min(bucket_value(i), max_us) * 0.001;
+        }
+        return max_us * 0.001;
+    };
+
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    stats.count = total;
+    stats.mean = count ? sum_.load(std::memory_order_relaxed) * 0.001 / count : 0.0;
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = max_us * 0.001;
+}
+
+void PerfStats::snapshot(ivsr_perf_stats_t& stats) const {
+    stats.frames = frames.load(std::memory_order_relaxed);
+    stats.patches = patches.load(std::memory_order_relaxed);
+    stats.failed = failed.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    endToEnd.snapshot(stats.end_to_end);
+    queueWait.snapshot(stats.queue_wait);
+    inference.snapshot(stats.inference);
+    split.snapshot(stats.split);
+    merge.snapshot(stats.merge);
+    callback.snapshot(stats.callback);
+    reorder.snapshot(stats.reorder);
+    stats.fallback = fallback.load(std::memory_order_relaxed);
+}
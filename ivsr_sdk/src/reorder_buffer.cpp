@@ -0,0 +1,65 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_reorder_buffer.hpp"
+
+#include "ivsr_perf_stats.hpp"
+
+ReorderBuffer::ReorderBuffer(size_t depth, std::function<void()> on_space, LatencyHistogram* held)
+    : depth_(depth > 0 ? depth : 1),
+      onSpace_(std::move(on_space)),
+      held_(held) {}
+
+bool ReorderBuffer::reserve(bool blocking, uint64_t& seq) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto has_space = [this] {
+        return nextSeq_ - nextDeliver_ < depth_;
+    };
+    if (!has_space()) {
+        if (!blocking)
+            return false;
+        cv_.wait(lock, has_space);
+    }
+    seq = nextSeq_++;
+    return true;
+}
+
+void ReorderBuffer::complete(uint64_t seq, Delivery deliver) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_[seq] = Finished{std::move(deliver), Time::now()};
+    if (delivering_)
+        return;  // the running thread picks it up
+
+    delivering_ = true;
+    bool was_full = false;
+    for (auto it = finished_.find(nextDeliver_); it != finished_.end(); it = finished_.find(nextDeliver_)) {
+        Finished frame = std::move(it->second);
+        finished_.erase(it);
+        lock.unlock();
+        if (frame.deliver) {
+            if (held_)
+                held_->record(frame.time, Time::now());
+            frame.deliver();
+        }
+        lock.lock();
+        // the slot is freed after the delivery, so the buffers of an undelivered frame are not reused
+        was_full = was_full || nextSeq_ - nextDeliver_ >= depth_;
+        ++nextDeliver_;
+        cv_.notify_all();
+    }
+    delivering_ = false;
+    lock.unlock();
+
+    if (was_full && onSpace_)
+        onSpace_();
+}
@@ -0,0 +1,314 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_resampler.hpp"
+#include "ivsr_cpu_isa.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "omp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define IVSR_RESAMPLER_X86 1
+#endif
+
+namespace {
+
+const float kPi = 3.14159265358979323846f;
+
+float bicubic_kernel(float x) {
+    // Keys cubic convolution with a = -0.5, same as the bicubic filter of swscale/OpenCV
+    const float a = -0.5f;
+    x = std::fabs(x);
+    if (x < 1.0f)
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+    if (x < 2.0f)
+        return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
+    return 0.0f;
+}
+
+float lanczos3_kernel(float x) {
+    x = std::fabs(x);
+    if (x < 1e-6f)
+        return 1.0f;
+    if (x >= 3.0f)
+        return 0.0f;
+    float px = kPi * x;
+    return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+}
+
+template <typename T>
+inline void load_row(const T* src, float* dst, int width) {
+    for (int x = 0; x < width; ++x)
+        dst[x] = static_cast<float>(src[x]);
+}
+
+template <typename T>
+inline void store_row(const float* src, T* dst, int width, float srcMax, float outScale) {
+    for (int x = 0; x < width; ++x) {
+        float v = std::min(std::max(src[x], 0.0f), srcMax) * outScale;
+        dst[x] = static_cast<T>(v + 0.5f);
+    }
+}
+
+template <>
+inline void store_row<float>(const float* src, float* dst, int width, float srcMax, float outScale) {
+    for (int x = 0; x < width; ++x)
+        dst[x] = std::min(std::max(src[x], 0.0f), srcMax) * outScale;
+}
+
+void load_row_any(const void* src, PlaneType type, float* dst, int width) {
+    switch (type) {
+    case PlaneType::U8:
+        load_row(static_cast<const uint8_t*>(src), dst, width);
+        break;
+    case PlaneType::U16:
+        load_row(static_cast<const uint16_t*>(src), dst, width);
+        break;
+    case PlaneType::F32:
+        load_row(static_cast<const float*>(src), dst, width);
+        break;
+    }
+}
+
+void store_row_any(const float* src, void* dst, PlaneType type, int width, float srcMax, float outScale) {
+    switch (type) {
+    case PlaneType::U8:
+        store_row(src, static_cast<uint8_t*>(dst), width, srcMax, outScale);
+        break;
+    case PlaneType::U16:
+        store_row(src, static_cast<uint16_t*>(dst), width, srcMax, outScale);
+        break;
+    case PlaneType::F32:
+        store_row(src, static_cast<float*>(dst), width, srcMax, outScale);
+        break;
+    }
+}
+
+void horizontal_pass_ref(const float* row, float* out, int dstWidth, int taps, const int* index, const float* weight) {
+    for (int x = 0; x < dstWidth; ++x) {
+        const int* idx = index + x * taps;
+        const float* w = weight + x * taps;
+        float sum = 0.0f;
+        for (int t = 0; t < taps; ++t)
+            sum += row[idx[t]] * w[t];
+        out[x] = sum;
+    }
+}
+
+void vertical_pass_ref(const float* const* rows, const float* w, int taps, float* out, int width) {
+    for (int x = 0; x < width; ++x) {
+        float sum = 0.0f;
+        for (int t = 0; t < taps; ++t)
+            sum += rows[t][x] * w[t];
+        out[x] = sum;
+    }
+}
+
+#ifdef IVSR_RESAMPLER_X86
+// The filter bank is stored tap-major per destination pixel, so 8 destination pixels of one
+// tap are gathered with a stride of taps elements.
+__attribute__((target("avx2,fma"))) void horizontal_pass_avx2(const float* row,
+                                                               float* out,
+                                                               int dstWidth,
+                                                               int taps,
+                                                               const int* index,
+                                                               const float* weight) {
+    const __m256i stride = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(taps));
+    int x = 0;
+    for (; x + 8 <= dstWidth; x += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        const int* idx = index + x * taps;
+        const float* w = weight + x * taps;
+        for (int t = 0; t < taps; ++t) {
+            __m256i src_idx = _mm256_i32gather_epi32(idx + t, stride, 4);
+            __m256 src = _mm256_i32gather_ps(row, src_idx, 4);
+            __m256 wt = _mm256_i32gather_ps(w + t, stride, 4);
+            sum = _mm256_fmadd_ps(src, wt, sum);
+        }
+        _mm256_storeu_ps(out + x, sum);
+    }
+    if (x < dstWidth)
+        horizontal_pass_ref(row, out + x, dstWidth - x, taps, index + x * taps, weight + x * taps);
+}
+
+__attribute__((target("avx2,fma"))) void vertical_pass_avx2(const float* const* rows,
+                                                             const float* w,
+                                                             int taps,
+                                                             float* out,
+                                                             int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int t = 0; t < taps; ++t)
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(rows[t] + x), _mm256_set1_ps(w[t]), sum);
+        _mm256_storeu_ps(out + x, sum);
+    }
+    for (; x < width; ++x) {
+        float sum = 0.0f;
+        for (int t = 0; t < taps; ++t)
+            sum += rows[t][x] * w[t];
+        out[x] = sum;
+    }
+}
+
+bool cpu_has_avx2() {
+    return cpu_isa() >= CpuIsa::AVX2;
+}
+#endif
+
+}  // namespace
+
+bool parse_resample_filter(const std::string& name, ResampleFilter& filter) {
+    if (name == "bicubic") {
+        filter = ResampleFilter::BICUBIC;
+    } else if (name == "lanczos") {
+        filter = ResampleFilter::LANCZOS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_plane_type(const std::string& precision, PlaneType& type) {
+    if (precision == "u8") {
+        type = PlaneType::U8;
+    } else if (precision == "u16") {
+        type = PlaneType::U16;
+    } else if (precision == "f32" || precision == "fp32") {
+        type = PlaneType::F32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+size_t get_plane_type_size(PlaneType type) {
+    switch (type) {
+    case PlaneType::U8:
+        return sizeof(uint8_t);
+    case PlaneType::U16:
+        return sizeof(uint16_t);
+    case PlaneType::F32:
+        return sizeof(float);
+    }
+    return 0;
+}
+
+PlaneResampler::FilterBank PlaneResampler::build_filter_bank(ResampleFilter filter, int srcSize, int dstSize) {
+    const float radius = filter == ResampleFilter::BICUBIC ? 2.0f : 3.0f;
+    const float ratio = static_cast<float>(srcSize) / dstSize;
+    // widen the kernel when downscaling so it still acts as a low-pass filter
+    const float stretch = std::max(ratio, 1.0f);
+    const float support = radius * stretch;
+
+    FilterBank bank;
+    bank.taps = static_cast<int>(std::ceil(support)) * 2;
+    bank.index.resize(static_cast<size_t>(dstSize) * bank.taps);
+    bank.weight.resize(static_cast<size_t>(dstSize) * bank.taps);
+
+    for (int i = 0; i < dstSize; ++i) {
+        float center = (i + 0.5f) * ratio - 0.5f;
+        int start = static_cast<int>(std::floor(center - support)) + 1;
+        float sum = 0.0f;
+        for (int t = 0; t < bank.taps; ++t) {
+            float d = (start + t - center) / stretch;
+            float w = filter == ResampleFilter::BICUBIC ? bicubic_kernel(d) : lanczos3_kernel(d);
+            bank.index[i * bank.taps + t] = std::min(std::max(start + t, 0), srcSize - 1);
+            bank.weight[i * bank.taps + t] = w;
+            sum += w;
+        }
+        for (int t = 0; t < bank.taps; ++t)
+            bank.weight[i * bank.taps + t] /= sum;
+    }
+    return bank;
+}
+
+PlaneResampler::PlaneResampler(ResampleFilter filter, int srcWidth, int srcHeight, int dstWidth, int dstHeight)
+    : _srcWidth(srcWidth),
+      _srcHeight(srcHeight),
+      _dstWidth(dstWidth),
+      _dstHeight(dstHeight),
+      _horizontal(build_filter_bank(filter, srcWidth, dstWidth)),
+      _vertical(build_filter_bank(filter, srcHeight, dstHeight)) {}
+
+void PlaneResampler::resample(const void* src,
+                              PlaneType srcType,
+                              void* dst,
+                              PlaneType dstType,
+                              float srcMax,
+                              float outScale) const {
+    const size_t srcPixelSize = get_plane_type_size(srcType);
+    const size_t dstPixelSize = get_plane_type_size(dstType);
+#ifdef IVSR_RESAMPLER_X86
+    const bool use_avx2 = cpu_has_avx2();
+#endif
+
+    // horizontal pass: srcHeight x dstWidth intermediate in f32
+    std::vector<float> tmp(static_cast<size_t>(_srcHeight) * _dstWidth);
+#pragma omp parallel
+    {
+        std::vector<float> row(_srcWidth);
+#pragma omp for
+        for (int y = 0; y < _srcHeight; ++y) {
+            load_row_any(static_cast<const char*>(src) + srcPixelSize * _srcWidth * y, srcType, row.data(), _srcWidth);
+            float* out = tmp.data() + static_cast<size_t>(y) * _dstWidth;
+#ifdef IVSR_RESAMPLER_X86
+            if (use_avx2) {
+                horizontal_pass_avx2(row.data(),
+                                     out,
+                                     _dstWidth,
+                                     _horizontal.taps,
+                                     _horizontal.index.data(),
+                                     _horizontal.weight.data());
+                continue;
+            }
+#endif
+            horizontal_pass_ref(row.data(),
+                                out,
+                                _dstWidth,
+                                _horizontal.taps,
+                                _horizontal.index.data(),
+                                _horizontal.weight.data());
+        }
+    }
+
+    // vertical pass straight into the destination plane
+#pragma omp parallel
+    {
+        std::vector<float> acc(_dstWidth);
+        std::vector<const float*> rows(_vertical.taps);
+#pragma omp for
+        for (int y = 0; y < _dstHeight; ++y) {
+            const int* idx = _vertical.index.data() + y * _vertical.taps;
+            const float* w = _vertical.weight.data() + y * _vertical.taps;
+            for (int t = 0; t < _vertical.taps; ++t)
+                rows[t] = tmp.data() + static_cast<size_t>(idx[t]) * _dstWidth;
+#ifdef IVSR_RESAMPLER_X86
+            if (use_avx2)
+                vertical_pass_avx2(rows.data(), w, _vertical.taps, acc.data(), _dstWidth);
+            else
+#endif
+                vertical_pass_ref(rows.data(), w, _vertical.taps, acc.data(), _dstWidth);
+            store_row_any(acc.data(),
+                          static_cast<char*>(dst) + dstPixelSize * _dstWidth * y,
+                          dstType,
+                          _dstWidth,
+                          srcMax,
+                          outScale);
+        }
+    }
+}
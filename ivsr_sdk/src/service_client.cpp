@@ -0,0 +1,414 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+#include "ivsr_service.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "utils.hpp"
+
+using namespace service;
+
+// staging buffers are rounded up so that frames of a slightly different size reuse them
+static const size_t kStagingAlign = 1 << 16;
+
+ServiceClient::~ServiceClient() {
+    close();
+}
+
+IVSRStatus ServiceClient::connect(const std::string& socketPath,
+                                  const ivsr_config_t* configs,
+                                  std::function<void()> notifier,
+                                  std::unique_ptr<ServiceClient>& client) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "for SERVICE_SOCKET=, the path is too long");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0 || ::connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::string log = "can not connect to ivsr_service at " + socketPath + ": " + strerror(errno);
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, log.c_str());
+        if (sock >= 0)
+            ::close(sock);
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    std::unique_ptr<ServiceClient> created(new ServiceClient());
+    created->sock_ = sock;
+    created->notifier_ = std::move(notifier);
+    created->connected_ = true;
+    created->receiver_ = std::thread(&ServiceClient::receive_loop, created.get());
+
+    std::vector<char> blob = serialize_config(configs);
+    if (blob.size() > kMaxPayload) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_CONFIG, "configs are too large for ivsr_service");
+        return IVSRStatus::UNSUPPORTED_CONFIG;
+    }
+    std::vector<char> reply;
+    IVSRStatus status = created->request(MsgType::INIT, blob.data(), blob.size(), &reply);
+    if (status != IVSRStatus::OK)
+        return status;
+    if (reply.size() != sizeof(InitReply)) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "unexpected reply of ivsr_service");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    memcpy(&created->info_, reply.data(), sizeof(InitReply));
+    std::cout << "[INFO] " << "Connected to ivsr_service at " << socketPath << std::endl;
+    client = std::move(created);
+    return IVSRStatus::OK;
+}
+
+bool ServiceClient::send_request(MsgType type, const void* payload, size_t bytes, int fd, Pending* pending, uint64_t& id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!connected_)
+            return false;
+        id = nextId_++;
+        replies_[id];
+        if (pending)
+            pending_[id] = *pending;
+    }
+
+    MsgHeader header = {type, IVSRStatus::OK, id, static_cast<uint32_t>(bytes), 0};
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sent = send_message(sock_, header, payload, fd);
+    }
+    if (!sent) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies_.erase(id);
+        pending_.erase(id);
+    }
+    return sent;
+}
+
+IVSRStatus ServiceClient::wait_reply(uint64_t id, std::vector<char>* reply) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, id]() {
+        return replies_[id].ready || !connected_;
+    });
+    Reply& received = replies_[id];
+    IVSRStatus status = received.ready ? received.status : IVSRStatus::GENERAL_ERROR;
+    if (reply)
+        *reply = std::move(received.payload);
+    replies_.erase(id);
+    return status;
+}
+
+IVSRStatus ServiceClient::request(MsgType type, const void* payload, size_t bytes, std::vector<char>* reply, int fd) {
+    uint64_t id = 0;
+    if (!send_request(type, payload, bytes, fd, nullptr, id)) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "lost the connection to ivsr_service");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    return wait_reply(id, reply);
+}
+
+void ServiceClient::receive_loop() {
+    MsgHeader header;
+    std::vector<char> payload;
+    while (recv_message(sock_, header, payload)) {
+        if (header.type == MsgType::REPLY) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = replies_.find(header.id);
+            if (it != replies_.end()) {
+                it->second.ready = true;
+                it->second.status = static_cast<IVSRStatus>(header.status);
+                it->second.payload = std::move(payload);
+            }
+            cv_.notify_all();
+        } else if (header.type == MsgType::DONE) {
+            Pending finished;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = pending_.find(header.id);
+                if (it == pending_.end())
+                    continue;
+                finished = std::move(it->second);
+                pending_.erase(it);
+            }
+
+            DoneMsg times = {0.0, 0.0};
+            if (payload.size() == sizeof(DoneMsg))
+                memcpy(&times, payload.data(), sizeof(DoneMsg));
+            IVSRStatus status = static_cast<IVSRStatus>(header.status);
+            if (finished.outStaging && status == IVSRStatus::OK)
+                memcpy(finished.output, finished.outStaging->data, finished.outputBytes);
+            release_staging(finished.inStaging);
+            release_staging(finished.outStaging);
+            if (finished.done)
+                finished.done(status, times.queueTime, times.inferTime);
+            if (notifier_)
+                notifier_();
+        }
+    }
+    fail_all();
+}
+
+void ServiceClient::fail_all() {
+    std::unordered_map<uint64_t, Pending> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connected_ && !closing_)
+            ivsr_status_log(IVSRStatus::GENERAL_ERROR, "lost the connection to ivsr_service");
+        connected_ = false;
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            // submissions still waiting for their REPLY fail in submit()
+            auto reply = replies_.find(it->first);
+            if (reply != replies_.end() && !reply->second.ready) {
+                ++it;
+                continue;
+            }
+            failed.emplace(it->first, std::move(it->second));
+            it = pending_.erase(it);
+        }
+        cv_.notify_all();
+    }
+    for (auto& entry : failed) {
+        release_staging(entry.second.inStaging);
+        release_staging(entry.second.outStaging);
+        if (entry.second.done)
+            entry.second.done(IVSRStatus::GENERAL_ERROR, 0.0, 0.0);
+    }
+    if (notifier_ && !failed.empty())
+        notifier_();
+}
+
+ServiceClient::Buffer* ServiceClient::add_buffer(size_t size, bool staging) {
+    int fd = -1;
+    char* data = static_cast<char*>(create_shared_buffer(size, fd));
+    if (data == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "failed to create a shared buffer");
+        return nullptr;
+    }
+
+    std::unique_ptr<Buffer> buffer(new Buffer{0, data, size, staging, staging});
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->id = nextBuffer_++;
+    }
+    AddBufferMsg msg = {buffer->id, 0, size};
+    IVSRStatus status = request(MsgType::ADD_BUFFER, &msg, sizeof(msg), nullptr, fd);
+    // the service keeps its own mapping
+    ::close(fd);
+    if (status != IVSRStatus::OK) {
+        munmap(data, size);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Buffer* added = buffer.get();
+    buffers_[data] = std::move(buffer);
+    return added;
+}
+
+void ServiceClient::remove_buffer(Buffer* buffer) {
+    uint32_t id = buffer->id;
+    request(MsgType::REMOVE_BUFFER, &id, sizeof(id));
+    munmap(buffer->data, buffer->size);
+}
+
+bool ServiceClient::find_ref(const char* data, size_t bytes, BufferRef& ref) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = buffers_.upper_bound(data);
+    if (it == buffers_.begin())
+        return false;
+    --it;
+    const Buffer& buffer = *it->second;
+    if (buffer.staging || data + bytes > buffer.data + buffer.size)
+        return false;
+    ref = {buffer.id, 0, static_cast<uint64_t>(data - buffer.data)};
+    return true;
+}
+
+ServiceClient::Buffer* ServiceClient::acquire_staging(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : buffers_) {
+            Buffer& buffer = *entry.second;
+            if (buffer.staging && !buffer.busy && buffer.size >= bytes) {
+                buffer.busy = true;
+                return &buffer;
+            }
+        }
+    }
+    // one staging buffer per input and output in flight, they are kept until the handle is released
+    return add_buffer((bytes + kStagingAlign - 1) / kStagingAlign * kStagingAlign, true);
+}
+
+void ServiceClient::release_staging(Buffer* buffer) {
+    if (buffer == nullptr)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->busy = false;
+}
+
+IVSRStatus ServiceClient::submit(char* input_data,
+                                 char* output_data,
+                                 const ivsr_task_option_t* option,
+                                 bool blocking,
+                                 DoneFunction done) {
+    if (input_data == nullptr || output_data == nullptr) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_process - input_data or output_data is nullptr");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+
+    SubmitMsg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.kind = blocking ? SubmitKind::BLOCKING : SubmitKind::TRY;
+    if (option) {
+        msg.hasOption = 1;
+        msg.option = *option;
+    }
+
+    Pending pending;
+    pending.done = std::move(done);
+    size_t inputBytes = frame_bytes(info_.inputBytes, info_, option);
+    size_t outputBytes = frame_bytes(info_.outputBytes, info_, option);
+    if (!find_ref(input_data, inputBytes, msg.input)) {
+        pending.inStaging = acquire_staging(inputBytes);
+        if (pending.inStaging == nullptr)
+            return IVSRStatus::GENERAL_ERROR;
+        memcpy(pending.inStaging->data, input_data, inputBytes);
+        msg.input = {pending.inStaging->id, 0, 0};
+    }
+    if (!find_ref(output_data, outputBytes, msg.output)) {
+        pending.outStaging = acquire_staging(outputBytes);
+        if (pending.outStaging == nullptr) {
+            release_staging(pending.inStaging);
+            return IVSRStatus::GENERAL_ERROR;
+        }
+        pending.output = output_data;
+        pending.outputBytes = outputBytes;
+        msg.output = {pending.outStaging->id, 0, 0};
+    }
+
+    uint64_t id = 0;
+    IVSRStatus status = IVSRStatus::GENERAL_ERROR;
+    bool sent = send_request(MsgType::SUBMIT, &msg, sizeof(msg), -1, &pending, id);
+    if (sent)
+        status = wait_reply(id, nullptr);
+    else
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "lost the connection to ivsr_service");
+
+    if (status != IVSRStatus::OK) {
+        // a rejected submission gets no DONE
+        bool owned = !sent;
+        if (sent) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            owned = pending_.erase(id) > 0;
+        }
+        if (owned) {
+            release_staging(pending.inStaging);
+            release_staging(pending.outStaging);
+        }
+    }
+    return status;
+}
+
+IVSRStatus ServiceClient::push_frame(const char* frame) {
+    BufferRef ref;
+    Buffer* staging = nullptr;
+    if (!find_ref(frame, info_.inputBytes, ref)) {
+        staging = acquire_staging(info_.inputBytes);
+        if (staging == nullptr)
+            return IVSRStatus::GENERAL_ERROR;
+        memcpy(staging->data, frame, info_.inputBytes);
+        ref = {staging->id, 0, 0};
+    }
+    // the frame is copied into the window before the reply
+    IVSRStatus status = request(MsgType::PUSH_FRAME, &ref, sizeof(ref));
+    release_staging(staging);
+    return status;
+}
+
+IVSRStatus ServiceClient::get_attr(IVSRAttrKey key, void* value) {
+    size_t bytes = attr_value_bytes(key);
+    if (bytes == 0) {
+        ivsr_status_log(IVSRStatus::UNSUPPORTED_KEY, std::to_string(key).c_str());
+        return IVSRStatus::UNSUPPORTED_KEY;
+    }
+    int32_t attr = key;
+    std::vector<char> reply;
+    IVSRStatus status = request(MsgType::GET_ATTR, &attr, sizeof(attr), &reply);
+    if (status != IVSRStatus::OK)
+        return status;
+    if (reply.size() != bytes) {
+        ivsr_status_log(IVSRStatus::GENERAL_ERROR, "unexpected reply of ivsr_service");
+        return IVSRStatus::GENERAL_ERROR;
+    }
+    memcpy(value, reply.data(), bytes);
+    return IVSRStatus::OK;
+}
+
+void* ServiceClient::alloc(size_t size) {
+    if (size == 0)
+        return nullptr;
+    Buffer* buffer = add_buffer(size, false);
+    return buffer ? buffer->data : nullptr;
+}
+
+IVSRStatus ServiceClient::free(void* data) {
+    std::unique_ptr<Buffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = buffers_.find(static_cast<const char*>(data));
+        if (it == buffers_.end() || it->second->staging) {
+            ivsr_status_log(IVSRStatus::GENERAL_ERROR, "in ivsr_buffer_free - not a buffer of the handle");
+            return IVSRStatus::GENERAL_ERROR;
+        }
+        buffer = std::move(it->second);
+        buffers_.erase(it);
+    }
+    remove_buffer(buffer.get());
+    return IVSRStatus::OK;
+}
+
+IVSRStatus ServiceClient::close() {
+    if (sock_ < 0)
+        return IVSRStatus::OK;
+
+    bool connected;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected = connected_;
+    }
+    IVSRStatus status = connected ? request(MsgType::DEINIT, nullptr, 0) : IVSRStatus::GENERAL_ERROR;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    shutdown(sock_, SHUT_RDWR);
+    if (receiver_.joinable())
+        receiver_.join();
+    ::close(sock_);
+    sock_ = -1;
+
+    // the service unmapped its side at DEINIT
+    for (auto& entry : buffers_)
+        munmap(entry.second->data, entry.second->size);
+    buffers_.clear();
+    return status;
+}
@@ -0,0 +1,228 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+
+#include "ivsr_service.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace service {
+
+static bool is_path_key(IVSRConfigKey key) {
+    return key == IVSRConfigKey::INPUT_MODEL || key == IVSRConfigKey::CUSTOM_LIB ||
+           key == IVSRConfigKey::CLDNN_CONFIG || key == IVSRConfigKey::TRACE_FILE;
+}
+
+static void append(std::vector<char>& blob, const void* data, size_t bytes) {
+    const char* begin = static_cast<const char*>(data);
+    blob.insert(blob.end(), begin, begin + bytes);
+}
+
+std::vector<char> serialize_config(const ivsr_config_t* configs) {
+    std::vector<char> blob;
+    for (; configs != nullptr; configs = configs->next) {
+        if (configs->key == IVSRConfigKey::READY_CALLBACK || configs->key == IVSRConfigKey::SERVICE_SOCKET ||
+            configs->value == nullptr)
+            continue;
+
+        std::string text;
+        const void* value = configs->value;
+        uint32_t bytes = 0;
+        if (configs->key == IVSRConfigKey::INPUT_TENSOR_DESC_SETTING ||
+            configs->key == IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING) {
+            bytes = sizeof(tensor_desc_t);
+        } else {
+            text = static_cast<const char*>(configs->value);
+            char resolved[PATH_MAX];
+            if (is_path_key(configs->key) && !text.empty() && text[0] != '/') {
+                if (realpath(text.c_str(), resolved) != nullptr) {
+                    text = resolved;
+                } else if (getcwd(resolved, sizeof(resolved)) != nullptr) {
+                    text = std::string(resolved) + "/" + text;  // e.g. a trace file which does not exist yet
+                }
+            }
+            value = text.c_str();
+            bytes = static_cast<uint32_t>(text.size() + 1);
+        }
+
+        int32_t key = configs->key;
+        append(blob, &key, sizeof(key));
+        append(blob, &bytes, sizeof(bytes));
+        append(blob, value, bytes);
+    }
+    return blob;
+}
+
+bool deserialize_config(const std::vector<char>& blob, std::vector<ivsr_config_t>& configs) {
+    configs.clear();
+    size_t pos = 0;
+    while (pos < blob.size()) {
+        int32_t key = 0;
+        uint32_t bytes = 0;
+        if (blob.size() - pos < sizeof(key) + sizeof(bytes))
+            return false;
+        memcpy(&key, blob.data() + pos, sizeof(key));
+        memcpy(&bytes, blob.data() + pos + sizeof(key), sizeof(bytes));
+        pos += sizeof(key) + sizeof(bytes);
+        if (blob.size() - pos < bytes || bytes == 0)
+            return false;
+
+        bool desc = key == IVSRConfigKey::INPUT_TENSOR_DESC_SETTING || key == IVSRConfigKey::OUTPUT_TENSOR_DESC_SETTING;
+        if (desc ? bytes != sizeof(tensor_desc_t) : blob[pos + bytes - 1] != '\0')
+            return false;
+        configs.push_back({static_cast<IVSRConfigKey>(key), blob.data() + pos, nullptr});
+        pos += bytes;
+    }
+    for (size_t i = 0; i + 1 < configs.size(); ++i)
+        configs[i].next = &configs[i + 1];
+    return true;
+}
+
+size_t attr_value_bytes(IVSRAttrKey key) {
+    switch (key) {
+    case IVSRAttrKey::INPUT_TENSOR_DESC:
+    case IVSRAttrKey::OUTPUT_TENSOR_DESC:
+        return sizeof(tensor_desc_t);
+    case IVSRAttrKey::NUM_INPUT_FRAMES:
+        return sizeof(int);
+    case IVSRAttrKey::INPUT_DIMS:
+    case IVSRAttrKey::OUTPUT_DIMS:
+    case IVSRAttrKey::DEADLINE_MISSED_NUM:
+    case IVSRAttrKey::INPUT_FRAME_BYTES:
+    case IVSRAttrKey::OUTPUT_FRAME_BYTES:
+        return sizeof(size_t);
+    case IVSRAttrKey::WARMUP_DURATION:
+        return sizeof(double);
+    case IVSRAttrKey::PERF_STATS:
+        return sizeof(ivsr_perf_stats_t);
+    case IVSRAttrKey::MEMORY_USAGE:
+        return sizeof(ivsr_memory_usage_t);
+    case IVSRAttrKey::NUMA_STATS:
+        return sizeof(ivsr_numa_stats_t);
+    default:
+        return 0;
+    }
+}
+
+size_t frame_bytes(size_t resBytes, const InitReply& info, const ivsr_task_option_t* option) {
+    if (!info.dynamicShape || option == nullptr || info.width == 0 || info.height == 0)
+        return resBytes;
+    size_t width = option->width ? option->width : info.width;
+    size_t height = option->height ? option->height : info.height;
+    return resBytes / (static_cast<size_t>(info.width) * info.height) * width * height;
+}
+
+bool send_message(int sock, const MsgHeader& header, const void* payload, int fd) {
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<MsgHeader*>(&header);
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<void*>(payload);
+    iov[1].iov_len = header.payloadBytes;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = header.payloadBytes > 0 ? 2 : 1;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == static_cast<ssize_t>(sizeof(header) + header.payloadBytes);
+}
+
+bool recv_message(int sock, MsgHeader& header, std::vector<char>& payload, int* fd) {
+    if (fd)
+        *fd = -1;
+    payload.resize(kMaxPayload);
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = payload.data();
+    iov[1].iov_len = payload.size();
+
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int passed = -1;
+            memcpy(&passed, CMSG_DATA(cmsg), sizeof(int));
+            if (fd)
+                *fd = passed;
+            else
+                ::close(passed);
+        }
+    }
+
+    if (received < static_cast<ssize_t>(sizeof(header)) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+        header.payloadBytes != received - sizeof(header)) {
+        if (fd && *fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+        return false;
+    }
+    payload.resize(header.payloadBytes);
+    return true;
+}
+
+void* create_shared_buffer(size_t size, int& fd) {
+    fd = memfd_create("ivsr_frame", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return nullptr;
+    // the service maps it too, a resized buffer would fault its accesses
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || fcntl(fd, F_ADD_SEALS, kBufferSeals) != 0) {
+        ::close(fd);
+        fd = -1;
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        return nullptr;
+    }
+    return data;
+}
+
+}  // namespace service
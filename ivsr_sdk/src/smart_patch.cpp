@@ -12,6 +12,8 @@
 * with no express or implied warranties, other than those that are expressly stated in the License.
 *******************************************************************************/
 #include"ivsr_smart_patch.hpp"
+#include"ivsr_cpu_isa.hpp"
+#include"ivsr_numa.hpp"
 #include<cmath>
 #include<stdlib.h>
 #include<unistd.h>
@@ -63,20 +65,19 @@ float* fill_patch(std::vector<int> patchCorners, float* inputBuf, std::vector<in
         return patch_ptr;
     }
     
-    // loop over each pixel
+    // the patches of a frame are as large as the frame, the staging of a large one is written around the caches
+    const CpuKernels& kernels = cpu_kernels();
+    const bool stream = sizeof(float) * B * inp_sB > kStreamBytes;
+    const size_t rowBytes = sizeof(float) * (y1 - y0);
     for(int b = 0; b < B; ++b){
         float * inp_ptr_B = inputBuf + b * inp_sB;
         for(int n = 0; n < N; ++n) {
             float *inp_ptr_N = inp_ptr_B + n * inp_sN;
             for(int c = 0; c < C; ++c){
                 float *inp_ptr_C = inp_ptr_N + c * inp_sC;
-                for (int h = x0; h < x1; ++h) {
-                    float *inp_ptr_H = inp_ptr_C + h * inp_sH;
-                    for(int w = y0; w < y1; ++w) {
-                        *patch_ptr = *(inp_ptr_H + w);
-                        patch_ptr++ ;
-                    }
-                }
+                kernels.copy_rows(patch_ptr, rowBytes, inp_ptr_C + x0 * inp_sH + y0, sizeof(float) * inp_sH,
+                                  rowBytes, x1 - x0, stream);
+                patch_ptr += (x1 - x0) * (y1 - y0);
             }
         }
     }
@@ -86,7 +87,7 @@ float* fill_patch(std::vector<int> patchCorners, float* inputBuf, std::vector<in
 }
 
 void fill_image(std::vector<std::vector<int>> patchCorners, char* imgBuf, \
-    std::vector<int> patchDims, std::vector<int> imgDims, std::vector<char*> patchList){
+    std::vector<int> patchDims, std::vector<int> imgDims, std::vector<char*> patchList, int* pixelCounter){
     int pB = patchDims[0], pN = patchDims[1], pC = patchDims[2], pH = patchDims[3], pW = patchDims[4];
     int iB = imgDims[0], iN = imgDims[1], iC = imgDims[2], iH = imgDims[3], iW = imgDims[4]; // imgDims?
     //int patch_sW = 1;
@@ -102,9 +103,14 @@ void fill_image(std::vector<std::vector<int>> patchCorners, char* imgBuf, \
     int img_sB = iN * iC * iH * iW;
     
     size_t outputpixels = static_cast<size_t>(iB) * iN * iC * iH * iW;
-    int * pixelCounter = new int[outputpixels]();
+    std::unique_ptr<int[]> ownedCounter;
+    if (pixelCounter == nullptr) {
+        ownedCounter.reset(new int[outputpixels]());
+        pixelCounter = ownedCounter.get();
+    }
 
     float * img_ptr =(float *)imgBuf;
+    const CpuKernels& kernels = cpu_kernels();
 
     // for each patch
     for (auto idx = 0u; idx < patchCorners.size(); ++idx){
@@ -128,42 +134,57 @@ void fill_image(std::vector<std::vector<int>> patchCorners, char* imgBuf, \
                         float *img_ptr_H = img_ptr_sH + h * img_sH;
 
                         float * img_ptr_W = img_ptr_H + patchCorner[1]; // start W pointer in image for current patch 
-                        for(int w = 0; w < pW; ++w) {
-                            *img_ptr_W += *(patch_ptr_H + w);
-                            *(pixelCounter + (img_ptr_W - img_ptr)) += 1;
-                            img_ptr_W++;
-                        }
+                        kernels.add(img_ptr_W, patch_ptr_H, pW);
+                        int *counter_ptr_W = pixelCounter + (img_ptr_W - img_ptr);
+                        for(int w = 0; w < pW; ++w)
+                            ++counter_ptr_W[w];
                     }
                 }
             }
         }
     }
 
-    // average each pixel
-    for(size_t id = 0; id < outputpixels; id++){
-        *(img_ptr + id) /= *(pixelCounter + id);
-    }
+    // average each pixel, the image is final and a large one is written around the caches
+    kernels.divide(img_ptr, pixelCounter, 1, outputpixels, sizeof(float) * outputpixels > kStreamBytes);
+}
+
+size_t SmartPatch::stagingBytes(const PatchConfig& config, int frameHeight, int frameWidth) {
+    size_t blocks = static_cast<size_t>(ceil(frameHeight * 1.0 / config.patchHeight)) *
+                    static_cast<size_t>(ceil(frameWidth * 1.0 / config.patchWidth));
+    size_t patchSize = static_cast<size_t>(config.nif) * config.channels * config.patchHeight * config.patchWidth;
+    // overlapping patches cover more than the frame
+    return sizeof(float) * blocks * patchSize * (1 + config.scale * config.scale);
+}
 
-    delete[] pixelCounter;
+size_t SmartPatch::pixelCounterBytes(const PatchConfig& config, int frameHeight, int frameWidth) {
+#ifdef ENABLE_THREADPROCESS
+    // the threaded merge copies patches without averaging
+    return 0;
+#else
+    return sizeof(int) * config.nif * config.channels * frameHeight * config.scale * frameWidth * config.scale;
+#endif
 }
 
-SmartPatch::SmartPatch(PatchConfig config, char* inBuf, char* outBuf, std::vector<int> inputShape, bool flag)
+SmartPatch::SmartPatch(PatchConfig config, char* inBuf, char* outBuf, std::vector<int> inputShape, bool flag,
+                       MemoryAccount* memory, int numaNode)
     :_inputPtr(inBuf),
     _outputPtr(outBuf),
     _inputShape(inputShape),
     _config(config),
-    flag(flag)
+    flag(flag),
+    _memory(memory),
+    _numaNode(numaNode)
     {
         if (flag){
-            size_t inputSize = 1;
-            for( auto shape : _inputShape){
-                inputSize *= shape;
-            }
-            inputSize  = sizeof(float) * inputSize;
+            _stagingBytes = stagingBytes(_config, *(_inputShape.end() - 2), *(_inputShape.end() - 1));
+            size_t inputSize = _stagingBytes / sizeof(float) / (1 + _config.scale * _config.scale);
             _patchInputPtr = new float[inputSize];
+            numa_prefer_memory(_patchInputPtr, inputSize * sizeof(float), _numaNode);
             inputSize  = inputSize * _config.scale * _config.scale;
             _patchOutputPtr = new float[inputSize];
-            
+            numa_prefer_memory(_patchOutputPtr, inputSize * sizeof(float), _numaNode);
+            if (_memory)
+                _memory->add(MemoryKind::PATCH_STAGING, _stagingBytes);
         }
     }
 #ifdef ENABLE_THREADPROCESS
@@ -331,7 +352,13 @@ IBasicVSRStatus SmartPatch::restoreImageFromPatches(){
     std::vector<std::vector<int>> outPatchCoorList = calculatePatchCoordinateList(inferOutHeight, inferOutWidth, outPatchSize, outBlockSize);
 
     // restore image according to patch pointer list and patch coordinate list
-    fill_image(outPatchCoorList,_outputPtr,patchDims,imgDims,_patchOutputPtrList);
+    _pixelCounterBytes = pixelCounterBytes(_config, inputHeight, inputWidth);
+    _outputPixelCount = new int[_pixelCounterBytes / sizeof(int)];
+    numa_prefer_memory(_outputPixelCount, _pixelCounterBytes, _numaNode);
+    memset(_outputPixelCount, 0, _pixelCounterBytes);
+    if (_memory)
+        _memory->add(MemoryKind::PIXEL_COUNTER, _pixelCounterBytes);
+    fill_image(outPatchCoorList,_outputPtr,patchDims,imgDims,_patchOutputPtrList,_outputPixelCount);
 #endif
 
 #ifdef ENABLE_PERF   
@@ -363,4 +390,8 @@ SmartPatch::~SmartPatch(){
         delete[] _outputPixelCount;
         _outputPixelCount = nullptr;
     }
+    if(_memory != nullptr){
+        _memory->release(MemoryKind::PATCH_STAGING, _stagingBytes);
+        _memory->release(MemoryKind::PIXEL_COUNTER, _pixelCounterBytes);
+    }
  }
\ No newline at end of file
@@ -0,0 +1,143 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_strip_patch.hpp"
+#include "ivsr_cpu_isa.hpp"
+#include "ivsr_numa.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Patch corners along one axis, the same as calculatePatchCoordinateList: the overlap is spread evenly
+// and the last patch is aligned to the end of the frame.
+std::vector<int> patch_starts(int size, int patch) {
+    int blocks = (size + patch - 1) / patch;
+    std::vector<int> starts(std::max(blocks, 1), 0);
+    if (blocks < 2)
+        return starts;
+    int inter = (patch * blocks - size) / (blocks - 1);
+    int lastFill = (patch * blocks - size) % (blocks - 1);
+    for (int i = 0; i < blocks; ++i)
+        starts[i] = (patch - inter) * i;
+    starts[blocks - 1] -= lastFill;
+    return starts;
+}
+
+std::vector<int> cover_counts(const std::vector<int>& starts, int patch, int size) {
+    std::vector<int> counts(size, 0);
+    for (int start : starts)
+        for (int i = start; i < start + patch; ++i)
+            ++counts[i];
+    return counts;
+}
+
+}  // namespace
+
+size_t StripPatch::stagingBytes(const PatchConfig& config, int frameHeight, int frameWidth) {
+    (void)frameHeight;
+    size_t columns = (frameWidth + config.patchWidth - 1) / config.patchWidth;
+    size_t patchSize = static_cast<size_t>(config.nif) * config.channels * config.patchHeight * config.patchWidth;
+    return sizeof(float) * 2 * columns * patchSize * (1 + config.scale * config.scale);
+}
+
+StripPatch::StripPatch(const PatchConfig& config, int frameHeight, int frameWidth, MemoryAccount* memory, int numaNode)
+    : _config(config),
+      _planes(config.nif * config.channels),
+      _height(frameHeight),
+      _width(frameWidth),
+      _memory(memory) {
+    const int scale = _config.scale;
+    const int outPatchHeight = _config.patchHeight * scale, outPatchWidth = _config.patchWidth * scale;
+    _rowStarts = patch_starts(_height, _config.patchHeight);
+    _columnStarts = patch_starts(_width, _config.patchWidth);
+    _outRowStarts = patch_starts(_height * scale, outPatchHeight);
+    _outColumnStarts = patch_starts(_width * scale, outPatchWidth);
+    _rowCounts = cover_counts(_outRowStarts, outPatchHeight, _height * scale);
+    _columnCounts = cover_counts(_outColumnStarts, outPatchWidth, _width * scale);
+
+    _inPatchSize = static_cast<size_t>(_planes) * _config.patchHeight * _config.patchWidth;
+    _outPatchSize = _inPatchSize * scale * scale;
+    _stagingBytes = stagingBytes(_config, frameHeight, frameWidth);
+    _staging = new float[_stagingBytes / sizeof(float)];
+    numa_prefer_memory(_staging, _stagingBytes, numaNode);
+    if (_memory)
+        _memory->add(MemoryKind::PATCH_STAGING, _stagingBytes);
+}
+
+StripPatch::~StripPatch() {
+    delete[] _staging;
+    if (_memory)
+        _memory->release(MemoryKind::PATCH_STAGING, _stagingBytes);
+}
+
+char* StripPatch::inputPatch(int row, int column) const {
+    float* slot = _staging + (row % 2) * columns() * (_inPatchSize + _outPatchSize);
+    return reinterpret_cast<char*>(slot + column * _inPatchSize);
+}
+
+char* StripPatch::outputPatch(int row, int column) const {
+    float* slot = _staging + (row % 2) * columns() * (_inPatchSize + _outPatchSize);
+    return reinterpret_cast<char*>(slot + columns() * _inPatchSize + column * _outPatchSize);
+}
+
+void StripPatch::split(int row, const char* input) const {
+    const int patchHeight = _config.patchHeight, patchWidth = _config.patchWidth;
+    const CpuKernels& kernels = cpu_kernels();
+    const float* frame = reinterpret_cast<const float*>(input);
+    for (int column = 0; column < columns(); ++column) {
+        float* patch = reinterpret_cast<float*>(inputPatch(row, column));
+        for (int plane = 0; plane < _planes; ++plane) {
+            const float* src = frame + static_cast<size_t>(plane) * _height * _width +
+                               static_cast<size_t>(_rowStarts[row]) * _width + _columnStarts[column];
+            // the row is inferred next, its patches stay in the caches
+            kernels.copy_rows(patch, patchWidth * sizeof(float), src, _width * sizeof(float),
+                              patchWidth * sizeof(float), patchHeight, false);
+            patch += static_cast<size_t>(patchHeight) * patchWidth;
+        }
+    }
+}
+
+void StripPatch::merge(int row, char* output) const {
+    const int outHeight = _height * _config.scale, outWidth = _width * _config.scale;
+    const int patchHeight = _config.patchHeight * _config.scale, patchWidth = _config.patchWidth * _config.scale;
+    const int top = _outRowStarts[row];
+    // rows the previous patch row wrote already, and rows the next one adds to
+    const int written = row > 0 ? _outRowStarts[row - 1] + patchHeight : 0;
+    const int next = row + 1 < rows() ? _outRowStarts[row + 1] : outHeight;
+
+    const CpuKernels& kernels = cpu_kernels();
+    // averaged rows are final, a large output frame is written around the caches
+    const bool stream = sizeof(float) * _planes * outHeight * outWidth > kStreamBytes;
+    float* frame = reinterpret_cast<float*>(output);
+    for (int plane = 0; plane < _planes; ++plane) {
+        float* dst = frame + static_cast<size_t>(plane) * outHeight * outWidth;
+        for (int y = std::max(top, written); y < top + patchHeight; ++y)
+            memset(dst + static_cast<size_t>(y) * outWidth, 0, outWidth * sizeof(float));
+
+        for (int column = 0; column < columns(); ++column) {
+            const float* src = reinterpret_cast<const float*>(outputPatch(row, column)) +
+                               static_cast<size_t>(plane) * patchHeight * patchWidth;
+            for (int h = 0; h < patchHeight; ++h) {
+                kernels.add(dst + static_cast<size_t>(top + h) * outWidth + _outColumnStarts[column], src, patchWidth);
+                src += patchWidth;
+            }
+        }
+
+        // average the rows which are complete
+        for (int y = top; y < next; ++y)
+            kernels.divide(dst + static_cast<size_t>(y) * outWidth, _columnCounts.data(), _rowCounts[y], outWidth,
+                           stream);
+    }
+}
@@ -0,0 +1,248 @@
+/********************************************************************************
+* INTEL CONFIDENTIAL
+* Copyright (C) 2024 Intel Corporation
+*
+* This software and the related documents are Intel copyrighted materials,
+* and your use of them is governed by the express license under
+* which they were provided to you ("License").Unless the License
+* provides otherwise, you may not use, modify, copy, publish, distribute, disclose or
+* transmit this software or the related documents without Intel's prior written permission.
+*
+* This software and the related documents are provided as is,
+* with no express or implied warranties, other than those that are expressly stated in the License.
+*******************************************************************************/
+#include "ivsr_tracer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t start;  // ns since the clock epoch
+    int64_t duration;
+    int64_t frame;
+    int32_t patch;
+    int32_t request;
+};
+
+constexpr size_t kChunkEvents = 4096;
+constexpr size_t kMaxChunks = 256;  // about 1M spans per thread and session, later spans are dropped
+
+// Only the owning thread appends; an event is visible to the writer once count is published.
+struct ThreadBuffer {
+    explicit ThreadBuffer(int id) : tid(id) {
+        for (auto& chunk : chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~ThreadBuffer() {
+        for (auto& chunk : chunks)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    int tid;
+    std::atomic<bool> exited{false};  // the thread is gone, the buffer is freed or reused once it is written
+    std::atomic<uint64_t> session{0};
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<TraceEvent*> chunks[kMaxChunks];
+};
+
+struct TraceState {
+    std::mutex mutex;  // registration of new threads and session start/stop, never taken per span
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    int next_tid = 1;
+    std::atomic<uint64_t> session{0};
+    std::string path;
+    int users = 0;
+    Time::time_point origin;
+};
+
+// intentionally leaked, thread-local buffers may be used while static objects are destroyed
+TraceState& state() {
+    static TraceState* s = new TraceState();
+    return *s;
+}
+
+thread_local ThreadBuffer* tls_buffer = nullptr;
+
+// marks the buffer at thread exit, e.g. of the executor threads of a de-initialized handle
+struct BufferOwner {
+    ThreadBuffer* buffer = nullptr;
+
+    ~BufferOwner() {
+        if (buffer)
+            buffer->exited.store(true, std::memory_order_release);
+    }
+};
+thread_local BufferOwner tls_owner;
+
+ThreadBuffer* local_buffer() {
+    if (!tls_buffer) {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        // spans of a previous session are written already, an exited thread's buffer of one is reused
+        const uint64_t session = s.session.load(std::memory_order_relaxed);
+        for (auto& buffer : s.buffers) {
+            if (buffer->exited.load(std::memory_order_acquire) &&
+                buffer->session.load(std::memory_order_relaxed) != session) {
+                buffer->exited.store(false, std::memory_order_relaxed);
+                tls_buffer = buffer.get();
+                break;
+            }
+        }
+        if (!tls_buffer) {
+            s.buffers.emplace_back(new ThreadBuffer(s.next_tid++));
+            tls_buffer = s.buffers.back().get();
+        }
+        tls_owner.buffer = tls_buffer;
+    }
+    return tls_buffer;
+}
+
+int64_t to_ns(Time::time_point t) {
+    return std::chrono::duration_cast<ns>(t.time_since_epoch()).count();
+}
+
+void write_trace(TraceState& s, uint64_t session) {
+    FILE* fp = fopen(s.path.c_str(), "w");
+    if (!fp) {
+        std::cout << "[ERROR]: " << "failed to open trace file " << s.path << std::endl;
+        return;
+    }
+
+    const int64_t origin = to_ns(s.origin);
+    const int pid = static_cast<int>(getpid());
+    size_t total = 0, dropped = 0;
+    bool first = true;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (auto& buffer : s.buffers) {
+        if (buffer->session.load(std::memory_order_acquire) != session)
+            continue;
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent& e = buffer->chunks[i / kChunkEvents].load(std::memory_order_relaxed)[i % kChunkEvents];
+            fprintf(fp,
+                    "%s{\"name\":\"%s\",\"cat\":\"ivsr\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"frame\":%lld,\"patch\":%d,\"request\":%d}}",
+                    first ? "" : ",\n",
+                    e.name,
+                    pid,
+                    buffer->tid,
+                    (e.start - origin) * 0.001,
+                    e.duration * 0.001,
+                    static_cast<long long>(e.frame),
+                    e.patch,
+                    e.request);
+            first = false;
+        }
+        total += count;
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    std::cout << "[INFO] " << "Trace: " << total << " span(s) written to " << s.path;
+    if (dropped)
+        std::cout << ", " << dropped << " dropped";
+    std::cout << std::endl;
+}
+
+// called once the session is written, the threads of exited buffers record no more spans
+void free_exited_buffers(TraceState& s) {
+    s.buffers.erase(std::remove_if(s.buffers.begin(), s.buffers.end(),
+                                   [](const std::unique_ptr<ThreadBuffer>& buffer) {
+                                       return buffer->exited.load(std::memory_order_acquire);
+                                   }),
+                    s.buffers.end());
+}
+
+// flush a session whose handles were never released
+struct FlushAtExit {
+    ~FlushAtExit() {
+        Tracer::release_all();
+    }
+};
+
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+
+bool Tracer::acquire(const std::string& path) {
+    static FlushAtExit flush_at_exit;
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.users > 0) {
+        if (path != s.path)
+            std::cout << "[WARNING]: " << "tracing into " << s.path << " already, " << path << " is ignored."
+                      << std::endl;
+        ++s.users;
+        return true;
+    }
+
+    s.path = path;
+    s.origin = Time::now();
+    s.users = 1;
+    s.session.fetch_add(1, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void Tracer::release() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.users == 0 || --s.users > 0)
+        return;
+    enabled_.store(false, std::memory_order_relaxed);
+    write_trace(s, s.session.load(std::memory_order_relaxed));
+    free_exited_buffers(s);
+}
+
+void Tracer::release_all() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.users == 0)
+        return;
+    s.users = 0;
+    enabled_.store(false, std::memory_order_relaxed);
+    write_trace(s, s.session.load(std::memory_order_relaxed));
+    free_exited_buffers(s);
+}
+
+void Tracer::record(const char* name,
+                    Time::time_point start,
+                    Time::time_point end,
+                    int64_t frame,
+                    int32_t patch,
+                    int32_t request) {
+    if (!enabled())
+        return;
+
+    ThreadBuffer* buffer = local_buffer();
+    // the first span of a new session recycles the buffer of the previous one
+    uint64_t session = state().session.load(std::memory_order_relaxed);
+    if (buffer->session.load(std::memory_order_relaxed) != session) {
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->session.store(session, std::memory_order_release);
+    }
+
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    size_t chunk_index = index / kChunkEvents;
+    if (chunk_index >= kMaxChunks) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent* chunk = buffer->chunks[chunk_index].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new TraceEvent[kChunkEvents];
+        buffer->chunks[chunk_index].store(chunk, std::memory_order_relaxed);
+    }
+
+    chunk[index % kChunkEvents] = {name, to_ns(start), to_ns(end) - to_ns(start), frame, patch, request};
+    buffer->count.store(index + 1, std::memory_order_release);
+}